@@ -89,13 +89,10 @@ void loop() {
     count = 0;
   }
   // "sleep"!
-  using Unit = LoomNet::TimeInterval::Unit;
-  const LoomNet::TimeInterval& sleep(network.net_sleep_next_wake_time());
+  const LoomNet::TimeTicks sleep(network.net_sleep_next_wake_time());
   Serial.print("Sleep: ");
-  Serial.print(sleep.get_unit());
-  Serial.print(", ");
-  Serial.println(sleep.get_time());
-  if (sleep.get_time() != 0) {
+  Serial.println(static_cast<uint32_t>(sleep.get_ticks() / 1000));
+  if (!sleep.is_none()) {
     while(network.get_radio().get_time() < sleep);
   }
   // wake!
@@ -14,7 +14,7 @@ void setup() {
 
 void loop() {
   // put your main code here, to run repeatedly:
-  LoomNet::TimeInterval none(LoomNet::TIME_NONE);
+  LoomNet::TimeTicks none(LoomNet::TICKS_NONE);
   const LoomNet::Packet thing = recv_radio.recv(none);
   if (thing.get_control() != LoomNet::PacketCtrl::NONE) {
     for (uint8_t i = 0; i < thing.get_raw_length(); i++) {
@@ -0,0 +1,50 @@
+// LoomNetworkBlob.cpp : Compiles a network topology JSON into a blob for read_network_blob.
+//
+
+#include "../../../src/LoomNetworkConfig.h"
+#include "../../../src/LoomNetworkBlob.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		std::cerr << "Usage: " << argv[0] << " <topology.json> <network.blob>" << std::endl;
+		return 1;
+	}
+	std::ifstream in(argv[1]);
+	if (!in) {
+		std::cerr << "Could not open " << argv[1] << std::endl;
+		return 1;
+	}
+	std::stringstream text;
+	text << in.rdbuf();
+	const std::string str = text.str();
+	DynamicJsonDocument json(str.size() * 4 + 1024);
+	const DeserializationError err = deserializeJson(json, str);
+	if (err) {
+		std::cerr << "Could not parse " << argv[1] << ": " << err.c_str() << std::endl;
+		return 1;
+	}
+	std::vector<LoomNet::DeviceInfo> table(LoomNet::MAX_DEVICES);
+	const LoomNet::NetworkTopology topology(json.as<JsonObjectConst>(), table.data(), static_cast<uint16_t>(table.size()));
+	if (!topology.is_valid()) {
+		std::cerr << "Invalid network topology in " << argv[1] << std::endl;
+		return 1;
+	}
+	std::vector<uint8_t> blob(LoomNet::BlobReader::get_size(topology.get_device_count()));
+	const uint32_t size = topology.write_blob(blob.data(), static_cast<uint32_t>(blob.size()));
+	if (size == 0) {
+		std::cerr << "Network topology too large for a blob" << std::endl;
+		return 1;
+	}
+	std::ofstream out(argv[2], std::ios::binary);
+	out.write(reinterpret_cast<const char*>(blob.data()), size);
+	if (!out) {
+		std::cerr << "Could not write " << argv[2] << std::endl;
+		return 1;
+	}
+	std::cout << "Wrote " << topology.get_device_count() << " devices in " << size << " bytes to " << argv[2] << std::endl;
+	return 0;
+}
\ No newline at end of file
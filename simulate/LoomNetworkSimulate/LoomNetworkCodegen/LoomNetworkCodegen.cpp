@@ -0,0 +1,145 @@
+// LoomNetworkCodegen.cpp : Compiles a network topology JSON into a header of constexpr NetworkInfo, one per device.
+//
+
+#include "../../../src/LoomNetworkConfig.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <set>
+#include <cctype>
+
+static const char* const TYPE_NAMES[] = { "END_DEVICE", "COORDINATOR", "FIRST_ROUTER", "SECOND_ROUTER", "ERROR" };
+static const char* const UNIT_NAMES[] = { "MICROSECOND", "MILLISECOND", "SECOND", "MINUTE", "HOUR", "DAY", "NONE" };
+
+// turn a device name into an upper case identifier, unique in the header
+static std::string to_identifier(const LoomNet::DeviceInfo& device, std::set<std::string>& used) {
+	std::string id;
+	for (const char* c = device.name; *c; c++) {
+		if (std::isalnum(static_cast<unsigned char>(*c))) id += static_cast<char>(std::toupper(static_cast<unsigned char>(*c)));
+		else if (!id.empty() && id.back() != '_') id += '_';
+	}
+	while (!id.empty() && id.back() == '_') id.pop_back();
+	if (id.empty() || std::isdigit(static_cast<unsigned char>(id.front()))) id = "DEVICE_" + id;
+	if (used.count(id)) {
+		std::stringstream addr;
+		addr << id << "_" << std::hex << std::uppercase << device.address;
+		id = addr.str();
+	}
+	used.insert(id);
+	return id;
+}
+
+// device names end up in comments and string literals
+static std::string to_printable(const char* name, const bool literal) {
+	std::string str;
+	for (const char* c = name; *c; c++) {
+		if (!std::isprint(static_cast<unsigned char>(*c))) str += '?';
+		else if (literal && (*c == '"' || *c == '\\')) str += std::string("\\") + *c;
+		else str += *c;
+	}
+	return str;
+}
+
+static std::string to_string(const LoomNet::TimeInterval& time) {
+	std::stringstream str;
+	str << "LoomNet::TimeInterval(LoomNet::TimeInterval::" << UNIT_NAMES[time.get_unit()] << ", " << time.get_time() << ")";
+	return str.str();
+}
+
+static void write_info(std::ostream& out, const std::string& id, const LoomNet::DeviceInfo& device, const LoomNet::NetworkInfo& info) {
+	const LoomNet::Router& route = info.route_info;
+	const LoomNet::Slotter& slot = info.slot_info;
+	const LoomNet::Drift& drift = info.drift_info;
+	const LoomNet::BatchTuner& batch = info.batch_info;
+	out << "\t// " << to_printable(device.name, false) << "\n"
+		<< "\tconstexpr LoomNet::NetworkInfo " << id << " = {\n"
+		<< "\t\tLoomNet::Router(LoomNet::DeviceType::" << TYPE_NAMES[static_cast<int>(route.get_device_type())]
+		<< std::hex << std::uppercase << std::setfill('0')
+		<< ", 0x" << std::setw(4) << route.get_self_addr()
+		<< ", 0x" << std::setw(4) << route.get_addr_parent()
+		<< std::dec << std::setfill(' ')
+		<< ", " << +route.get_router_count()
+		<< ", " << +route.get_node_count() << "),\n"
+		<< "\t\tLoomNet::Slotter(" << +slot.get_send_slot()
+		<< ", " << +slot.get_total_slots()
+		<< ", " << +slot.get_cycles_per_refresh()
+		<< ", " << +slot.get_cycle_gap()
+		<< ", " << +slot.get_batch_gap()
+		<< ", " << +slot.get_send_count()
+		<< ", " << +slot.get_recv_slot()
+		<< ", " << +slot.get_recv_count() << "),\n"
+		<< "\t\tLoomNet::Drift(\n"
+		<< "\t\t\t" << to_string(drift.min_drift) << ",\n"
+		<< "\t\t\t" << to_string(drift.max_drift) << ",\n"
+		<< "\t\t\t" << to_string(drift.slot_length) << "),\n";
+	if (batch.is_enabled()) {
+		out << "\t\tLoomNet::BatchTuner(" << +batch.get_min_cycles()
+			<< ", " << +batch.get_max_cycles()
+			<< ", " << +batch.get_min_cycle_gap()
+			<< ", " << +batch.get_max_cycle_gap()
+			<< ", " << +batch.get_min_batch_gap()
+			<< ", " << +batch.get_max_batch_gap()
+			<< ", " << +batch.get_hold() << ")\n";
+	}
+	else out << "\t\tLoomNet::BATCH_FIXED\n";
+	out << "\t};\n"
+		<< "\tstatic_assert(" << id << ".route_info.get_self_addr() != LoomNet::ADDR_ERROR && "
+		<< id << ".slot_info.get_total_slots() != LoomNet::SLOT_ERROR, \"invalid network configuration for " << to_printable(device.name, true) << "\");\n";
+}
+
+int main(int argc, char** argv) {
+	if (argc != 3 && argc != 4) {
+		std::cerr << "Usage: " << argv[0] << " <topology.json> <header.h> [namespace]" << std::endl;
+		return 1;
+	}
+	const std::string space = argc == 4 ? argv[3] : "LoomNetTopology";
+	std::ifstream in(argv[1]);
+	if (!in) {
+		std::cerr << "Could not open " << argv[1] << std::endl;
+		return 1;
+	}
+	std::stringstream text;
+	text << in.rdbuf();
+	const std::string str = text.str();
+	DynamicJsonDocument json(str.size() * 4 + 1024);
+	const DeserializationError err = deserializeJson(json, str);
+	if (err) {
+		std::cerr << "Could not parse " << argv[1] << ": " << err.c_str() << std::endl;
+		return 1;
+	}
+	std::vector<LoomNet::DeviceInfo> table(LoomNet::MAX_DEVICES);
+	const LoomNet::NetworkTopology topology(json.as<JsonObjectConst>(), table.data(), static_cast<uint16_t>(table.size()));
+	if (!topology.is_valid()) {
+		// no header at all, so the firmware build fails instead of the device
+		std::cerr << "Invalid network topology in " << argv[1] << std::endl;
+		return 1;
+	}
+	std::stringstream out;
+	out << "#pragma once\n"
+		<< "#include \"LoomNetworkInfo.h\"\n"
+		<< "\n"
+		<< "/**\n"
+		<< " * Network configuration for every device in " << argv[1] << "\n"
+		<< " * Generated by LoomNetworkCodegen, do not edit\n"
+		<< " */\n"
+		<< "\n"
+		<< "namespace " << space << " {\n";
+	std::set<std::string> used;
+	for (uint16_t i = 0; i < topology.get_device_count(); i++) {
+		const LoomNet::DeviceInfo& device = topology.get_device(i);
+		if (i) out << "\n";
+		write_info(out, to_identifier(device, used), device, topology.get_info(device));
+	}
+	out << "}";
+	std::ofstream file(argv[2]);
+	file << out.str();
+	if (!file) {
+		std::cerr << "Could not write " << argv[2] << std::endl;
+		return 1;
+	}
+	std::cout << "Wrote " << topology.get_device_count() << " devices to " << argv[2] << std::endl;
+	return 0;
+}
\ No newline at end of file
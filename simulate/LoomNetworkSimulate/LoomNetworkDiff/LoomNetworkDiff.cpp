@@ -0,0 +1,108 @@
+// LoomNetworkDiff.cpp : Compares two versions of a network topology JSON, listing the devices that need to be reflashed.
+//
+
+#include "../../../src/LoomNetworkConfig.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+
+static bool load(const char* path, DynamicJsonDocument& json) {
+	std::ifstream in(path);
+	if (!in) {
+		std::cerr << "Could not open " << path << std::endl;
+		return false;
+	}
+	std::stringstream text;
+	text << in.rdbuf();
+	const DeserializationError err = deserializeJson(json, text.str());
+	if (err) {
+		std::cerr << "Could not parse " << path << ": " << err.c_str() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static std::string hex(const uint16_t value) {
+	std::stringstream out;
+	out << "0x" << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << value;
+	return out.str();
+}
+
+// "name before -> after", or nothing if it didn't change
+template<class T>
+static void print_field(const char* name, const T before, const T after) {
+	if (before != after) std::cout << " " << name << " " << before << " -> " << after;
+}
+
+static void print_change(const LoomNet::NetworkInfo& before, const LoomNet::NetworkInfo& after, const uint8_t change) {
+	using namespace LoomNet;
+	if (change & CHANGE_ROUTE) {
+		std::cout << "\n\troute:";
+		print_field("address", hex(before.route_info.get_self_addr()), hex(after.route_info.get_self_addr()));
+		print_field("parent", hex(before.route_info.get_addr_parent()), hex(after.route_info.get_addr_parent()));
+		print_field("routers", +before.route_info.get_router_count(), +after.route_info.get_router_count());
+		print_field("end devices", +before.route_info.get_node_count(), +after.route_info.get_node_count());
+	}
+	if (change & CHANGE_SLOT) {
+		std::cout << "\n\tslots:";
+		print_field("send", +before.slot_info.get_send_slot(), +after.slot_info.get_send_slot());
+		print_field("send count", +before.slot_info.get_send_count(), +after.slot_info.get_send_count());
+		print_field("recv", +before.slot_info.get_recv_slot(), +after.slot_info.get_recv_slot());
+		print_field("recv count", +before.slot_info.get_recv_count(), +after.slot_info.get_recv_count());
+		print_field("total", +before.slot_info.get_total_slots(), +after.slot_info.get_total_slots());
+		print_field("cycles", +before.slot_info.get_cycles_per_refresh(), +after.slot_info.get_cycles_per_refresh());
+		print_field("cycle gap", +before.slot_info.get_cycle_gap(), +after.slot_info.get_cycle_gap());
+		print_field("batch gap", +before.slot_info.get_batch_gap(), +after.slot_info.get_batch_gap());
+	}
+	if (change & CHANGE_DRIFT) std::cout << "\n\tdrift";
+	if (change & CHANGE_BATCH) std::cout << "\n\tbatch tuning";
+	std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		std::cerr << "Usage: " << argv[0] << " <before.json> <after.json>" << std::endl;
+		return 2;
+	}
+	DynamicJsonDocument before_json(1 << 20);
+	DynamicJsonDocument after_json(1 << 20);
+	if (!load(argv[1], before_json) || !load(argv[2], after_json)) return 2;
+	// both are compiled in full, a single pass is cheap enough that there's nothing to gain from patching
+	std::vector<LoomNet::DeviceInfo> before_table(LoomNet::MAX_DEVICES);
+	std::vector<LoomNet::DeviceInfo> after_table(LoomNet::MAX_DEVICES);
+	const LoomNet::NetworkTopology before(before_json.as<JsonObjectConst>(), before_table.data(), LoomNet::MAX_DEVICES);
+	const LoomNet::NetworkTopology after(after_json.as<JsonObjectConst>(), after_table.data(), LoomNet::MAX_DEVICES);
+	if (!before.is_valid() || !after.is_valid()) {
+		std::cerr << "Invalid network topology in " << (before.is_valid() ? argv[2] : argv[1]) << std::endl;
+		return 2;
+	}
+	uint16_t changed = 0;
+	uint16_t added = 0;
+	uint16_t removed = 0;
+	for (uint16_t i = 0; i < after.get_device_count(); i++) {
+		const LoomNet::DeviceInfo& device = after.get_device(i);
+		const uint8_t change = after.compare(device, before);
+		if (change == LoomNet::CHANGE_NONE) continue;
+		if (change == LoomNet::CHANGE_ADDED) {
+			std::cout << device.name << ": added at " << hex(device.address) << std::endl;
+			added++;
+			continue;
+		}
+		std::cout << device.name << ":";
+		print_change(before.get_info(*before.find(device.name)), after.get_info(device), change);
+		changed++;
+	}
+	for (uint16_t i = 0; i < before.get_device_count(); i++) {
+		const LoomNet::DeviceInfo& device = before.get_device(i);
+		if (after.find(device.name)) continue;
+		std::cout << device.name << ": removed from " << hex(device.address) << std::endl;
+		removed++;
+	}
+	std::cout << changed << " of " << before.get_device_count() - removed << " existing devices changed, "
+		<< added << " added, " << removed << " removed" << std::endl;
+	// scripts can tell if anything already deployed has to be reflashed
+	return changed ? 1 : 0;
+}
\ No newline at end of file
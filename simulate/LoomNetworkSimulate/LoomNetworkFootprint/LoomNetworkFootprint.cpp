@@ -0,0 +1,57 @@
+// LoomNetworkFootprint.cpp : Prints how much RAM each layer of the network stack takes, for each build of it.
+//
+
+#include "../../../src/LoomNetwork.h"
+#include <iostream>
+#include <iomanip>
+
+using namespace LoomNet;
+
+// sizes are all known while compiling, so the radio only has to be declared, and takes nothing itself
+struct NoRadio : public RadioBase {};
+
+static void print_size(const char* name, const size_t size) {
+	std::cout << "  " << std::left << std::setw(64) << name << std::right << std::setw(6) << size << std::endl;
+}
+
+#define PRINT_SIZE(...) print_size(#__VA_ARGS__, sizeof(__VA_ARGS__))
+
+template<size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer>
+static void print_buffers() {
+	using Net = Network<NoRadio, send_buffer, recv_buffer, fingerprint_buffer>;
+	std::cout << "Buffers of " << send_buffer << " sends, " << recv_buffer << " recieves and " << fingerprint_buffer << " fingerprints:" << std::endl;
+	print_size("packet pool", sizeof(typename Net::Pool));
+	print_size("send queue", sizeof(FifoSendQueue<typename Net::PacketWithDst, send_buffer>));
+	print_size("recieve buffer", sizeof(CircularBuffer<typename Net::Handle, recv_buffer>));
+	print_size("dedup", sizeof(FingerprintDedup<fingerprint_buffer>));
+	print_size("Network", sizeof(Net));
+}
+
+int main() {
+	std::cout << "Each part:" << std::endl;
+	PRINT_SIZE(Packet);
+	PRINT_SIZE(PacketFingerprint);
+	PRINT_SIZE(Network<NoRadio>::PacketWithDst);
+	PRINT_SIZE(TimeTicks);
+	PRINT_SIZE(Slotter);
+	PRINT_SIZE(BatchTuner);
+	PRINT_SIZE(Router);
+	std::cout << "MAC for each role:" << std::endl;
+	PRINT_SIZE(BasicMAC<NoRadio>);
+	PRINT_SIZE(BasicMAC<NoRadio, EndDeviceRole>);
+	PRINT_SIZE(BasicMAC<NoRadio, RouterRole>);
+	PRINT_SIZE(BasicMAC<NoRadio, CoordinatorRole>);
+	std::cout << "Network for each role:" << std::endl;
+	PRINT_SIZE(Network<NoRadio>);
+	PRINT_SIZE(EndDeviceNetwork<NoRadio>);
+	PRINT_SIZE(RouterNetwork<NoRadio>);
+	PRINT_SIZE(CoordinatorNetwork<NoRadio>);
+	std::cout << "Network with other policies:" << std::endl;
+	PRINT_SIZE(Network<NoRadio, 18, 18, 32, AnyRole, NewestSendQueue>);
+	PRINT_SIZE(Network<NoRadio, 18, 18, 32, AnyRole, FifoSendQueue, NoDedup>);
+	print_buffers<4, 4, 8>();
+	print_buffers<16, 16, 32>();
+	print_buffers<18, 18, 32>();
+	print_buffers<32, 32, 64>();
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+// LoomNetworkMedium.cpp : Relays frames between SocketRadios sharing a directory, adding loss, latency and collisions.
+//
+
+#include "../../../src/Radios/SocketRadio.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+
+using Clock = std::chrono::steady_clock;
+
+struct Frame {
+	Clock::time_point arrival;
+	Clock::time_point deliver;
+	std::string from;
+	std::vector<uint8_t> data;
+	bool lost;
+	bool collided;
+};
+
+static volatile std::sig_atomic_t stop = 0;
+
+static void on_signal(int) { stop = 1; }
+
+// every device in the directory except the one that sent the frame
+static size_t broadcast(const int fd, const std::string& dir, const Frame& frame) {
+	DIR* list = opendir(dir.c_str());
+	if (!list) return 0;
+	const std::string suffix(LoomNet::SocketRadio::NODE_SUFFIX);
+	size_t count = 0;
+	for (const dirent* entry = readdir(list); entry; entry = readdir(list)) {
+		const std::string name(entry->d_name);
+		if (name.size() <= suffix.size() || name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) continue;
+		const std::string path = dir + "/" + name;
+		if (path == frame.from || path.size() >= sizeof(sockaddr_un::sun_path)) continue;
+		sockaddr_un addr{};
+		addr.sun_family = AF_UNIX;
+		strcpy(addr.sun_path, path.c_str());
+		if (sendto(fd, frame.data.data(), frame.data.size(), MSG_DONTWAIT, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) >= 0)
+			count++;
+	}
+	closedir(list);
+	return count;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2 || argc > 6) {
+		std::cerr << "Usage: " << argv[0] << " <dir> [loss percent] [latency us] [jitter us] [collision window us]" << std::endl;
+		return 2;
+	}
+	const std::string dir(argv[1]);
+	const int loss = argc > 2 ? std::atoi(argv[2]) : 0;
+	const std::chrono::microseconds latency(argc > 3 ? std::atol(argv[3]) : 0);
+	const long jitter = argc > 4 ? std::atol(argv[4]) : 0;
+	const std::chrono::microseconds collision(argc > 5 ? std::atol(argv[5]) : 0);
+	if (loss < 0 || loss > 100 || latency.count() < 0 || jitter < 0 || collision.count() < 0) {
+		std::cerr << "Loss must be a percentage, and times can't be negative" << std::endl;
+		return 2;
+	}
+	const std::string path = dir + "/" + LoomNet::SocketRadio::MEDIUM_NAME;
+	sockaddr_un addr{};
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path)) {
+		std::cerr << "Directory path is too long for a socket" << std::endl;
+		return 2;
+	}
+	strcpy(addr.sun_path, path.c_str());
+	const int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+	unlink(path.c_str());
+	if (fd < 0 || bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+		std::cerr << "Could not bind " << path << std::endl;
+		return 2;
+	}
+	std::signal(SIGINT, on_signal);
+	std::signal(SIGTERM, on_signal);
+	std::cout << "Relaying in " << dir << " with " << loss << "% loss, " << latency.count() << "us latency, "
+		<< jitter << "us jitter, " << collision.count() << "us collision window" << std::endl;
+
+	std::default_random_engine rand(std::random_device{}());
+	std::vector<Frame> pending;
+	size_t heard = 0, delivered = 0, lost = 0, collided = 0;
+	while (!stop) {
+		// sleep until the next frame is due, or something new shows up
+		Clock::time_point now = Clock::now();
+		std::chrono::microseconds wait(100000);
+		for (const Frame& frame : pending)
+			wait = std::min(wait, std::max(std::chrono::microseconds(0), std::chrono::duration_cast<std::chrono::microseconds>(frame.deliver - now)));
+		pollfd ready = { fd, POLLIN, 0 };
+		const timespec timeout = { static_cast<time_t>(wait.count() / 1000000), static_cast<long>(wait.count() % 1000000) * 1000 };
+		if (ppoll(&ready, 1, &timeout, nullptr) > 0) {
+			uint8_t buf[LoomNet::PACKET_MAX];
+			sockaddr_un from{};
+			socklen_t from_length = sizeof(from);
+			const ssize_t length = recvfrom(fd, buf, sizeof(buf), MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&from), &from_length);
+			if (length > 0) {
+				now = Clock::now();
+				Frame frame{ now, now + latency, from.sun_path, std::vector<uint8_t>(buf, buf + length), false, false };
+				if (jitter) frame.deliver += std::chrono::microseconds(std::uniform_int_distribution<long>(0, jitter)(rand));
+				// hold it at least as long as the window, so anything that overlaps it shows up first
+				if (frame.deliver < now + collision) frame.deliver = now + collision;
+				frame.lost = loss && std::uniform_int_distribution<int>(0, 99)(rand) < loss;
+				// two devices talking over each other means neither is heard
+				for (Frame& other : pending) {
+					if (other.from != frame.from && frame.arrival - other.arrival < collision)
+						other.collided = frame.collided = true;
+				}
+				pending.push_back(frame);
+				heard++;
+			}
+		}
+		// deliver everything that's due
+		now = Clock::now();
+		for (auto iter = pending.begin(); iter != pending.end();) {
+			if (iter->deliver > now) {
+				++iter;
+				continue;
+			}
+			if (iter->collided) collided++;
+			else if (iter->lost) lost++;
+			else delivered += broadcast(fd, dir, *iter);
+			iter = pending.erase(iter);
+		}
+	}
+	close(fd);
+	unlink(path.c_str());
+	std::cout << "Heard " << heard << " frames: " << lost << " lost, " << collided << " collided, "
+		<< delivered << " deliveries" << std::endl;
+	return 0;
+}
\ No newline at end of file
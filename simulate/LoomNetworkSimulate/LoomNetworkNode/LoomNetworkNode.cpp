@@ -0,0 +1,151 @@
+// LoomNetworkNode.cpp : Runs devices from a network topology JSON over SocketRadio, one per process or one per thread.
+//
+
+#include "../../../src/LoomNetwork.h"
+#include "../../../src/Radios/SocketRadio.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+
+using NetType = LoomNet::Network<LoomNet::SocketRadio, 16, 16, 128>;
+using NetStatus = NetType::Status;
+
+// every device but the coordinator sends it a packet this often, in wakes
+constexpr auto SEND_EVERY = 4;
+
+struct NodeResult {
+	size_t sent;
+	size_t received;
+	bool closed;
+};
+
+static std::atomic<bool> stop(false);
+static std::mutex print_lock;
+
+static void on_signal(int) { stop = true; }
+
+static std::string hex(const uint16_t value) {
+	std::stringstream out;
+	out << "0x" << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << value;
+	return out.str();
+}
+
+// the same loop a device would run, except sleep is a real sleep
+static void run_node(const LoomNet::NetworkInfo info, const std::string dir, const uint32_t scale, NodeResult& result) {
+	const uint16_t self = info.route_info.get_self_addr();
+	NetType network(info, LoomNet::SocketRadio(dir.c_str(), self, scale));
+	result = NodeResult{ 0, 0, false };
+	uint8_t count = 0;
+	while (!stop) {
+		uint8_t status;
+		do {
+			status = network.net_update();
+			while (status & NetStatus::NET_RECV_RDY) {
+				const LoomNet::Packet buf = network.app_recv();
+				const LoomNet::DataPacket& frag = buf.as<LoomNet::DataPacket>();
+				const std::string payload(reinterpret_cast<const char*>(frag.get_payload()), frag.get_payload_length());
+				result.received++;
+				std::lock_guard<std::mutex> lock(print_lock);
+				std::cout << hex(self) << " recieved \"" << payload << "\" from " << hex(frag.get_orig_src()) << std::endl;
+				status = network.get_status();
+			}
+			if (status & NetStatus::NET_CLOSED) {
+				std::lock_guard<std::mutex> lock(print_lock);
+				std::cout << hex(self) << " closed! Network error " << static_cast<int>(network.get_last_error())
+					<< ", MAC error " << static_cast<int>(network.get_mac().get_last_error()) << std::endl;
+				result.closed = true;
+				return;
+			}
+		} while (!(status & NetStatus::NET_SLEEP_RDY) && !stop);
+		if (info.route_info.get_device_type() != LoomNet::DeviceType::COORDINATOR
+			&& (status & NetStatus::NET_SEND_RDY)
+			&& ++count >= SEND_EVERY) {
+			const std::string payload = hex(self) + " #" + std::to_string(result.sent);
+			network.app_send(LoomNet::ADDR_COORD, 0, reinterpret_cast<const uint8_t*>(payload.c_str()), static_cast<uint8_t>(payload.length()));
+			result.sent++;
+			count = 0;
+		}
+		// sleep in short steps, so we can still be stopped
+		const LoomNet::TimeTicks wake(network.net_sleep_next_wake_time());
+		while (!wake.is_none() && !stop && network.get_radio().get_time() < wake) {
+			const uint64_t left = (wake - network.get_radio().get_time()).get_ticks() / scale;
+			std::this_thread::sleep_for(std::chrono::microseconds(std::min<uint64_t>(left, 50000)));
+		}
+		network.net_sleep_wake_ack();
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3 || argc > 6) {
+		std::cerr << "Usage: " << argv[0] << " <topology.json> <dir> [device name, or * for all] [time scale] [seconds]" << std::endl;
+		return 2;
+	}
+	const std::string dir(argv[2]);
+	const std::string name = argc > 3 ? argv[3] : "*";
+	const long scale = argc > 4 ? std::atol(argv[4]) : 1;
+	const long seconds = argc > 5 ? std::atol(argv[5]) : 0;
+	if (scale <= 0 || seconds < 0) {
+		std::cerr << "Time scale must be positive, and seconds can't be negative" << std::endl;
+		return 2;
+	}
+	std::ifstream in(argv[1]);
+	if (!in) {
+		std::cerr << "Could not open " << argv[1] << std::endl;
+		return 2;
+	}
+	std::stringstream text;
+	text << in.rdbuf();
+	DynamicJsonDocument json(1 << 20);
+	const DeserializationError err = deserializeJson(json, text.str());
+	if (err) {
+		std::cerr << "Could not parse " << argv[1] << ": " << err.c_str() << std::endl;
+		return 2;
+	}
+	std::vector<LoomNet::DeviceInfo> table(LoomNet::MAX_DEVICES);
+	const LoomNet::NetworkTopology topology(json.as<JsonObjectConst>(), table.data(), LoomNet::MAX_DEVICES);
+	if (!topology.is_valid()) {
+		std::cerr << "Invalid network topology in " << argv[1] << std::endl;
+		return 2;
+	}
+	std::vector<uint16_t> run;
+	for (uint16_t i = 0; i < topology.get_device_count(); i++) {
+		if (name == "*" || name == topology.get_device(i).name) run.push_back(i);
+	}
+	if (run.empty()) {
+		std::cerr << "No device named " << name << " in " << argv[1] << std::endl;
+		return 2;
+	}
+	std::signal(SIGINT, on_signal);
+	std::signal(SIGTERM, on_signal);
+
+	// the coordinator starts last, so everyone is listening for the first refresh
+	std::vector<NodeResult> results(run.size());
+	std::vector<std::thread> threads;
+	for (size_t i = run.size(); i-- > 0;) {
+		if (i == 0 && run.size() > 1) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		threads.emplace_back(run_node, topology.get_info(topology.get_device(run[i])), dir, static_cast<uint32_t>(scale), std::ref(results[i]));
+	}
+	const auto start = std::chrono::steady_clock::now();
+	while (!stop && (!seconds || std::chrono::steady_clock::now() - start < std::chrono::seconds(seconds)))
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	stop = true;
+	for (auto& thread : threads) thread.join();
+
+	size_t sent = 0, received = 0, closed = 0;
+	for (const NodeResult& result : results) {
+		sent += result.sent;
+		received += result.received;
+		closed += result.closed;
+	}
+	std::cout << run.size() << " devices sent " << sent << " and recieved " << received << " packets, " << closed << " closed" << std::endl;
+	return closed ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * The two archives that walk a simulation with snapshot, see Network::snapshot: one writes every
+ * value out, the other reads them back in the same order. Values go out as the bytes they are in
+ * memory, so a checkpoint only makes sense to the same build of the simulator.
+ */
+
+constexpr char CHECKPOINT_MAGIC[4] = { 'L', 'N', 'C', 'P' };
+constexpr uint32_t CHECKPOINT_VERSION = 6;
+// anything longer than this in a checkpoint means it's damaged
+constexpr uint64_t CHECKPOINT_LENGTH_MAX = 1 << 24;
+
+class CheckpointWriter {
+public:
+	static constexpr bool LOADING = false;
+
+	explicit CheckpointWriter(std::ostream& out)
+		: m_out(out) {}
+
+	template<class T>
+	void operator()(T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values go in a checkpoint");
+		m_out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+	void operator()(std::string& text) {
+		uint64_t length = text.size();
+		(*this)(length);
+		m_out.write(text.data(), static_cast<std::streamsize>(length));
+	}
+	// the engine knows how to write itself out
+	void operator()(std::default_random_engine& engine) {
+		std::ostringstream state;
+		state << engine;
+		std::string text = state.str();
+		(*this)(text);
+	}
+	template<class T>
+	void operator()(std::vector<T>& values) {
+		uint64_t length = values.size();
+		(*this)(length);
+		for (T& value : values) (*this)(value);
+	}
+
+	bool good() const { return m_out.good(); }
+
+private:
+	std::ostream& m_out;
+};
+
+class CheckpointReader {
+public:
+	static constexpr bool LOADING = true;
+
+	explicit CheckpointReader(std::istream& in)
+		: m_in(in) {}
+
+	template<class T>
+	void operator()(T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values go in a checkpoint");
+		// read into the side first, so a short read doesn't leave half a value
+		char read[sizeof(T)];
+		if (m_in.read(read, sizeof(T))) std::memcpy(&value, read, sizeof(T));
+	}
+	void operator()(std::string& text) {
+		const uint64_t length = m_read_length();
+		if (!good()) return;
+		text.resize(static_cast<size_t>(length));
+		m_in.read(&text[0], static_cast<std::streamsize>(length));
+	}
+	void operator()(std::default_random_engine& engine) {
+		std::string text;
+		(*this)(text);
+		std::istringstream state(text);
+		if (good()) state >> engine;
+	}
+	template<class T>
+	void operator()(std::vector<T>& values) {
+		const uint64_t length = m_read_length();
+		if (!good()) return;
+		values.resize(static_cast<size_t>(length));
+		for (T& value : values) (*this)(value);
+	}
+
+	bool good() const { return m_in.good(); }
+
+private:
+	uint64_t m_read_length() {
+		uint64_t length = 0;
+		(*this)(length);
+		if (length > CHECKPOINT_LENGTH_MAX) m_in.setstate(std::ios::failbit);
+		return length;
+	}
+
+	std::istream& m_in;
+};
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+/**
+ * The clock a simulated device keeps, which strays from the simulation's time the way a
+ * real crystal would: a fixed skew, plus a slow wander like the temperature swinging over
+ * the day. Both are in parts per million. The clock only ever moves forward, and changing
+ * how it drifts picks up from wherever it is now.
+ *
+ * It also remembers the last time the device heard (or sent) a refresh, so the simulation
+ * can tell where the device should have woken up if its clock were perfect.
+ */
+
+// what a clock does relative to the simulation, in ppm, and how long a wander takes to come back around, in ticks
+struct ClockDrift {
+	double skew;
+	double wander;
+	uint64_t wander_period;
+};
+
+constexpr auto CLOCK_NONE = std::numeric_limits<uint64_t>::max();
+constexpr auto CLOCK_PI = 3.14159265358979323846;
+
+class DeviceClock {
+public:
+	DeviceClock()
+		: m_drift{ 0, 0, 0 }
+		, m_anchor_global(0)
+		, m_anchor_local(0)
+		, m_sync_global(CLOCK_NONE)
+		, m_sync_local(CLOCK_NONE) {}
+
+	// starts drifting differently from the simulation time now, without jumping
+	void set_drift(const ClockDrift& drift, const uint64_t now) {
+		m_anchor_local = to_local(now);
+		m_anchor_global = now;
+		m_drift = drift;
+	}
+	const ClockDrift& get_drift() const { return m_drift; }
+	bool is_perfect() const { return m_drift.skew == 0 && (m_drift.wander == 0 || !m_drift.wander_period); }
+
+	uint64_t to_local(const uint64_t global) const {
+		// the simulation never goes back before the clock was last changed
+		if (global <= m_anchor_global) return m_anchor_local;
+		if (is_perfect()) return m_anchor_local + global - m_anchor_global;
+		const double elapsed = static_cast<double>(global - m_anchor_global);
+		const double strayed = elapsed * m_drift.skew / 1e6 + m_wander(global) - m_wander(m_anchor_global);
+		return m_anchor_local + static_cast<uint64_t>(std::max(0.0, std::round(elapsed + strayed)));
+	}
+
+	// the first simulation time the clock reads local or later
+	uint64_t to_global(const uint64_t local) const {
+		if (local == CLOCK_NONE) return CLOCK_NONE;
+		if (local <= m_anchor_local) return m_anchor_global - std::min(m_anchor_global, m_anchor_local - local);
+		if (is_perfect()) return m_anchor_global + local - m_anchor_local;
+		// the clock only moves forward, so look for it
+		uint64_t low = m_anchor_global;
+		uint64_t high = m_anchor_global + (local - m_anchor_local);
+		for (uint64_t step = 1; to_local(high) < local; step *= 2) high += step;
+		while (low < high) {
+			const uint64_t mid = low + (high - low) / 2;
+			if (to_local(mid) < local) low = mid + 1;
+			else high = mid;
+		}
+		return low;
+	}
+
+	// when the device last lined up with the network, in both clocks
+	void mark_sync(const uint64_t global) {
+		m_sync_global = global;
+		m_sync_local = to_local(global);
+	}
+	bool is_synced() const { return m_sync_global != CLOCK_NONE; }
+	uint64_t get_sync_global() const { return m_sync_global; }
+	uint64_t get_sync_local() const { return m_sync_local; }
+
+	// see Network::snapshot
+	template<class Archive>
+	void snapshot(Archive& archive) {
+		archive(m_drift);
+		archive(m_anchor_global);
+		archive(m_anchor_local);
+		archive(m_sync_global);
+		archive(m_sync_local);
+	}
+
+private:
+	// how far the wander has moved the clock by the simulation time, in ticks
+	double m_wander(const uint64_t global) const {
+		if (m_drift.wander == 0 || !m_drift.wander_period) return 0;
+		// a sine swing in rate, which averages out to nothing over each full period
+		const double period = static_cast<double>(m_drift.wander_period);
+		const double angle = 2 * CLOCK_PI * static_cast<double>(global % m_drift.wander_period) / period;
+		return m_drift.wander / 1e6 * period / (2 * CLOCK_PI) * (1 - std::cos(angle));
+	}
+
+	ClockDrift m_drift;
+	uint64_t m_anchor_global;
+	uint64_t m_anchor_local;
+	uint64_t m_sync_global;
+	uint64_t m_sync_local;
+};
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "../../../src/LoomNetworkConfig.h"
 #include "../../../src/LoomNetworkInfo.h"
 #include "TestNetwork.h"
+#include "Workload.h"
 #include <iostream>
 #include <vector>
 #include <bitset>
@@ -17,6 +18,8 @@
 #include <array>
 #include <utility>
 #include <random>
+#include <chrono>
+#include <thread>
 
 class Int {
 public:
@@ -87,6 +90,59 @@ bool test_network_operation(TestNetwork& network, const int drop_rate) {
 	return true;
 }
 
+// average seconds for each of calls calls to work
+template<class Work>
+double time_per_call(const size_t calls, Work work) {
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < calls; i++) work(i);
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+// a full send queue with one packet out and one in for each of four neighbors in turn, like a busy router
+// the packet that goes out leaves its slot in the pool for the one that comes in
+template<class Queue>
+double bench_send_queue(const size_t calls, size_t& picked) {
+	Queue queue;
+	for (size_t i = 0; !queue.full(); i++) queue.push(NetType::PacketWithDst(static_cast<uint16_t>(i % 4 + 1), static_cast<NetType::Handle>(i)));
+	return time_per_call(calls, [&](const size_t i) {
+		const uint16_t dst = static_cast<uint16_t>(i % 4 + 1);
+		const size_t index = queue.find(dst);
+		NetType::Handle handle = 0;
+		if (index != queue.size()) {
+			picked++;
+			handle = queue[index].handle;
+			queue.remove(index);
+		}
+		queue.push(NetType::PacketWithDst(dst, handle));
+	});
+}
+
+// every packet twice in a row, so half of them are repeats
+template<class Dedup>
+double bench_dedup(const std::vector<LoomNet::Packet>& packets, const size_t calls, size_t& repeats) {
+	Dedup dedup;
+	return time_per_call(calls, [&](const size_t i) {
+		if (dedup.seen(packets[i / 2 % packets.size()].as<LoomNet::DataPacket>())) repeats++;
+	});
+}
+
+template<class Overflow>
+using OverflowNetType = LoomNet::Network<TestRadio, 16, 16, 128, LoomNet::AnyRole, LoomNet::FifoSendQueue, LoomNet::FingerprintDedup, LoomNet::AlwaysRetry, Overflow>;
+
+// a device that keeps sending with its queue already full, giving the sequence number left at the front
+template<class Overflow>
+double bench_overflow(const LoomNet::NetworkInfo& info, const TestRadio& radio, const size_t calls, int& front_seq) {
+	OverflowNetType<Overflow> device(info, radio);
+	const uint8_t payload[] = { 1 };
+	const double per_call = time_per_call(calls, [&](const size_t i) {
+		device.app_send(LoomNet::ADDR_COORD, static_cast<uint8_t>(i), payload, sizeof(payload));
+	});
+	// it has to still be running, with a full queue
+	front_seq = device.get_last_error() == OverflowNetType<Overflow>::Error::NET_OK && device.get_send_queue().full()
+		? device.get_packet(device.get_send_queue()[0]).template as<LoomNet::DataPacket>().get_seq() : -1;
+	return per_call;
+}
+
 int main()
 {
 
@@ -282,6 +338,480 @@ int main()
 			if (!test_network_operation(network, 15)) return false;
 		}
 		std::cout << "Lossyer single send test passed!" << std::endl;
+
+		// simulation five: same as simulation two, but with the nested slot orders
+		for (const char* order : { "LATENCY", "WAKEUPS" }) {
+			std::cout << "Begin " << order << " slot order test." << std::endl;
+			StaticJsonDocument<size> order_json;
+			deserializeJson(order_json, JSONStr);
+			order_json["config"]["slot_order"] = order;
+			TestNetwork network(order_json.as<JsonObjectConst>());
+
+			if (!test_network_operation(network, 0)) return false;
+			std::cout << order << " slot order test passed!" << std::endl;
+		}
+
+		// simulation six: split the routers into interference groups, so their subtrees can share slots
+		std::cout << "Begin interference group test." << std::endl;
+		{
+			StaticJsonDocument<size> group_json;
+			deserializeJson(group_json, JSONStr);
+			group_json["config"]["slot_order"] = "LATENCY";
+			const uint8_t serial_slots = LoomNet::read_network_topology(group_json.as<JsonObjectConst>(), "BillyTheCoord").slot_info.get_total_slots();
+			// router 1 is far away from routers 2 and 3
+			for (JsonObject device : group_json["root"]["children"].as<JsonArray>()) {
+				if (device["type"] == 1)
+					device["group"] = strcmp(device["name"], "Router 1") == 0 ? 1 : 2;
+			}
+			TestNetwork network(group_json.as<JsonObjectConst>());
+			std::cout << "Cycle takes " << std::dec << static_cast<int>(network.devices[0].get_mac().get_slotter().get_total_slots())
+				<< " slots, down from " << static_cast<int>(serial_slots) << std::endl;
+
+			if (!test_network_operation(network, 0)) return false;
+		}
+		std::cout << "Interference group test passed!" << std::endl;
+
+		// simulation seven: let the coordinator stretch the schedule while idle, and tighten it under load
+		std::cout << "Begin adaptive batch test." << std::endl;
+		{
+			StaticJsonDocument<size> adaptive_json;
+			deserializeJson(adaptive_json, JSONStr);
+			JsonObject adaptive = adaptive_json["config"].createNestedObject("adaptive");
+			JsonArray cycles = adaptive.createNestedArray("cycles_per_batch");
+			cycles.add(2);
+			cycles.add(4);
+			JsonArray cycle_gap = adaptive.createNestedArray("cycle_gap");
+			cycle_gap.add(1);
+			cycle_gap.add(3);
+			adaptive["hold"] = 1;
+			TestNetwork network(adaptive_json.as<JsonObjectConst>());
+			const LoomNet::Slotter& coord_slot = network.devices[0].get_mac().get_slotter();
+			// nothing to send, so the gaps should grow
+			for (auto i = 0; i < 6; i++) network.next_batch();
+			const uint8_t idle_gap = coord_slot.get_cycle_gap();
+			std::cout << "Idle: " << std::dec << static_cast<int>(coord_slot.get_cycles_per_refresh()) << " cycles, gap of " << static_cast<int>(idle_gap) << std::endl;
+			// every end device sends every cycle, so the gaps should shrink and the cycles grow
+			for (auto i = 0; i < 60; i++) {
+				for (auto& d : network.devices) {
+					if (d.get_router().get_device_type() == LoomNet::DeviceType::END_DEVICE
+						&& (d.get_status() & TestNetwork::NetStatus::NET_SEND_RDY))
+						network.send_data_and_verify(d.get_router().get_self_addr(), LoomNet::ADDR_COORD, "harvest!");
+				}
+				network.next_cycle();
+			}
+			std::cout << "Busy: " << std::dec << static_cast<int>(coord_slot.get_cycles_per_refresh()) << " cycles, gap of " << static_cast<int>(coord_slot.get_cycle_gap()) << std::endl;
+			// everything we sent should still arrive
+			auto i = 0;
+			while (network.pending_packet_count() && i++ < 10) network.next_batch();
+			if (idle_gap <= 1
+				|| coord_slot.get_cycle_gap() >= idle_gap
+				|| network.pending_packet_count()
+				|| network.last_error != TestNetwork::Error::OK) {
+				std::cout << "Adaptive batch test failed!" << std::endl;
+				return false;
+			}
+		}
+		std::cout << "Adaptive batch test passed!" << std::endl;
+
+		// simulation eight: slot timing worked out from the LoRa time on air, instead of set by hand
+		std::cout << "Begin time on air test." << std::endl;
+		{
+			StaticJsonDocument<size> airtime_json;
+			deserializeJson(airtime_json, JSONStr);
+			JsonObject config = airtime_json["config"];
+			config.remove("slot_length");
+			config.remove("min_drift");
+			JsonObject max_drift = config["max_drift"];
+			max_drift["unit"] = "MILLISECOND";
+			max_drift["time"] = 20;
+			// same modem setup as LoraRadio
+			JsonObject radio = config.createNestedObject("radio");
+			JsonArray modem = radio.createNestedArray("modem");
+			modem.add(0b10010010);
+			modem.add(0b10100000);
+			modem.add(0x04);
+			radio["preamble"] = 12;
+			// finer steps, so the recieve timeout can land inside a slot
+			TestNetwork network(airtime_json.as<JsonObjectConst>(), TestNetwork::Verbosity::ERROR, 40);
+			std::cout << "Slots are " << std::dec << network.slot_time.get_ticks() / 1000 << "ms long" << std::endl;
+
+			if (!test_network_operation(network, 0)) return false;
+		}
+		std::cout << "Time on air test passed!" << std::endl;
+
+		// simulation nine: every device loses power, and rejoins from the timing it saved before
+		std::cout << "Begin power loss test." << std::endl;
+		{
+			TestNetwork network(obj);
+			network.next_batch();
+			network.next_batch();
+			std::vector<FileStateStore> stores;
+			for (size_t i = 0; i < network.devices.size(); i++) {
+				stores.emplace_back("LoomNetworkState" + std::to_string(i) + ".bin");
+				if (!network.devices[i].save_state(stores[i])) {
+					std::cout << "Power loss test failed to save!" << std::endl;
+					return false;
+				}
+			}
+			// the saved refresh is long gone by the time the power comes back
+			network.next_batch();
+			network.next_batch();
+			bool restored = true;
+			for (size_t i = 0; i < network.devices.size(); i++) {
+				network.devices[i].reset();
+				restored &= network.devices[i].restore_state(stores[i])
+					&& (network.devices[i].get_status() & TestNetwork::NetStatus::NET_SLEEP_RDY);
+				network.schedule_wake(i);
+				std::remove(("LoomNetworkState" + std::to_string(i) + ".bin").c_str());
+			}
+			if (!restored) {
+				std::cout << "Power loss test failed to restore!" << std::endl;
+				return false;
+			}
+
+			if (!test_network_operation(network, 0)) return false;
+		}
+		std::cout << "Power loss test passed!" << std::endl;
+
+		// simulation ten: a device loses power without saving anything, and has to find the network again
+		// sampling once a slot should find it just as well as listening the whole time, for a fraction of the power
+		std::cout << "Begin cold join test." << std::endl;
+		{
+			uint64_t awake[2] = { 0, 0 };
+			size_t wakes[2] = { 0, 0 };
+			for (size_t sample = 0; sample < 2; sample++) {
+				TestNetwork network(obj);
+				if (sample) network.set_sample_interval(network.slot_time);
+				network.next_batch();
+				network.next_batch();
+				// power goes out right after the refresh, so the device has to look through most of a batch
+				network.next_cycle();
+				// between slots
+				const size_t last = network.devices.size() - 1;
+				network.cur_loop = 0;
+				network.devices[last].reset();
+				const uint64_t start = network.devices[last].get_radio().get_awake_ticks();
+				const size_t start_wakes = network.devices[last].get_radio().get_wake_count();
+				for (size_t i = 0; i < 1000 && network.devices[last].get_mac().get_slotter().get_state() == LoomNet::Slotter::State::SLOT_WAIT_REFRESH; i++)
+					network.next_slot();
+				if (network.devices[last].get_mac().get_slotter().get_state() == LoomNet::Slotter::State::SLOT_WAIT_REFRESH
+					|| network.last_error != TestNetwork::Error::OK) {
+					std::cout << "Cold join test failed to join!" << std::endl;
+					return false;
+				}
+				awake[sample] = network.devices[last].get_radio().get_awake_ticks() - start;
+				wakes[sample] = network.devices[last].get_radio().get_wake_count() - start_wakes;
+				if (sample && !test_network_operation(network, 0)) return false;
+			}
+			std::cout << "Listening: " << std::dec << awake[0] << " ticks awake, sampling: " << awake[1] << " ticks awake over " << wakes[1] << " wakes" << std::endl;
+			if (awake[1] * 4 > awake[0]) {
+				std::cout << "Cold join test failed to save power!" << std::endl;
+				return false;
+			}
+		}
+		std::cout << "Cold join test passed!" << std::endl;
+
+		// simulation eleven: frames that overlap collide unless one is much stronger, and loss comes in bursts
+		std::cout << "Begin medium test." << std::endl;
+		{
+			const uint8_t payload[] = "medium";
+			LoomNet::Packet frame = LoomNet::DataPacket::Factory(0x0002, 0x0001, 0x0001, 0, 0, payload, sizeof(payload));
+			frame.set_framecheck();
+			Medium medium(3);
+			// two devices starting on their own at once, equally loud, and the third hears neither
+			medium.transmit(0, frame, 1);
+			medium.transmit(1, frame, 1);
+			const bool collided = medium.heard(2, 1).get_control() == LoomNet::PacketCtrl::NONE;
+			// and the first two, on the air together, can't hear each other
+			const bool half_duplex = medium.heard(0, 1).get_control() == LoomNet::PacketCtrl::NONE
+				&& medium.heard(1, 1).get_control() == LoomNet::PacketCtrl::NONE;
+			// much closer to the third, so it's heard over the other, though the two still miss each other
+			medium.clear();
+			medium.set_link(0, 2, -60, 0);
+			medium.set_link(1, 2, -90, 0);
+			medium.transmit(1, frame, 2);
+			medium.transmit(0, frame, 2);
+			const bool captured = medium.heard(2, 2).get_control() == LoomNet::PacketCtrl::DATA_TRANS;
+			// and a reply to what was just heard goes on the air after it, so it doesn't collide
+			medium.transmit(2, frame, 2);
+			const bool replied = medium.heard(0, 2).get_control() == LoomNet::PacketCtrl::DATA_TRANS;
+			const Medium::Stats& stats = medium.get_stats();
+			if (!collided || !half_duplex || !captured || !replied || stats.collided != 3 || stats.captured != 1) {
+				std::cout << "Medium test failed to collide!" << std::endl;
+				return false;
+			}
+
+			// everyone laid out on a grid, a few tens of meters apart, with the odd bad patch on every link
+			TestNetwork network(obj);
+			DynamicJsonDocument coords_json(4096);
+			JsonObject devices = coords_json.createNestedObject("devices");
+			for (uint16_t i = 0; i < network.topology.get_device_count(); i++) {
+				JsonArray xy = devices.createNestedArray(network.topology.get_device(i).name);
+				xy.add(40 * (i % 4));
+				xy.add(40 * (i / 4));
+			}
+			if (!network.load_coordinates(coords_json.as<JsonObjectConst>())) {
+				std::cout << "Medium test failed to place devices!" << std::endl;
+				return false;
+			}
+			network.medium.set_burst_loss(Medium::BurstLoss{ 2, 30, 0, 50 });
+			if (!test_network_operation(network, 0)) return false;
+			const Medium::Stats& net_stats = network.medium.get_stats();
+			std::cout << std::dec << net_stats.sent << " frames sent, and recievers in range lost " << net_stats.lost << ", " << net_stats.collided
+				<< " collided, " << net_stats.captured << " captured" << std::endl;
+		}
+		std::cout << "Medium test passed!" << std::endl;
+
+		// simulation twelve: every device keeps its own clock, which strays from the others between refreshes
+		// ordinary crystals should never miss a slot, and really bad ones should
+		std::cout << "Begin clock drift test." << std::endl;
+		{
+			TestNetwork network(obj);
+			// a few tens of ppm either way, swinging a little more over an hour, and waking up to a millisecond late
+			network.randomize_drift(50, 20, 3600000000ull);
+			network.set_wake_jitter(LoomNet::TimeTicks(TimeInterval::Unit::MILLISECOND, 1));
+			if (!test_network_operation(network, 0)) return false;
+			network.print_sync_report(std::cout);
+			if (network.get_missed_slots() || network.last_error != TestNetwork::Error::OK) {
+				std::cout << "Clock drift test missed slots with good clocks!" << std::endl;
+				return false;
+			}
+
+			TestNetwork bad_network(obj);
+			bad_network.randomize_drift(20000, 0, 0);
+			for (auto i = 0; i < 4; i++) bad_network.next_batch();
+			std::cout << "Missed " << std::dec << bad_network.get_missed_slots() << " slots with bad clocks" << std::endl;
+			if (!bad_network.get_missed_slots()) {
+				std::cout << "Clock drift test didn't notice bad clocks!" << std::endl;
+				return false;
+			}
+		}
+		std::cout << "Clock drift test passed!" << std::endl;
+
+		// simulation thirteen: a mix of sensors sampling on a schedule, reporting whenever, and going off all at once
+		// when something happens, with the coordinator sending commands back down
+		std::cout << "Begin workload test." << std::endl;
+		{
+			constexpr char ScenarioStr[] = "{\"seed\":7,"
+				"\"events\":[{\"name\":\"door\",\"at\":{\"unit\":\"MINUTE\",\"time\":5},\"every\":{\"unit\":\"MINUTE\",\"time\":20}}],"
+				"\"flows\":[{\"name\":\"temperature\",\"from\":\"*\",\"pattern\":\"periodic\",\"period\":{\"unit\":\"MINUTE\",\"time\":10},\"payload\":6},"
+				"{\"name\":\"motion\",\"from\":\"Router 1 End Device 1\",\"pattern\":\"poisson\",\"mean\":{\"unit\":\"MINUTE\",\"time\":8},\"payload\":[4,19]},"
+				"{\"name\":\"alarm\",\"from\":\"End Device 1\",\"pattern\":\"burst\",\"on\":\"door\",\"count\":3,\"spacing\":{\"unit\":\"SECOND\",\"time\":20},\"payload\":12},"
+				"{\"name\":\"config\",\"from\":\"BillyTheCoord\",\"to\":\"Router 3 Router 1 End Device 1\",\"pattern\":\"periodic\",\"period\":{\"unit\":\"MINUTE\",\"time\":15},\"until\":{\"unit\":\"MINUTE\",\"time\":40},\"payload\":8}]}";
+			StaticJsonDocument<size> scenario_json;
+			deserializeJson(scenario_json, ScenarioStr);
+			TestNetwork network(obj);
+			for (auto i = 0; i < LoomNet::REFRESH_CYCLE_SLOTS; i++) network.next_slot();
+			Workload workload;
+			if (!workload.load(scenario_json.as<JsonObjectConst>(), network.topology)) {
+				std::cout << "Workload test failed to load the scenario!" << std::endl;
+				return false;
+			}
+			workload.attach(network);
+			// an hour of traffic
+			workload.run(360);
+			const bool drained = workload.drain(1000);
+			workload.print_report(std::cout);
+			if (!drained) {
+				std::cout << "Workload test never finished sending!" << std::endl;
+				return false;
+			}
+			for (size_t f = 0; f < workload.get_flow_count(); f++) {
+				const Workload::Stats& stats = workload.get_stats(f);
+				if (!stats.generated || stats.delivered != stats.generated) {
+					std::cout << "Workload test failed to deliver " << workload.get_name(f) << "!" << std::endl;
+					return false;
+				}
+			}
+			if (network.last_error != TestNetwork::Error::OK) {
+				std::cout << "Workload test failed!" << std::endl;
+				return false;
+			}
+		}
+		std::cout << "Workload test passed!" << std::endl;
+
+		// simulation fourteen: a timeline of a packet working its way up from the bottom of the tree
+		std::cout << "Begin trace test." << std::endl;
+		{
+			TestNetwork network(obj);
+			network.trace.enable();
+			for (auto i = 0; i < LoomNet::REFRESH_CYCLE_SLOTS; i++) network.next_slot();
+			uint16_t deepest = LoomNet::ADDR_NONE;
+			for (uint16_t i = 0; i < network.topology.get_device_count(); i++)
+				if (strcmp(network.topology.get_device(i).name, "Router 3 Router 1 End Device 1") == 0) deepest = network.all_addrs[i];
+			if (!network.send_data_and_verify(deepest, LoomNet::ADDR_COORD, "trace me")) {
+				std::cout << "Trace test failed to send!" << std::endl;
+				return false;
+			}
+			auto i = 0;
+			while (network.pending_packet_count() && i++ < 10) network.next_batch();
+			std::ostringstream out;
+			network.trace.write(out);
+			DynamicJsonDocument trace_json(out.str().size() * 4);
+			if (network.pending_packet_count() || deserializeJson(trace_json, out.str())) {
+				std::cout << "Trace test failed to make a trace!" << std::endl;
+				return false;
+			}
+			// the packet should leave the end device, take a step at each router on the way, and land at the coordinator
+			size_t mac_spans = 0, radio_spans = 0, starts = 0, steps = 0, finishes = 0;
+			for (const JsonObjectConst event : trace_json["traceEvents"].as<JsonArrayConst>()) {
+				const char* phase = event["ph"];
+				const int track = event["tid"];
+				if (strcmp(phase, "X") == 0 && track == static_cast<int>(Trace::Track::MAC)) mac_spans++;
+				else if (strcmp(phase, "X") == 0 && track == static_cast<int>(Trace::Track::RADIO)) radio_spans++;
+				else if (strcmp(phase, "s") == 0) starts++;
+				else if (strcmp(phase, "t") == 0) steps++;
+				else if (strcmp(phase, "f") == 0) finishes++;
+			}
+			network.trace.save("LoomNetworkTrace.json");
+			std::cout << "Trace written to LoomNetworkTrace.json" << std::endl;
+			if (!mac_spans || !radio_spans || starts != 1 || steps < 2 || finishes != 1) {
+				std::cout << "Trace test failed!" << std::endl;
+				return false;
+			}
+		}
+		std::cout << "Trace test passed!" << std::endl;
+
+		// simulation fifteen: warm a network up once, then pick it back up from a file, and fork it to try things out
+		std::cout << "Begin checkpoint test." << std::endl;
+		{
+			TestNetwork network(obj);
+			network.set_drop_rate(5);
+			network.next_batch();
+			network.next_batch();
+			// leave a packet on its way, so there's something in the queues
+			network.send_data_and_verify(network.all_addrs.back(), LoomNet::ADDR_COORD, "checkpoint");
+			for (auto i = 0; i < 10; i++) network.next_slot();
+			const bool saved = network.save_checkpoint("LoomNetworkCheckpoint.bin");
+			TestNetwork resumed(obj);
+			const bool loaded = resumed.load_checkpoint("LoomNetworkCheckpoint.bin");
+			std::remove("LoomNetworkCheckpoint.bin");
+			TestNetwork fork(network);
+			if (!saved || !loaded) {
+				std::cout << "Checkpoint test failed to save and load!" << std::endl;
+				return false;
+			}
+			// all three are the same simulation, so with the same random numbers they stay the same
+			network.reseed(11);
+			resumed.reseed(11);
+			fork.reseed(11);
+			for (auto i = 0; i < 3; i++) {
+				network.next_batch();
+				resumed.next_batch();
+				fork.next_batch();
+			}
+			std::ostringstream original_state, resumed_state, fork_state;
+			network.save_checkpoint(original_state);
+			resumed.save_checkpoint(resumed_state);
+			fork.save_checkpoint(fork_state);
+			if (resumed_state.str() != original_state.str() || fork_state.str() != original_state.str()) {
+				std::cout << "Checkpoint test failed to pick up where it left off!" << std::endl;
+				return false;
+			}
+			// what if the air got much worse from here on, without touching the original
+			TestNetwork what_if(network);
+			what_if.set_drop_rate(50);
+			what_if.next_batch();
+			std::ostringstream after_state, what_if_state;
+			network.save_checkpoint(after_state);
+			what_if.save_checkpoint(what_if_state);
+			if (after_state.str() != original_state.str() || what_if_state.str() == original_state.str()) {
+				std::cout << "Checkpoint test failed to fork!" << std::endl;
+				return false;
+			}
+			// and the one from the file still works
+			if (!test_network_operation(resumed, 0)) return false;
+		}
+		std::cout << "Checkpoint test passed!" << std::endl;
+
+		// simulation sixteen: the same network stepped one device after the other, and on threads, has to end up the same
+		std::cout << "Begin parallel stepping test." << std::endl;
+		{
+			StaticJsonDocument<size> group_json;
+			deserializeJson(group_json, JSONStr);
+			group_json["config"]["slot_order"] = "LATENCY";
+			// the same split as the interference group test, so subtrees share slots without hearing each other
+			for (JsonObject device : group_json["root"]["children"].as<JsonArray>()) {
+				if (device["type"] == 1)
+					device["group"] = strcmp(device["name"], "Router 1") == 0 ? 1 : 2;
+			}
+			TestNetwork serial(group_json.as<JsonObjectConst>());
+			TestNetwork parallel(serial);
+			parallel.set_threads(std::max(4u, std::thread::hardware_concurrency()));
+			// and plenty of random numbers that would come out differently if anything ran out of order
+			for (TestNetwork* network : { &serial, &parallel }) {
+				network->reseed(21);
+				network->set_drop_rate(5);
+				network->randomize_drift(50, 20, 3600000000ull);
+				network->set_wake_jitter(LoomNet::TimeTicks(TimeInterval::Unit::MILLISECOND, 1));
+			}
+			const auto run = [](TestNetwork& network) {
+				const auto start = std::chrono::steady_clock::now();
+				for (auto i = 0; i < LoomNet::REFRESH_CYCLE_SLOTS; i++) network.next_slot();
+				for (auto round = 0; round < 24; round++) {
+					for (const auto& d : network.devices) {
+						if (d.get_router().get_device_type() == LoomNet::DeviceType::END_DEVICE && (d.get_status() & TestNetwork::NetStatus::NET_SEND_RDY))
+							network.send_data_and_verify(d.get_router().get_self_addr(), LoomNet::ADDR_COORD, "round " + std::to_string(round));
+					}
+					network.next_cycle();
+				}
+				return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			};
+			const double serial_time = run(serial);
+			const double parallel_time = run(parallel);
+			std::ostringstream serial_state, parallel_state;
+			serial.save_checkpoint(serial_state);
+			parallel.save_checkpoint(parallel_state);
+			std::cout << "Stepped up to " << std::dec << parallel.get_max_groups() << " groups at once on " << parallel.get_threads() << " threads, "
+				<< serial_time << "s one after the other and " << parallel_time << "s on threads" << std::endl;
+			if (parallel.get_max_groups() < 2) {
+				std::cout << "Parallel stepping test never had more than one group to step!" << std::endl;
+				return false;
+			}
+			if (parallel_state.str() != serial_state.str() || parallel.last_error != serial.last_error) {
+				std::cout << "Parallel stepping test failed to end up where stepping one after the other did!" << std::endl;
+				return false;
+			}
+		}
+		std::cout << "Parallel stepping test passed!" << std::endl;
+
+		// simulation seventeen: the same work through each network policy, to see what each one costs
+		std::cout << "Begin policy benchmark test." << std::endl;
+		{
+			// enough different packets that the first time each one comes around, it's long forgotten
+			std::vector<Packet> packets;
+			const uint8_t payload[] = { 1, 2, 3, 4 };
+			for (uint16_t i = 0; i < 2048; i++)
+				packets.push_back(DataPacket::Factory(ADDR_COORD, i / 256 + 1, i / 256 + 1, static_cast<uint8_t>(i), static_cast<uint8_t>(i), payload, sizeof(payload)));
+			const size_t calls = 200000;
+			size_t fifo_picked = 0, newest_picked = 0, fingerprint_repeats = 0, none_repeats = 0;
+			const double fifo_time = bench_send_queue<FifoSendQueue<NetType::PacketWithDst, 16>>(calls, fifo_picked);
+			const double newest_time = bench_send_queue<NewestSendQueue<NetType::PacketWithDst, 16>>(calls, newest_picked);
+			const double fingerprint_time = bench_dedup<FingerprintDedup<128>>(packets, calls, fingerprint_repeats);
+			const double none_time = bench_dedup<NoDedup<128>>(packets, calls, none_repeats);
+			// the radio is never used, since nothing gets past app_send
+			TestNetwork network(obj);
+			const NetworkInfo info = read_network_topology(obj, "End Device 1");
+			int drop_newest_front = 0, drop_oldest_front = 0;
+			const double drop_newest_time = bench_overflow<DropNewestOnOverflow>(info, network.devices[1].get_radio(), calls, drop_newest_front);
+			const double drop_oldest_time = bench_overflow<DropOldestOnOverflow>(info, network.devices[1].get_radio(), calls, drop_oldest_front);
+			std::cout << "Per call: " << std::dec << fifo_time * 1e9 << "ns FIFO queue, " << newest_time * 1e9 << "ns newest queue, "
+				<< fingerprint_time * 1e9 << "ns fingerprint dedup, " << none_time * 1e9 << "ns no dedup, "
+				<< drop_newest_time * 1e9 << "ns send dropping newest, " << drop_oldest_time * 1e9 << "ns send dropping oldest" << std::endl;
+			if (fifo_picked != calls || newest_picked != calls) {
+				std::cout << "Policy benchmark test found a send queue without a packet for a neighbor!" << std::endl;
+				return false;
+			}
+			if (fingerprint_repeats != calls / 2 || none_repeats) {
+				std::cout << "Policy benchmark test counted the wrong repeats!" << std::endl;
+				return false;
+			}
+			if (drop_newest_front != 0 || drop_oldest_front != static_cast<uint8_t>(calls - 16)) {
+				std::cout << "Policy benchmark test dropped the wrong packets!" << std::endl;
+				return false;
+			}
+		}
+		std::cout << "Policy benchmark test passed!" << std::endl;
 	}
 
 	std::cout << "end testing Loom Network operation" << std::endl;
@@ -0,0 +1,286 @@
+#pragma once
+
+#include "../../../src/LoomNetworkPacket.h"
+#include <ArduinoJson.h>
+#include <vector>
+#include <array>
+#include <string>
+#include <random>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+
+/**
+ * The simulated radio channel: who can hear who, how well, and what happens when two
+ * devices talk at once. Every link has its own signal strength and loss, and can follow
+ * a Gilbert-Elliott burst loss model. Transmissions that overlap at a reciever collide,
+ * unless one is stronger by the capture threshold.
+ *
+ * The simulation steps devices one after the other, so time inside a loop is ordered by
+ * cause: a device replying to something it just heard goes on the air after it. Only
+ * transmissions that start on their own in the same loop overlap.
+ *
+ * Every transmitter draws its own random numbers and keeps its own counts, and only devices
+ * marked as listening hear anything. So devices that can't hear each other can be stepped
+ * at the same time, in any order, and the medium ends up exactly the same.
+ */
+
+// nothing heard, and nothing sent yet
+constexpr auto MEDIUM_SIGNAL_NONE = -std::numeric_limits<double>::infinity();
+constexpr auto MEDIUM_NONE = std::numeric_limits<uint64_t>::max();
+
+class Medium {
+public:
+	using Airwave = std::array<uint8_t, LoomNet::PACKET_MAX>;
+
+	// chance of moving between the good and bad states on each frame, and the loss in each, in percent
+	struct BurstLoss {
+		double enter_bad;
+		double leave_bad;
+		double loss_good;
+		double loss_bad;
+	};
+
+	struct Stats {
+		size_t sent;
+		// frames a reciever in range missed because of loss
+		size_t lost;
+		// recievers that heard two frames at once and got neither
+		size_t collided;
+		// recievers that heard two frames at once and got the stronger one
+		size_t captured;
+	};
+
+	explicit Medium(const size_t count = 0)
+		: m_drop_rate(0)
+		, m_capture(6.0)
+		, m_burst{ 0, 0, 0, 0 }
+		, m_seed(std::random_device()()) {
+		resize(count);
+	}
+
+	// everyone can hear everyone, equally well, with no loss
+	void resize(const size_t count) {
+		m_links.assign(count, std::vector<Link>(count, Link{ true, 0, 0, false }));
+		m_rx.assign(count, Reception{ {}, MEDIUM_NONE, MEDIUM_SIGNAL_NONE, false });
+		m_sent.assign(count, MEDIUM_NONE);
+		m_read.assign(count, MEDIUM_NONE);
+		m_listening.assign(count, true);
+		m_stats.assign(count, Stats{ 0, 0, 0, 0 });
+		m_rands.resize(count);
+		seed(m_seed);
+	}
+	size_t size() const { return m_rx.size(); }
+
+	void set_reach(const size_t from, const size_t to, const bool reach) { m_links[from][to].reach = reach; }
+	bool can_hear(const size_t from, const size_t to) const { return m_links[from][to].reach; }
+	// strength in dBm, loss in percent
+	void set_link(const size_t from, const size_t to, const double signal, const double loss) {
+		m_links[from][to].signal = signal;
+		m_links[from][to].loss = loss;
+	}
+	double get_signal(const size_t from, const size_t to) const { return m_links[from][to].signal; }
+	double get_loss(const size_t from, const size_t to) const { return m_links[from][to].loss; }
+	// uniform loss on every link, on top of the rest
+	void set_drop_rate(const int drop_rate) { m_drop_rate = drop_rate; }
+	// every link keeps its own state, starting good
+	void set_burst_loss(const BurstLoss& burst) {
+		m_burst = burst;
+		for (auto& row : m_links)
+			for (auto& link : row) link.bad = false;
+	}
+	// how much stronger in dB one frame has to be to be heard over another
+	void set_capture(const double capture) { m_capture = capture; }
+
+	// someone asleep the whole slot doesn't hear anything, or count towards the stats
+	void set_listening(const size_t index, const bool listening) { m_listening[index] = listening; }
+	bool is_listening(const size_t index) const { return m_listening[index]; }
+
+	Stats get_stats() const {
+		Stats total{ 0, 0, 0, 0 };
+		for (const Stats& stats : m_stats) {
+			total.sent += stats.sent;
+			total.lost += stats.lost;
+			total.collided += stats.collided;
+			total.captured += stats.captured;
+		}
+		return total;
+	}
+	void reset_stats() { m_stats.assign(m_stats.size(), Stats{ 0, 0, 0, 0 }); }
+
+	// every transmitter gets its own numbers from the one seed
+	void seed(const uint32_t seed) {
+		m_seed = seed;
+		for (size_t i = 0; i < m_rands.size(); i++) {
+			std::seed_seq seq{ seed, static_cast<uint32_t>(i) };
+			m_rands[i].seed(seq);
+		}
+	}
+
+	// everything, including what's on the air and the random numbers, see Network::snapshot
+	template<class Archive>
+	void snapshot(Archive& archive) {
+		archive(m_links);
+		archive(m_rx);
+		archive(m_sent);
+		archive(m_read);
+		archive(m_listening);
+		archive(m_drop_rate);
+		archive(m_capture);
+		archive(m_burst);
+		archive(m_stats);
+		archive(m_seed);
+		archive(m_rands);
+	}
+
+	// nothing is on the air at the start of a slot
+	void clear() {
+		for (auto& rx : m_rx) {
+			rx.airwave.fill(0);
+			rx.epoch = MEDIUM_NONE;
+			rx.signal = MEDIUM_SIGNAL_NONE;
+			rx.collided = false;
+		}
+	}
+
+	LoomNet::Packet heard(const size_t to, const uint64_t tick) {
+		const Reception& rx = m_rx[to];
+		if (rx.airwave[0]) m_read[to] = tick;
+		return LoomNet::Packet{ rx.airwave.data(), static_cast<uint8_t>(rx.airwave.size()) };
+	}
+
+	void transmit(const size_t from, const LoomNet::Packet& packet, const uint64_t tick) {
+		Stats& stats = m_stats[from];
+		stats.sent++;
+		// everyone starting on their own this loop is on the air together,
+		// and a reply to something heard this loop goes on the air after it, on its own
+		const uint64_t epoch = tick * (m_rx.size() + 1) + (m_read[from] == tick ? from + 1 : 0);
+		m_sent[from] = epoch;
+		// the old uniform drop rate, kept exactly as it was: everyone loses the frame or no one does
+		const bool dropped = m_drop_rate != 0
+			&& std::uniform_int_distribution<int>(0, 99)(m_rands[from]) <= m_drop_rate;
+		// we can't hear while we're talking, and whatever we heard before is gone
+		Reception& self = m_rx[from];
+		if (self.epoch == epoch && self.airwave[0]) stats.collided++;
+		self.airwave.fill(0);
+		self.epoch = epoch;
+		self.signal = MEDIUM_SIGNAL_NONE;
+		self.collided = false;
+		for (size_t to = 0; to < m_rx.size(); to++) {
+			Link& link = m_links[from][to];
+			if (to == from || !link.reach || !m_listening[to] || m_sent[to] == epoch) continue;
+			const bool lost = m_lose(link, m_rands[from]) || dropped;
+			Reception& rx = m_rx[to];
+			if (rx.epoch != epoch) {
+				// the first frame this time around replaces whatever came before, even if it was too weak to make out
+				rx.epoch = epoch;
+				rx.collided = false;
+				rx.signal = lost ? MEDIUM_SIGNAL_NONE : link.signal;
+				if (lost) {
+					rx.airwave.fill(0);
+					stats.lost++;
+				}
+				else m_copy(packet, rx.airwave);
+			}
+			else if (lost) stats.lost++;
+			else if (rx.collided) stats.collided++;
+			else if (rx.signal == MEDIUM_SIGNAL_NONE) {
+				rx.signal = link.signal;
+				m_copy(packet, rx.airwave);
+			}
+			else if (link.signal >= rx.signal + m_capture) {
+				rx.signal = link.signal;
+				m_copy(packet, rx.airwave);
+				stats.captured++;
+			}
+			else if (rx.signal >= link.signal + m_capture) stats.captured++;
+			else {
+				rx.airwave.fill(0);
+				rx.collided = true;
+				stats.collided++;
+			}
+		}
+	}
+
+	/**
+	 * Place devices on a plane and work out every link from the distance, replacing the reach from the topology:
+	 * { "tx_power": 14, "reference_loss": 40, "path_loss_exponent": 2.7, "sensitivity": -120, "fade_margin": 10,
+	 *   "capture": 6, "devices": { "name": [x, y], ... } }
+	 * Distances are in meters, and the reference loss is at one meter. Links weaker than the sensitivity can't be
+	 * heard, and the loss ramps from zero at sensitivity + fade_margin to all of it at the sensitivity.
+	 * False if a device is missing, and nothing changes.
+	 */
+	bool load_coordinates(const JsonObjectConst& coords, const std::vector<std::string>& names) {
+		const JsonObjectConst devices = coords["devices"];
+		if (devices.isNull() || names.size() != m_rx.size()) return false;
+		std::vector<std::pair<double, double>> place;
+		for (const std::string& name : names) {
+			const JsonArrayConst xy = devices[name.c_str()];
+			if (xy.size() != 2) return false;
+			place.emplace_back(xy[0].as<double>(), xy[1].as<double>());
+		}
+		const double tx_power = coords["tx_power"] | 14.0;
+		const double reference = coords["reference_loss"] | 40.0;
+		const double exponent = coords["path_loss_exponent"] | 2.7;
+		const double sensitivity = coords["sensitivity"] | -120.0;
+		const double margin = coords["fade_margin"] | 10.0;
+		m_capture = coords["capture"] | m_capture;
+		for (size_t from = 0; from < place.size(); from++) {
+			for (size_t to = 0; to < place.size(); to++) {
+				const double distance = std::hypot(place[from].first - place[to].first, place[from].second - place[to].second);
+				const double signal = tx_power - reference - 10.0 * exponent * std::log10(std::max(distance, 1.0));
+				Link& link = m_links[from][to];
+				link.reach = signal >= sensitivity;
+				link.signal = signal;
+				link.loss = !link.reach || margin <= 0 ? 0
+					: std::max(0.0, std::min(100.0, 100.0 * (sensitivity + margin - signal) / margin));
+			}
+		}
+		return true;
+	}
+
+private:
+	struct Link {
+		bool reach;
+		double signal;
+		double loss;
+		// the Gilbert-Elliott state
+		bool bad;
+	};
+
+	struct Reception {
+		Airwave airwave;
+		uint64_t epoch;
+		double signal;
+		bool collided;
+	};
+
+	bool m_lose(Link& link, std::default_random_engine& rand) {
+		std::uniform_real_distribution<double> percent(0, 100);
+		bool lost = link.loss > 0 && percent(rand) < link.loss;
+		if (m_burst.enter_bad > 0 || m_burst.loss_good > 0) {
+			link.bad = link.bad ? percent(rand) >= m_burst.leave_bad : percent(rand) < m_burst.enter_bad;
+			lost |= percent(rand) < (link.bad ? m_burst.loss_bad : m_burst.loss_good);
+		}
+		return lost;
+	}
+
+	static void m_copy(const LoomNet::Packet& packet, Airwave& airwave) {
+		airwave.fill(0);
+		for (auto i = 0; i < packet.get_packet_length(); i++) airwave[i] = packet.get_raw()[i];
+	}
+
+	std::vector<std::vector<Link>> m_links;
+	std::vector<Reception> m_rx;
+	// the epoch each device last sent in, and the loop it last heard something
+	std::vector<uint64_t> m_sent;
+	std::vector<uint64_t> m_read;
+	std::vector<uint8_t> m_listening;
+	int m_drop_rate;
+	double m_capture;
+	BurstLoss m_burst;
+	// what each device sent, and what happened to it
+	std::vector<Stats> m_stats;
+	uint32_t m_seed;
+	std::vector<std::default_random_engine> m_rands;
+};
\ No newline at end of file
@@ -5,6 +5,11 @@
 #include "../../../src/LoomRouter.h"
 #include "../../../src/LoomNetworkConfig.h"
 #include "../../../src/LoomNetworkInfo.h"
+#include "Medium.h"
+#include "DeviceClock.h"
+#include "Trace.h"
+#include "Checkpoint.h"
+#include "WorkerPool.h"
 #include <iostream>
 #include <vector>
 #include <bitset>
@@ -16,6 +21,12 @@
 #include <utility>
 #include <random>
 #include <map>
+#include <fstream>
+#include <cstdlib>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <memory>
 
 class NulStreambuf : public std::streambuf
 {
@@ -28,79 +39,162 @@ protected:
 	}
 };
 
-constexpr static LoomNet::TimeInterval::Unit slot_unit = LoomNet::TimeInterval::Unit::SECOND;
-constexpr static uint32_t slot_length = 10;
-
-class TestRadio : public LoomNet::Radio {
+class TestRadio : public LoomNet::RadioBase {
 public:
-	TestRadio(std::array<uint8_t, LoomNet::PACKET_MAX> & airwaves, const size_t& cur_slot, const size_t& cur_loop, std::default_random_engine& rand, const int& drop_rate)
-		: m_airwaves(airwaves)
+	TestRadio(Medium& medium, std::vector<DeviceClock>& clocks, Trace& trace, const LoomNet::TimeTicks& slot_time, const size_t& loops_per_slot, const size_t& cur_slot, const size_t& cur_loop, const LoomNet::TimeTicks& sample_interval)
+		: m_medium(medium)
+		, m_clocks(clocks)
+		, m_trace(trace)
+		, m_index(0)
+		, m_slot_time(slot_time)
+		, m_loops_per_slot(loops_per_slot)
 		, m_cur_slot(cur_slot)
 		, m_cur_loop(cur_loop)
-		, m_rand(rand)
-		, m_drop_rate(drop_rate)
-		, m_state(State::DISABLED) {}
+		, m_sample_interval(sample_interval)
+		, m_state(State::DISABLED)
+		, m_awake_ticks(0)
+		, m_wake_ticks(0)
+		, m_wake_count(0) {}
+
+	// same medium, but listening and sending as a different device
+	TestRadio(const TestRadio& rhs, const size_t index)
+		: TestRadio(rhs) {
+		m_index = index;
+	}
+
+	// the same device's radio in the same state, but in another copy of the simulation
+	TestRadio(const TestRadio& rhs, const TestRadio& other)
+		: TestRadio(other, rhs.m_index) {
+		m_state = rhs.m_state;
+		m_awake_ticks = rhs.m_awake_ticks;
+		m_wake_ticks = rhs.m_wake_ticks;
+		m_wake_count = rhs.m_wake_count;
+	}
 
-	LoomNet::TimeInterval get_time() const override { return { slot_unit, m_cur_slot * slot_length + m_cur_loop }; }
-	LoomNet::Radio::State get_state() const override { return m_state; }
-	void enable() override {
+	LoomNet::TimeTicks get_time() const {
+		// every device reads the simulation time through its own clock
+		return LoomNet::TimeTicks(m_clocks[m_index].to_local(m_get_global()));
+	}
+	LoomNet::Radio::State get_state() const { return m_state; }
+	void enable() {
 		if (m_state != State::DISABLED) 
 			std::cout << "Invalid radio state movement in enable()" << std::endl;
-		m_state = State::SLEEP;
+		m_set_state(State::SLEEP);
 	}
-	void disable() override {
+	void disable() {
 		if (m_state != State::SLEEP) 
 			std::cout << "Invalid radio state movement in disable()" << std::endl;
-		m_state = State::DISABLED;
+		m_set_state(State::DISABLED);
 	}
-	void sleep() override {
+	void sleep() {
 		if (m_state != State::IDLE) 
 			std::cout << "Invalid radio state movement in sleep()" << std::endl;
-		m_state = State::SLEEP;
+		m_awake_ticks += get_time().get_ticks() - m_wake_ticks;
+		m_set_state(State::SLEEP);
 	}
-	void wake() override {
+	void wake() {
 		if (m_state != State::SLEEP) 
 			std::cout << "Invalid radio state movement in wake()" << std::endl;
-		m_state = State::IDLE;
+		m_wake_ticks = get_time().get_ticks();
+		m_wake_count++;
+		m_set_state(State::IDLE);
 	}
-	LoomNet::Packet recv(LoomNet::TimeInterval& recv_stamp) override {
+	LoomNet::Packet recv(LoomNet::TimeTicks& recv_stamp) {
 		if (m_state != State::IDLE) 
 			std::cout << "Invalid radio state to recv" << std::endl;
 		recv_stamp = get_time();
-		return LoomNet::Packet{ m_airwaves.data(), static_cast<uint8_t>(m_airwaves.size()) };
+		const LoomNet::Packet heard = m_medium.heard(m_index, m_get_tick());
+		// a refresh is where the device lines its clock up with the network
+		if (heard.get_control() == LoomNet::PacketCtrl::REFRESH_INITIAL) m_clocks[m_index].mark_sync(m_get_global());
+		return heard;
 	}
-	void send(const LoomNet::Packet& send) override {
+	void send(const LoomNet::Packet& send) {
 		if (m_state != State::IDLE) 
 			std::cout << "Invalid radio state to recv" << std::endl;
-		if (m_drop_rate == 0
-			|| std::uniform_int_distribution<int>(0, 99)(m_rand) > m_drop_rate)
-			for (auto i = 0; i < send.get_packet_length(); i++) m_airwaves[i] = send.get_raw()[i];
-		else {
-			// std::cout << "Droppped packet!" << std::endl;
-			m_airwaves.fill(0);
-		}
+		// the medium works out who hears it
+		m_medium.transmit(m_index, send, m_get_tick());
+		// and it's on the air for the rest of the loop
+		m_trace.transmit(m_index, send, m_get_global(), m_slot_time.get_ticks() / m_loops_per_slot);
+		if (send.get_control() == LoomNet::PacketCtrl::REFRESH_INITIAL) m_clocks[m_index].mark_sync(m_get_global());
  	}
+	// the simulation keeps packets on the air for the whole slot
+	LoomNet::TimeTicks get_sample_interval() const { return m_sample_interval; }
+
+	// how long the radio has been listening in total, which is most of the power used
+	uint64_t get_awake_ticks() const {
+		return m_awake_ticks + (m_state == State::IDLE ? get_time().get_ticks() - m_wake_ticks : 0);
+	}
+	// every wake costs a little extra to get the radio going, so count them too
+	size_t get_wake_count() const { return m_wake_count; }
+
+	// see Network::snapshot, the medium and clocks are saved with the rest of the simulation
+	template<class Archive>
+	void snapshot(Archive& archive) {
+		archive(m_state);
+		archive(m_awake_ticks);
+		archive(m_wake_ticks);
+		archive(m_wake_count);
+	}
 
 private:
-	std::array<uint8_t, LoomNet::PACKET_MAX>& m_airwaves;
+	// which loop of the simulation we're in
+	uint64_t m_get_tick() const { return m_cur_slot * m_loops_per_slot + m_cur_loop; }
+	// each loop of the simulation moves time forward by an even fraction of a slot
+	uint64_t m_get_global() const { return m_cur_slot * m_slot_time.get_ticks() + m_cur_loop * m_slot_time.get_ticks() / m_loops_per_slot; }
+
+	void m_set_state(const State state) {
+		m_state = state;
+		m_trace.set_state(m_index, Trace::Track::RADIO, Trace::get_name(state), m_get_global());
+	}
+
+	Medium& m_medium;
+	std::vector<DeviceClock>& m_clocks;
+	Trace& m_trace;
+	size_t m_index;
+	const LoomNet::TimeTicks& m_slot_time;
+	const size_t& m_loops_per_slot;
 	const size_t& m_cur_slot;
 	const size_t& m_cur_loop;
-	std::default_random_engine& m_rand;
-	const int& m_drop_rate;
+	const LoomNet::TimeTicks& m_sample_interval;
 	State m_state;
+	uint64_t m_awake_ticks;
+	uint64_t m_wake_ticks;
+	size_t m_wake_count;
 };
 
 using NetType = LoomNet::Network<TestRadio, 16, 16, 128>;
 
-static void recurse_all_devices(const JsonArrayConst& children_array, const JsonObjectConst& root, std::vector<NetType>& devices, const TestRadio& radio) {
-	for (const JsonObjectConst obj : children_array) {
-		if (!obj.isNull()) {
-			devices.emplace_back(LoomNet::read_network_topology(root, obj["name"]), radio);
-			const JsonArrayConst childs = obj["children"];
-			if (!childs.isNull()) 
-				recurse_all_devices(childs, root, devices, radio);
-		}
+// keeps a device's saved timing in a file, like flash would on the device
+class FileStateStore : public LoomNet::StateStore {
+public:
+	explicit FileStateStore(const std::string& path)
+		: m_path(path) {}
+
+	bool write(const uint8_t* src, const uint8_t length) override {
+		std::ofstream out(m_path, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(src), length);
+		return static_cast<bool>(out);
+	}
+	bool read(uint8_t* dst, const uint8_t length) override {
+		std::ifstream in(m_path, std::ios::binary);
+		in.read(reinterpret_cast<char*>(dst), length);
+		return in.gcount() == length;
+	}
+
+private:
+	const std::string m_path;
+};
+
+// the branch taken at each layer to reach a device, and the interference group of that branch
+using GroupPath = std::vector<std::pair<size_t, uint8_t>>;
+
+// two devices are out of range only if their subtrees split into different interference groups
+static bool in_range(const GroupPath& lhs, const GroupPath& rhs) {
+	for (size_t i = 0; i < lhs.size() && i < rhs.size(); i++) {
+		if (lhs[i].first != rhs[i].first)
+			return !lhs[i].second || !rhs[i].second || lhs[i].second == rhs[i].second;
 	}
+	return true;
 }
 
 class TestNetwork {
@@ -124,38 +218,129 @@ public:
 	using NetStatus = NetType::Status;
 	using NetTrack = std::tuple<uint16_t, std::string, size_t>;
 
-	TestNetwork(const JsonObjectConst& obj, const Verbosity verbose = Verbosity::ERROR)
-		: airwaves{ 0 }
+	// how often a device woke up too far from where it would have with a perfect clock to make its exchange, and the furthest off it got
+	struct SyncReport {
+		size_t wakes;
+		size_t missed;
+		int64_t worst;
+	};
+
+	// what a device's turn in a loop left for the rest of the simulation to deal with
+	struct Stepped {
+		bool closed;
+		std::vector<LoomNet::Packet> received;
+	};
+
+	// what stepping some of the devices through a loop found, added up over every group after
+	struct StepCount {
+		bool all_sleep;
+		unsigned int woke_count;
+		unsigned int search_count;
+	};
+
+	TestNetwork(const JsonObjectConst& obj, const Verbosity verbose = Verbosity::ERROR, const size_t loops = 10)
+		: medium{}
+		, trace{}
+		, max_awake(2)
+		, table(LoomNet::MAX_DEVICES)
+		, topology(obj, table.data(), static_cast<uint16_t>(table.size()))
+		, slot_time(topology.get_device_count() ? topology.get_info(topology.get_device(0)).drift_info.slot_length : LoomNet::TIME_NONE)
+		, loops_per_slot(loops)
 		, cur_slot(0)
 		, cur_loop(0)
-		, drop_rate(0)
+		, sample_interval(LoomNet::TICKS_NONE)
+		, clocks(topology.get_device_count())
+		, wake_jitter(0)
 		, rand_engine(std::random_device()())
 		, devices{}
 		, next_wake_times{}
 		, send_track()
 		, dupe_track()
+		, on_delivered()
 		, how_much(verbose)
-		, null_buf()
-		, null_stream(&null_buf)
+		, max_groups(0)
 		, last_error(Error::OK) {
-		const TestRadio radio(airwaves, cur_slot, cur_loop, rand_engine, drop_rate);
-		// create the devices array from the json!
-		const JsonObjectConst root = obj["root"];
-		// add the coordinator!
-		devices.emplace_back(LoomNet::read_network_topology(obj, root["name"]), radio);
-		const JsonArrayConst children = root["children"];
-		// add everything else through recursion!
-		if (!children.isNull()) recurse_all_devices(children, obj, devices, radio);
+		const TestRadio radio(medium, clocks, trace, slot_time, loops_per_slot, cur_slot, cur_loop, sample_interval);
+		// create the devices array from the compiled topology, which is already in depth-first order
+		std::vector<GroupPath> paths(topology.get_device_count());
+		for (uint16_t i = 0; i < topology.get_device_count(); i++) {
+			const LoomNet::DeviceInfo& device = topology.get_device(i);
+			devices.emplace_back(topology.get_info(device), TestRadio(radio, i));
+			trace.name_device(i, device.name, devices[i].get_router().get_self_addr());
+			size_t branch = 0;
+			for (uint16_t c = device.first_child; c != LoomNet::DEVICE_NONE; c = topology.get_device(c).next_sibling) {
+				paths[c] = paths[i];
+				paths[c].emplace_back(branch++, topology.get_device(c).group);
+			}
+		}
+		// figure out who can hear who
+		medium.resize(devices.size());
+		for (size_t i = 0; i < devices.size(); i++)
+			for (size_t o = 0; o < devices.size(); o++)
+				medium.set_reach(i, o, in_range(paths[i], paths[o]));
+		// every sender wakes up at most itself and its parent, so any more than that is a sync problem
+		const LoomNet::Slotter& coord_slot = devices[0].get_mac().get_slotter();
+		for (uint8_t s = 0; s < coord_slot.get_total_slots(); s++) {
+			size_t senders = 0;
+			for (const auto& d : devices) {
+				const LoomNet::Slotter& slot = d.get_mac().get_slotter();
+				if (slot.get_send_slot() != LoomNet::SLOT_NONE
+					&& s >= slot.get_send_slot()
+					&& s < slot.get_send_slot() + slot.get_send_count())
+					senders++;
+			}
+			if (senders * 2 > max_awake) max_awake = senders * 2;
+		}
 		// initialize next_wake_times
 		next_wake_times.resize(devices.size(), 0);
+		sync_reports.resize(devices.size(), SyncReport{ 0, 0, 0 });
+		stepped.resize(devices.size(), Stepped{ false, {} });
+		// every device draws its own wake jitter, so it doesn't matter who goes to sleep first
+		for (size_t i = 0; i < devices.size(); i++) jitter_rands.emplace_back(rand_engine());
 		// and the array of all addresses
 		all_addrs.resize(devices.size(), 0);
 		for (size_t i = 0; i < devices.size(); i++) all_addrs[i] = devices[i].get_router().get_self_addr();
 	}
 
+	// a fork of the simulation right where it is, which goes its own way from here, on as many threads
+	// nobody hears about its deliveries until on_delivered is set again
+	TestNetwork(const TestNetwork& rhs)
+		: medium(rhs.medium)
+		, trace(rhs.trace)
+		, max_awake(rhs.max_awake)
+		, table(rhs.table)
+		, topology(rhs.topology, table.data(), static_cast<uint16_t>(table.size()))
+		, slot_time(rhs.slot_time)
+		, loops_per_slot(rhs.loops_per_slot)
+		, cur_slot(rhs.cur_slot)
+		, cur_loop(rhs.cur_loop)
+		, sample_interval(rhs.sample_interval)
+		, clocks(rhs.clocks)
+		, wake_jitter(rhs.wake_jitter)
+		, rand_engine(rhs.rand_engine)
+		, jitter_rands(rhs.jitter_rands)
+		, devices{}
+		, next_wake_times(rhs.next_wake_times)
+		, sync_reports(rhs.sync_reports)
+		, stepped(rhs.stepped)
+		, all_addrs(rhs.all_addrs)
+		, send_track(rhs.send_track)
+		, dupe_track(rhs.dupe_track)
+		, on_delivered()
+		, how_much(rhs.how_much)
+		, workers(rhs.workers ? new WorkerPool(rhs.workers->size()) : nullptr)
+		, groups(rhs.groups)
+		, max_groups(rhs.max_groups)
+		, last_error(rhs.last_error) {
+		// every device carries on as it was, but on a radio in this copy
+		const TestRadio radio(medium, clocks, trace, slot_time, loops_per_slot, cur_slot, cur_loop, sample_interval);
+		devices.reserve(rhs.devices.size());
+		for (const NetType& device : rhs.devices) devices.emplace_back(device, TestRadio(device.get_radio(), radio));
+	}
+
 	void next_slot() {
 		// clear the network
-		airwaves.fill(0);
+		medium.clear();
 		cur_loop = 0;
 		// increment all the slot time trackers in the send tracking hash table
 		for (auto& elem : send_track)
@@ -164,96 +349,56 @@ public:
 		// wake all the devices that scheduled a wakeup now
 		m_print(Verbosity::VERBOSE) << "	Woke: ";
 		unsigned int woke_count = 0;
+		// devices still looking for a refresh aren't part of the schedule yet
+		unsigned int search_count = 0;
 		for (uint8_t o = 0; o < devices.size(); o++) {
 			if (devices[o].get_status() & NetStatus::NET_SLEEP_RDY) {
-				if (cur_slot * slot_length >= next_wake_times[o]) {
-					devices[o].net_sleep_wake_ack();
-					woke_count++;
-					m_print(Verbosity::VERBOSE) << "0x" << std::hex << std::setfill('0') << std::setw(4) << devices[o].get_router().get_self_addr() << ", ";
-				}
+				if (cur_slot * slot_time.get_ticks() >= next_wake_times[o])
+					m_wake(o, woke_count, search_count);
 			}
+			else if (devices[o].get_mac().get_status() == LoomNet::MAC::State::MAC_REFRESH_WAIT)
+				search_count++;
 		}
 		m_print(Verbosity::VERBOSE) << std::endl;
-		if (woke_count >= 3 && woke_count <= devices.size() - 2 && woke_count != 1) {
-			m_print(Verbosity::ERROR) << "Devcies out of sync!" << std::endl;
-			last_error = Error::OUT_OF_SYNC;
+		// only who's awake, or wakes up before the slot is over, can do anything
+		m_find_active();
+		// and it's only worth handing out to the threads if there's more than one group that can't hear the others
+		bool parallel = false;
+		if (m_is_parallel()) {
+			m_group_active();
+			parallel = groups.size() > 1;
 		}
 		// iterate through each element until all of them are asleep, then move to the next slot
 		bool all_sleep;
-		for (; cur_loop < slot_length; cur_loop++) {
-			all_sleep = true;
+		for (; cur_loop < loops_per_slot; cur_loop++) {
 			m_print(Verbosity::VERBOSE) << "	Iteration " << cur_loop << ":" << std::endl;
-			for (uint8_t i = 0; i < devices.size(); i++) {
-				// if the device is awake
-				const uint8_t status = devices[i].get_status();
-				if (status == NetStatus::NET_CLOSED) {
-					m_print(Verbosity::ERROR) << std::hex << devices[i].get_router().get_self_addr() << " closed!" << std::endl;
-					last_error = Error::DEVICE_CLOSED;
-				}
-				// sleep check
-				else if (!(status & NetStatus::NET_SLEEP_RDY)) {
-					// Send/recieve data!
-					if (status & NetStatus::NET_RECV_RDY) {
-						m_print(Verbosity::VERBOSE) << "	0x" << std::hex << std::setfill('0') << std::setw(4) << devices[i].get_router().get_self_addr();
-						m_print(Verbosity::VERBOSE) << " recieved: " << std::endl;
-						do {
-							const LoomNet::Packet& buf = devices[i].app_recv();
-							const LoomNet::DataPacket& frag = buf.as<LoomNet::DataPacket>();
-							const std::string payload(reinterpret_cast<const char*>(frag.get_payload()), frag.get_payload_length());
-							m_print(Verbosity::VERBOSE) << "		" << payload << std::endl;
-							// find the packet in the tracking table, and remove it
-							// verifying it was recieved
-							// get all the packets that are outbound for this device
-							auto find_iter = send_track.equal_range(devices[i].get_router().get_self_addr());
-							auto& e = find_iter.first;
-							size_t num_slots = 0;
-							// find the one that matchs this packet
-							for (; e != find_iter.second; ++e) {
-								if (std::get<0>(e->second) == frag.get_orig_src()
-									&& std::get<1>(e->second).compare(payload) == 0) {
-									num_slots = std::get<2>(e->second);
-									break;
-								}
-							}
-							// if we didn't find one, print and error out
-							if (e == find_iter.second) {
-								// check our dupe list to see if this packet is invalid or a duplicate
-								auto find_iter_dupe = dupe_track.equal_range(devices[i].get_router().get_self_addr());
-								auto& f = find_iter_dupe.first;
-								// find the one that matchs this packet
-								for (; f != find_iter_dupe.second; ++f)
-									if (std::get<0>(f->second) == frag.get_orig_src()
-										&& std::get<1>(f->second).compare(payload) == 0)
-										break;
-								if (f == find_iter_dupe.second) 
-									m_print(Verbosity::ERROR) << "Invalid packet!" << std::endl;
-								else 
-									m_print(Verbosity::ERROR) << "Duplicated packet!" << std::endl;
-								last_error = Error::UNKNOWN_PACKET;
-							}
-							// else add the one we found to the duplicate tracker so we can find it later
-							else {
-								dupe_track.insert(*e);
-								send_track.erase(e);
-							}
-							// else print some useful data
-							m_print(Verbosity::VERBOSE) << "		From: 0x" << std::hex << std::setfill('0') << std::setw(4) << frag.get_orig_src() << std::endl;
-							m_print(Verbosity::VERBOSE) << "		Took " << std::dec << num_slots << " slots" << std::endl;
-						} while (devices[i].get_status() & NetStatus::NET_RECV_RDY);
-					}
-					// run the state machine
-					const uint8_t new_status = devices[i].net_update();
-					m_print(Verbosity::VERBOSE) << "		Status of 0x" << std::hex << std::setfill('0') << std::setw(4) << devices[i].get_router().get_self_addr() << ": " << std::bitset<8>(devices[i].get_status()) << std::endl;
-					// if it wants to go to sleep now, add the time to the wake times
-					if (new_status & NetStatus::NET_SLEEP_RDY) {
-						next_wake_times[i] = devices[i].net_sleep_next_wake_time().get_time();
-					}
-					else all_sleep = false;
+			StepCount count{ true, 0, 0 };
+			if (parallel) {
+				std::vector<StepCount> counts(groups.size(), StepCount{ true, 0, 0 });
+				workers->run(groups.size(), [&](const size_t g) {
+					for (const size_t i : groups[g]) m_step(i, counts[g]);
+				});
+				for (const StepCount& group : counts) {
+					count.all_sleep &= group.all_sleep;
+					count.woke_count += group.woke_count;
+					count.search_count += group.search_count;
 				}
 			}
-			if (all_sleep) break;
+			else {
+				for (size_t i = 0; i < devices.size(); i++) m_step(i, count);
+			}
+			woke_count += count.woke_count;
+			search_count += count.search_count;
+			all_sleep = count.all_sleep;
+			// everything that isn't just the device's own business, in the same order either way
+			for (size_t i = 0; i < devices.size(); i++) m_finish_step(i);
+			if (all_sleep && !m_wake_pending()) break;
 		}
 		m_print(Verbosity::VERBOSE) << "	Took " << cur_loop << " iterations." << std::endl;
+		if (woke_count > max_awake && woke_count + search_count <= devices.size() - 2 && woke_count != 1) {
+			m_print(Verbosity::ERROR) << "Devcies out of sync!" << std::endl;
+			last_error = Error::OUT_OF_SYNC;
+		}
 		// next slot!
 		cur_slot++;
 	}
@@ -302,28 +447,377 @@ public:
 
 	size_t pending_packet_count() const { return send_track.size(); }
 
-	void set_drop_rate(const int new_drop_rate) { drop_rate = new_drop_rate; }
+	void set_drop_rate(const int new_drop_rate) { medium.set_drop_rate(new_drop_rate); }
+
+	// place every device using Medium::load_coordinates, false if one is missing
+	bool load_coordinates(const JsonObjectConst& coords) {
+		std::vector<std::string> names;
+		for (uint16_t i = 0; i < topology.get_device_count(); i++) names.emplace_back(topology.get_device(i).name);
+		return medium.load_coordinates(coords, names);
+	}
+
+	// TICKS_NONE to have devices listen the whole time while looking for a refresh
+	void set_sample_interval(const LoomNet::TimeTicks& interval) { sample_interval = interval; }
+
+	// how far each device's clock strays from the simulation time, from now on
+	void set_drift(const size_t index, const ClockDrift& drift) { clocks[index].set_drift(drift, get_global_time()); }
+
+	// a random skew and wander, up to the given ppm either way, for every device
+	void randomize_drift(const double max_skew, const double max_wander, const uint64_t wander_period) {
+		std::uniform_real_distribution<double> ppm(-1, 1);
+		for (size_t i = 0; i < clocks.size(); i++)
+			set_drift(i, ClockDrift{ max_skew * ppm(rand_engine), max_wander * ppm(rand_engine), wander_period });
+	}
+
+	// every wake lands up to this much later than the device asked for
+	void set_wake_jitter(const LoomNet::TimeTicks& jitter) { wake_jitter = jitter; }
+
+	/**
+	 * Step the devices on this many threads, 1 to go back to one after the other. Each slot, the devices
+	 * that might do something are split into groups that can't hear each other, even through someone else
+	 * in the group, and each group is stepped on its own thread. Nothing one group does can change another,
+	 * so it ends up exactly where stepping one after the other would have.
+	 * The trace and VERBOSE output need everything in order, so they always step one after the other.
+	 */
+	void set_threads(const size_t threads) { workers.reset(threads > 1 ? new WorkerPool(threads) : nullptr); }
+	size_t get_threads() const { return workers ? workers->size() : 1; }
+	// the most groups there were to step side by side in one slot
+	size_t get_max_groups() const { return max_groups; }
+
+	uint64_t get_global_time() const { return cur_slot * slot_time.get_ticks() + cur_loop * slot_time.get_ticks() / loops_per_slot; }
+
+	// work out when a device that just went to sleep wakes up, in simulation time
+	void schedule_wake(const size_t index) {
+		const LoomNet::TimeTicks wake = devices[index].net_sleep_next_wake_time();
+		uint64_t actual = clocks[index].to_global(wake.get_ticks());
+		if (wake.is_none()) actual = CLOCK_NONE;
+		else if (wake_jitter.get_ticks())
+			actual += std::uniform_int_distribution<uint64_t>(0, wake_jitter.get_ticks())(jitter_rands[index]);
+		// the simulation only moves in loops, so wake on the closest one
+		next_wake_times[index] = m_nearest_loop(actual);
+		// where it should have woken, if neither it nor the coordinator had strayed since it last heard a refresh
+		const DeviceClock& self = clocks[index];
+		const DeviceClock& coord = clocks[0];
+		if (wake.is_none() || !self.is_synced() || wake.get_ticks() < self.get_sync_local()) return;
+		const uint64_t ideal = coord.to_global(coord.to_local(self.get_sync_global()) + wake.get_ticks() - self.get_sync_local());
+		SyncReport& report = sync_reports[index];
+		report.wakes++;
+		const int64_t error = static_cast<int64_t>(actual - ideal);
+		if (std::llabs(error) > std::llabs(report.worst)) report.worst = error;
+		// the other side of an exchange only waits min_drift for us, and we only wait that long for them
+		const int64_t off = static_cast<int64_t>(next_wake_times[index] - m_nearest_loop(ideal));
+		if (static_cast<uint64_t>(std::llabs(off)) >= LoomNet::TimeTicks(devices[index].get_mac().get_drift().min_drift).get_ticks())
+			report.missed++;
+	}
+
+	void print_sync_report(std::ostream& out) const {
+		for (size_t i = 0; i < devices.size(); i++) {
+			const SyncReport& report = sync_reports[i];
+			out << "0x" << std::hex << std::setfill('0') << std::setw(4) << devices[i].get_router().get_self_addr()
+				<< std::dec << " (" << clocks[i].get_drift().skew << "ppm): missed " << report.missed << " of " << report.wakes
+				<< " wakes, worst " << report.worst << " ticks off" << std::endl;
+		}
+	}
+
+	size_t get_missed_slots() const {
+		size_t missed = 0;
+		for (const SyncReport& report : sync_reports) missed += report.missed;
+		return missed;
+	}
 
 	void clear_dupes() { dupe_track.clear(); }
 
+	// a fork draws the same random numbers as the simulation it came from, until it's given its own
+	void reseed(const uint32_t seed) {
+		rand_engine.seed(seed);
+		medium.seed(static_cast<uint32_t>(rand_engine()));
+		for (auto& rand : jitter_rands) rand.seed(rand_engine());
+	}
+
+	/**
+	 * Save the whole simulation, every device, the medium, the clocks and the random numbers, so it can be picked
+	 * back up with load_checkpoint on a TestNetwork built from the same topology. Call between slots.
+	 * The trace and on_delivered aren't saved.
+	 */
+	bool save_checkpoint(std::ostream& out) {
+		CheckpointWriter writer(out);
+		m_checkpoint(writer);
+		return writer.good();
+	}
+	bool save_checkpoint(const std::string& path) {
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		return save_checkpoint(out);
+	}
+	// false if it's from a different topology or build, and if it's damaged partway through, the simulation is too
+	bool load_checkpoint(std::istream& in) {
+		CheckpointReader reader(in);
+		return m_checkpoint(reader);
+	}
+	bool load_checkpoint(const std::string& path) {
+		std::ifstream in(path, std::ios::binary);
+		return load_checkpoint(in);
+	}
+
+	void m_wake(const size_t index, unsigned int& woke_count, unsigned int& search_count) {
+		devices[index].net_sleep_wake_ack();
+		m_trace_mac(index);
+		if (devices[index].get_mac().get_slotter().get_state() == LoomNet::Slotter::State::SLOT_WAIT_REFRESH)
+			search_count++;
+		else
+			woke_count++;
+		m_print(Verbosity::VERBOSE) << "0x" << std::hex << std::setfill('0') << std::setw(4) << devices[index].get_router().get_self_addr() << ", ";
+	}
+
+	// one device's turn in a loop, which only touches that device and the medium around it
+	void m_step(const size_t i, StepCount& count) {
+		// a clock running late, or a wake that doesn't line up with a slot, lands partway through
+		if (cur_loop && (devices[i].get_status() & NetStatus::NET_SLEEP_RDY) && get_global_time() >= next_wake_times[i]) {
+			m_print(Verbosity::VERBOSE) << "	Late: ";
+			m_wake(i, count.woke_count, count.search_count);
+			m_print(Verbosity::VERBOSE) << std::endl;
+		}
+		// if the device is awake
+		const uint8_t status = devices[i].get_status();
+		if (status == NetStatus::NET_CLOSED) {
+			stepped[i].closed = true;
+			m_trace_mac(i);
+		}
+		// sleep check
+		else if (!(status & NetStatus::NET_SLEEP_RDY)) {
+			// Send/recieve data!
+			if (status & NetStatus::NET_RECV_RDY) {
+				do {
+					stepped[i].received.push_back(devices[i].app_recv());
+				} while (devices[i].get_status() & NetStatus::NET_RECV_RDY);
+			}
+			// run the state machine
+			const uint8_t new_status = devices[i].net_update();
+			m_trace_mac(i);
+			m_print(Verbosity::VERBOSE) << "		Status of 0x" << std::hex << std::setfill('0') << std::setw(4) << devices[i].get_router().get_self_addr() << ": " << std::bitset<8>(devices[i].get_status()) << std::endl;
+			// if it wants to go to sleep now, add the time to the wake times
+			if (new_status & NetStatus::NET_SLEEP_RDY) {
+				schedule_wake(i);
+			}
+			else count.all_sleep = false;
+		}
+	}
+
+	// the rest of a device's turn, which goes through the whole simulation, so it's done in device order after everyone's had theirs
+	void m_finish_step(const size_t i) {
+		Stepped& step = stepped[i];
+		if (step.closed) {
+			m_print(Verbosity::ERROR) << std::hex << devices[i].get_router().get_self_addr() << " closed!" << std::endl;
+			last_error = Error::DEVICE_CLOSED;
+			step.closed = false;
+		}
+		if (step.received.empty()) return;
+		m_print(Verbosity::VERBOSE) << "	0x" << std::hex << std::setfill('0') << std::setw(4) << devices[i].get_router().get_self_addr();
+		m_print(Verbosity::VERBOSE) << " recieved: " << std::endl;
+		for (const LoomNet::Packet& buf : step.received) {
+			const LoomNet::DataPacket& frag = buf.as<LoomNet::DataPacket>();
+			trace.deliver(i, frag, get_global_time());
+			const std::string payload(reinterpret_cast<const char*>(frag.get_payload()), frag.get_payload_length());
+			m_print(Verbosity::VERBOSE) << "		" << payload << std::endl;
+			// find the packet in the tracking table, and remove it
+			// verifying it was recieved
+			// get all the packets that are outbound for this device
+			auto find_iter = send_track.equal_range(devices[i].get_router().get_self_addr());
+			auto& e = find_iter.first;
+			size_t num_slots = 0;
+			// find the one that matchs this packet
+			for (; e != find_iter.second; ++e) {
+				if (std::get<0>(e->second) == frag.get_orig_src()
+					&& std::get<1>(e->second).compare(payload) == 0) {
+					num_slots = std::get<2>(e->second);
+					break;
+				}
+			}
+			// if we didn't find one, print and error out
+			if (e == find_iter.second) {
+				// check our dupe list to see if this packet is invalid or a duplicate
+				auto find_iter_dupe = dupe_track.equal_range(devices[i].get_router().get_self_addr());
+				auto& f = find_iter_dupe.first;
+				// find the one that matchs this packet
+				for (; f != find_iter_dupe.second; ++f)
+					if (std::get<0>(f->second) == frag.get_orig_src()
+						&& std::get<1>(f->second).compare(payload) == 0)
+						break;
+				if (f == find_iter_dupe.second) 
+					m_print(Verbosity::ERROR) << "Invalid packet!" << std::endl;
+				else 
+					m_print(Verbosity::ERROR) << "Duplicated packet!" << std::endl;
+				last_error = Error::UNKNOWN_PACKET;
+			}
+			// else add the one we found to the duplicate tracker so we can find it later
+			else {
+				dupe_track.insert(*e);
+				send_track.erase(e);
+				if (on_delivered) on_delivered(devices[i].get_router().get_self_addr(), frag.get_orig_src(), payload);
+			}
+			// else print some useful data
+			m_print(Verbosity::VERBOSE) << "		From: 0x" << std::hex << std::setfill('0') << std::setw(4) << frag.get_orig_src() << std::endl;
+			m_print(Verbosity::VERBOSE) << "		Took " << std::dec << num_slots << " slots" << std::endl;
+		}
+		step.received.clear();
+	}
+
+	// anyone asleep the whole slot sleeps through everything on the air too
+	void m_find_active() {
+		const uint64_t slot_end = (cur_slot + 1) * slot_time.get_ticks();
+		for (size_t i = 0; i < devices.size(); i++)
+			medium.set_listening(i, !(devices[i].get_status() & NetStatus::NET_SLEEP_RDY) || next_wake_times[i] < slot_end);
+	}
+
+	bool m_is_parallel() const { return workers && !trace.is_enabled() && how_much != Verbosity::VERBOSE; }
+
+	// split everyone listening this slot into groups that can't reach each other, each in device order
+	void m_group_active() {
+		groups.clear();
+		std::vector<size_t> owner(devices.size(), std::numeric_limits<size_t>::max());
+		for (size_t first = 0; first < devices.size(); first++) {
+			if (!medium.is_listening(first) || owner[first] != std::numeric_limits<size_t>::max()) continue;
+			// spread out from here to everyone listening who can hear, or be heard by, someone already in the group
+			owner[first] = groups.size();
+			groups.emplace_back(1, first);
+			std::vector<size_t>& group = groups.back();
+			for (size_t next = 0; next < group.size(); next++) {
+				const size_t from = group[next];
+				for (size_t to = 0; to < devices.size(); to++) {
+					if (!medium.is_listening(to) || owner[to] != std::numeric_limits<size_t>::max()) continue;
+					if (!medium.can_hear(from, to) && !medium.can_hear(to, from)) continue;
+					owner[to] = owner[first];
+					group.push_back(to);
+				}
+			}
+			std::sort(group.begin(), group.end());
+		}
+		if (groups.size() > max_groups) max_groups = groups.size();
+	}
+
+	void m_trace_mac(const size_t index) {
+		trace.set_state(index, Trace::Track::MAC, Trace::get_name(devices[index].get_mac().get_status()), get_global_time());
+	}
+
+	template<class Archive>
+	bool m_checkpoint(Archive& archive) {
+		// check it's the same network before anything changes
+		char magic[sizeof(CHECKPOINT_MAGIC)] = {};
+		uint32_t version = CHECKPOINT_VERSION;
+		uint64_t slot_ticks = slot_time.get_ticks();
+		uint64_t loops = loops_per_slot;
+		std::vector<uint16_t> addrs = all_addrs;
+		if (!Archive::LOADING) std::copy(std::begin(CHECKPOINT_MAGIC), std::end(CHECKPOINT_MAGIC), magic);
+		archive(magic);
+		archive(version);
+		archive(slot_ticks);
+		archive(loops);
+		archive(addrs);
+		if (!archive.good()
+			|| !std::equal(std::begin(magic), std::end(magic), std::begin(CHECKPOINT_MAGIC))
+			|| version != CHECKPOINT_VERSION
+			|| slot_ticks != slot_time.get_ticks()
+			|| loops != loops_per_slot
+			|| addrs != all_addrs)
+			return false;
+		archive(max_awake);
+		archive(cur_slot);
+		archive(cur_loop);
+		archive(sample_interval);
+		archive(wake_jitter);
+		archive(rand_engine);
+		archive(jitter_rands);
+		medium.snapshot(archive);
+		for (DeviceClock& clock : clocks) clock.snapshot(archive);
+		for (NetType& device : devices) device.snapshot(archive);
+		archive(next_wake_times);
+		archive(sync_reports);
+		m_checkpoint_track(archive, send_track);
+		m_checkpoint_track(archive, dupe_track);
+		archive(last_error);
+		return archive.good();
+	}
+
+	template<class Archive>
+	static void m_checkpoint_track(Archive& archive, std::multimap<uint16_t, NetTrack>& track) {
+		uint64_t count = track.size();
+		archive(count);
+		if (Archive::LOADING) {
+			track.clear();
+			for (uint64_t i = 0; i < count && archive.good(); i++) {
+				uint16_t dst = 0;
+				NetTrack elem{ 0, "", 0 };
+				archive(dst);
+				archive(std::get<0>(elem));
+				archive(std::get<1>(elem));
+				archive(std::get<2>(elem));
+				track.emplace(dst, elem);
+			}
+		}
+		else {
+			for (auto& elem : track) {
+				uint16_t dst = elem.first;
+				archive(dst);
+				archive(std::get<0>(elem.second));
+				archive(std::get<1>(elem.second));
+				archive(std::get<2>(elem.second));
+			}
+		}
+	}
+
+	// the time of the loop closest to a time, which is when a device set to wake then actually does
+	uint64_t m_nearest_loop(const uint64_t time) const {
+		if (time == CLOCK_NONE) return time;
+		const uint64_t slot = slot_time.get_ticks();
+		const uint64_t into = time % slot;
+		const uint64_t loop = (into * loops_per_slot + slot / 2) / slot;
+		return time - into + loop * slot / loops_per_slot;
+	}
+
+	// if anyone asleep wakes up before the slot is over
+	bool m_wake_pending() const {
+		for (size_t i = 0; i < devices.size(); i++) {
+			if ((devices[i].get_status() & NetStatus::NET_SLEEP_RDY) && next_wake_times[i] < (cur_slot + 1) * slot_time.get_ticks())
+				return true;
+		}
+		return false;
+	}
+
 	std::ostream& m_print(const Verbosity v) {
-		// emptey our string stream
 		if (static_cast<size_t>(v) <= static_cast<size_t>(how_much)) return std::cout;
-		else return null_stream;
+		// every thread stepping devices gets its own place to throw things away
+		static thread_local NulStreambuf null_buf;
+		static thread_local std::ostream null_stream(&null_buf);
+		return null_stream;
 	}
 
-	std::array<uint8_t, LoomNet::PACKET_MAX> airwaves;
+	Medium medium;
+	// off until someone wants it, see Trace.h
+	Trace trace;
+	size_t max_awake;
+	std::vector<LoomNet::DeviceInfo> table;
+	LoomNet::NetworkTopology topology;
+	LoomNet::TimeTicks slot_time;
+	size_t loops_per_slot;
 	size_t cur_slot;
 	size_t cur_loop;
-	int drop_rate;
+	LoomNet::TimeTicks sample_interval;
+	std::vector<DeviceClock> clocks;
+	LoomNet::TimeTicks wake_jitter;
 	std::default_random_engine rand_engine;
+	std::vector<std::default_random_engine> jitter_rands;
 	std::vector<NetType> devices;
-	std::vector<uint32_t> next_wake_times;
+	std::vector<uint64_t> next_wake_times;
+	std::vector<SyncReport> sync_reports;
+	std::vector<Stepped> stepped;
 	std::vector<uint16_t> all_addrs;
 	std::multimap<uint16_t, NetTrack> send_track;
 	std::multimap<uint16_t, NetTrack> dupe_track;
+	// called with the destination, source and payload of every packet that makes it for the first time
+	std::function<void(uint16_t, uint16_t, const std::string&)> on_delivered;
 	const Verbosity how_much;
-	NulStreambuf null_buf;
-	std::ostream null_stream;
+	// nothing until set_threads asks for more than one
+	std::unique_ptr<WorkerPool> workers;
+	std::vector<std::vector<size_t>> groups;
+	size_t max_groups;
 	Error last_error;
 };
@@ -0,0 +1,246 @@
+#pragma once
+
+#include "../../../src/LoomNetworkPacket.h"
+#include "../../../src/LoomMAC.h"
+#include "../../../src/LoomRadio.h"
+#include <vector>
+#include <map>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <cstdint>
+
+/**
+ * A timeline of a simulation, written out in the Chrome trace event format so it opens in
+ * chrome://tracing or ui.perfetto.dev. Every device is a process with four tracks: what the
+ * MAC is doing, what the radio is doing, what it put on the air, and what the app got.
+ * Every data packet is an arrow that follows it from the device that made it, through each
+ * hop that forwarded it, to where it was delivered.
+ *
+ * Times are simulation time, which is already in microseconds like the format wants. Nothing
+ * is kept until the trace is enabled, since a long simulation makes a lot of events.
+ */
+
+class Trace {
+public:
+	enum class Track : uint8_t {
+		MAC = 1,
+		RADIO = 2,
+		AIR = 3,
+		APP = 4,
+	};
+
+	Trace()
+		: m_enabled(false)
+		, m_next_flow(1)
+		, m_last(0) {}
+
+	void enable(const bool enabled = true) { m_enabled = enabled; }
+	bool is_enabled() const { return m_enabled; }
+	// throw away everything so far, but keep the device names
+	void clear() {
+		m_events.clear();
+		m_open.clear();
+		m_flows.clear();
+		m_last = 0;
+	}
+	size_t get_event_count() const { return m_events.size(); }
+
+	void name_device(const size_t index, const std::string& name, const uint16_t addr) {
+		if (m_names.size() <= index) m_names.resize(index + 1);
+		std::ostringstream label;
+		label << name << " (0x" << std::hex << std::setfill('0') << std::setw(4) << addr << ")";
+		m_names[index] = label.str();
+	}
+
+	// the track is in this state from now on, until it changes again
+	void set_state(const size_t index, const Track track, const char* state, const uint64_t now) {
+		if (!m_enabled) return;
+		m_seen(now);
+		const auto key = std::make_pair(index, track);
+		const auto found = m_open.find(key);
+		if (found != m_open.end()) {
+			if (found->second.name == state) return;
+			m_close(key, found->second, now);
+		}
+		m_open[key] = Open{ state, now };
+	}
+
+	// a packet going out on the air, which stays there for the given time
+	void transmit(const size_t index, const LoomNet::Packet& packet, const uint64_t now, const uint64_t length) {
+		if (!m_enabled) return;
+		m_seen(now + length);
+		const LoomNet::PacketCtrl ctrl = packet.get_control();
+		std::ostringstream args;
+		args << "{\"src\":\"" << m_hex(packet.get_src()) << "\",\"length\":" << static_cast<int>(packet.get_packet_length());
+		const bool data = ctrl == LoomNet::PacketCtrl::DATA_TRANS || ctrl == LoomNet::PacketCtrl::DATA_ACK_W_DATA;
+		if (data) {
+			const LoomNet::DataPacket& frag = packet.as<LoomNet::DataPacket>();
+			args << ",\"orig_src\":\"" << m_hex(frag.get_orig_src()) << "\",\"dst\":\"" << m_hex(frag.get_dst())
+				<< "\",\"rolling_id\":" << static_cast<int>(frag.get_rolling_id());
+		}
+		args << "}";
+		m_events.push_back(Event{ 'X', m_control_name(ctrl), "air", index, Track::AIR, now, length, 0, args.str() });
+		if (!data) return;
+		// the device that made the packet starts the arrow, and every hop after it adds a step
+		const LoomNet::DataPacket& frag = packet.as<LoomNet::DataPacket>();
+		const uint32_t key = m_flow_key(frag);
+		const auto found = m_flows.find(key);
+		if (found != m_flows.end())
+			m_events.push_back(Event{ 't', "packet", "packet", index, Track::AIR, now, 0, found->second, "" });
+		// a resend of something already delivered doesn't start anything new
+		else if (frag.get_orig_src() == packet.get_src()) {
+			m_flows[key] = m_next_flow;
+			m_events.push_back(Event{ 's', "packet", "packet", index, Track::AIR, now, 0, m_next_flow++, "" });
+		}
+	}
+
+	// the app at a device got a packet, which finishes its arrow
+	void deliver(const size_t index, const LoomNet::DataPacket& frag, const uint64_t now) {
+		if (!m_enabled) return;
+		m_seen(now + 1);
+		std::ostringstream args;
+		args << "{\"orig_src\":\"" << m_hex(frag.get_orig_src()) << "\",\"rolling_id\":" << static_cast<int>(frag.get_rolling_id())
+			<< ",\"length\":" << static_cast<int>(frag.get_payload_length()) << "}";
+		m_events.push_back(Event{ 'X', "delivered", "app", index, Track::APP, now, 1, 0, args.str() });
+		const auto found = m_flows.find(m_flow_key(frag));
+		if (found == m_flows.end()) return;
+		m_events.push_back(Event{ 'f', "packet", "packet", index, Track::APP, now, 0, found->second, "" });
+		m_flows.erase(found);
+	}
+
+	// anything still going is cut off at the last thing that happened
+	void write(std::ostream& out) const {
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		bool first = true;
+		for (size_t i = 0; i < m_names.size(); i++) {
+			const size_t pid = i + 1;
+			m_write_meta(out, first, "process_name", pid, 0, "\"name\":\"" + m_escape(m_names[i]) + "\"");
+			m_write_meta(out, first, "process_sort_index", pid, 0, "\"sort_index\":" + std::to_string(i));
+			m_write_meta(out, first, "thread_name", pid, static_cast<uint8_t>(Track::MAC), "\"name\":\"MAC\"");
+			m_write_meta(out, first, "thread_name", pid, static_cast<uint8_t>(Track::RADIO), "\"name\":\"Radio\"");
+			m_write_meta(out, first, "thread_name", pid, static_cast<uint8_t>(Track::AIR), "\"name\":\"Air\"");
+			m_write_meta(out, first, "thread_name", pid, static_cast<uint8_t>(Track::APP), "\"name\":\"App\"");
+		}
+		for (const Event& event : m_events) m_write(out, first, event);
+		for (const auto& open : m_open) {
+			if (m_last > open.second.start)
+				m_write(out, first, Event{ 'X', open.second.name, "state", open.first.first, open.first.second, open.second.start, m_last - open.second.start, 0, "" });
+		}
+		out << "]}";
+	}
+
+	bool save(const std::string& path) const {
+		std::ofstream out(path, std::ios::trunc);
+		write(out);
+		return static_cast<bool>(out);
+	}
+
+	static const char* get_name(const LoomNet::MAC::State state) {
+		switch (state) {
+		case LoomNet::MAC::State::MAC_SLEEP_RDY: return "MAC_SLEEP_RDY";
+		case LoomNet::MAC::State::MAC_DATA_SEND_RDY: return "MAC_DATA_SEND_RDY";
+		case LoomNet::MAC::State::MAC_DATA_WAIT: return "MAC_DATA_WAIT";
+		case LoomNet::MAC::State::MAC_DATA_RECV_RDY: return "MAC_DATA_RECV_RDY";
+		case LoomNet::MAC::State::MAC_DATA_SEND_FAIL: return "MAC_DATA_SEND_FAIL";
+		case LoomNet::MAC::State::MAC_REFRESH_WAIT: return "MAC_REFRESH_WAIT";
+		case LoomNet::MAC::State::MAC_CLOSED: return "MAC_CLOSED";
+		}
+		return "MAC_UNKNOWN";
+	}
+
+	static const char* get_name(const LoomNet::Radio::State state) {
+		switch (state) {
+		case LoomNet::Radio::State::DISABLED: return "DISABLED";
+		case LoomNet::Radio::State::SLEEP: return "SLEEP";
+		case LoomNet::Radio::State::IDLE: return "IDLE";
+		case LoomNet::Radio::State::ERROR: return "ERROR";
+		}
+		return "UNKNOWN";
+	}
+
+private:
+	struct Event {
+		char phase;
+		std::string name;
+		const char* category;
+		size_t index;
+		Track track;
+		uint64_t start;
+		uint64_t length;
+		// which arrow, for the arrow pieces
+		uint64_t flow;
+		std::string args;
+	};
+
+	struct Open {
+		std::string name;
+		uint64_t start;
+	};
+
+	void m_seen(const uint64_t time) { if (time > m_last) m_last = time; }
+
+	void m_close(const std::pair<size_t, Track>& key, const Open& open, const uint64_t now) {
+		if (now > open.start)
+			m_events.push_back(Event{ 'X', open.name, "state", key.first, key.second, open.start, now - open.start, 0, "" });
+	}
+
+	// the rolling ID comes back around, but not before the last packet with it is long gone
+	static uint32_t m_flow_key(const LoomNet::DataPacket& frag) {
+		return static_cast<uint32_t>(frag.get_orig_src()) << 8 | frag.get_rolling_id();
+	}
+
+	static const char* m_control_name(const LoomNet::PacketCtrl ctrl) {
+		switch (ctrl) {
+		case LoomNet::PacketCtrl::REFRESH_INITIAL: return "refresh";
+		case LoomNet::PacketCtrl::REFRESH_ADDITONAL: return "refresh additional";
+		case LoomNet::PacketCtrl::DATA_TRANS: return "data";
+		case LoomNet::PacketCtrl::DATA_ACK: return "ack";
+		case LoomNet::PacketCtrl::DATA_ACK_W_DATA: return "ack with data";
+		default: return "unknown";
+		}
+	}
+
+	static std::string m_hex(const uint16_t addr) {
+		std::ostringstream out;
+		out << "0x" << std::hex << std::setfill('0') << std::setw(4) << addr;
+		return out.str();
+	}
+
+	static std::string m_escape(const std::string& text) {
+		std::string escaped;
+		for (const char c : text) {
+			if (c == '"' || c == '\\') escaped += '\\';
+			escaped += c;
+		}
+		return escaped;
+	}
+
+	static void m_write_meta(std::ostream& out, bool& first, const char* name, const size_t pid, const uint8_t tid, const std::string& args) {
+		out << (first ? "" : ",") << "\n{\"ph\":\"M\",\"name\":\"" << name << "\",\"pid\":" << pid << ",\"tid\":" << static_cast<int>(tid)
+			<< ",\"args\":{" << args << "}}";
+		first = false;
+	}
+
+	static void m_write(std::ostream& out, bool& first, const Event& event) {
+		out << (first ? "" : ",") << "\n{\"ph\":\"" << event.phase << "\",\"name\":\"" << m_escape(event.name) << "\",\"cat\":\"" << event.category
+			<< "\",\"pid\":" << event.index + 1 << ",\"tid\":" << static_cast<int>(event.track) << ",\"ts\":" << event.start;
+		if (event.phase == 'X') out << ",\"dur\":" << event.length;
+		// arrows hang off the slice they start or end in
+		else out << ",\"id\":" << event.flow << ",\"bp\":\"e\"";
+		if (!event.args.empty()) out << ",\"args\":" << event.args;
+		out << "}";
+		first = false;
+	}
+
+	bool m_enabled;
+	std::vector<std::string> m_names;
+	std::vector<Event> m_events;
+	std::map<std::pair<size_t, Track>, Open> m_open;
+	// the arrow each packet still on its way is following
+	std::map<uint32_t, uint64_t> m_flows;
+	uint64_t m_next_flow;
+	uint64_t m_last;
+};
\ No newline at end of file
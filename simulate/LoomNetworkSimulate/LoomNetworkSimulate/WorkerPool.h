@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+
+/**
+ * A handful of threads that stay around for the whole simulation, so handing them work every
+ * loop is cheap. run spreads a batch of jobs over them, with the calling thread taking its share,
+ * and comes back once every job is done. Which thread runs which job isn't fixed, so jobs must
+ * only write to things no other job in the batch touches.
+ */
+
+class WorkerPool {
+public:
+	// the calling thread is one of them
+	explicit WorkerPool(const size_t threads)
+		: m_job(nullptr)
+		, m_jobs(0)
+		, m_next(0)
+		, m_done(0)
+		, m_generation(0)
+		, m_busy(0)
+		, m_stop(false) {
+		for (size_t i = 1; i < threads; i++) m_threads.emplace_back([this] { m_work(); });
+	}
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	~WorkerPool() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for (std::thread& thread : m_threads) thread.join();
+	}
+
+	size_t size() const { return m_threads.size() + 1; }
+
+	// job(0) through job(count - 1), and back when they're all done
+	void run(const size_t count, const std::function<void(size_t)>& job) {
+		if (count == 0) return;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			// a thread that woke up late for the last batch has to be out of the way first
+			m_finished.wait(lock, [this] { return m_busy == 0; });
+			m_job = &job;
+			m_jobs = count;
+			m_next = 0;
+			m_done = 0;
+			m_generation++;
+		}
+		m_wake.notify_all();
+		m_take(job, count);
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_finished.wait(lock, [this] { return m_done == m_jobs && m_busy == 0; });
+		m_job = nullptr;
+	}
+
+private:
+	void m_work() {
+		size_t seen = 0;
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;) {
+			m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+			if (m_stop) return;
+			seen = m_generation;
+			const std::function<void(size_t)>* job = m_job;
+			const size_t jobs = m_jobs;
+			m_busy++;
+			lock.unlock();
+			if (job) m_take(*job, jobs);
+			lock.lock();
+			m_busy--;
+			m_finished.notify_all();
+		}
+	}
+
+	// keep taking the next job until there aren't any left
+	void m_take(const std::function<void(size_t)>& job, const size_t jobs) {
+		for (size_t index = m_next++; index < jobs; index = m_next++) {
+			job(index);
+			if (++m_done == jobs) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_finished.notify_all();
+			}
+		}
+	}
+
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_finished;
+	const std::function<void(size_t)>* m_job;
+	size_t m_jobs;
+	std::atomic<size_t> m_next;
+	std::atomic<size_t> m_done;
+	size_t m_generation;
+	size_t m_busy;
+	bool m_stop;
+};
\ No newline at end of file
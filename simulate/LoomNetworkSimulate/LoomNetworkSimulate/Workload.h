@@ -0,0 +1,319 @@
+#pragma once
+
+#include "TestNetwork.h"
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <random>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+/**
+ * Traffic for a TestNetwork, read from a scenario instead of written by hand:
+ * { "seed": 7,
+ *   "events": [ { "name": "door", "at": time, "every": time }, ... ],
+ *   "flows": [ { "name": "temperature", "from": "*", "to": "BillyTheCoord", "pattern": "periodic", "period": time, "payload": 6 },
+ *              { "name": "motion", "from": "End Device 1", "pattern": "poisson", "mean": time, "payload": [4, 19] },
+ *              { "name": "alarm", "from": "End Device 1", "pattern": "burst", "on": "door", "count": 4, "spacing": time },
+ *              { "name": "config", "from": "BillyTheCoord", "to": "*", "pattern": "periodic", "period": time }, ... ] }
+ * Times are { "unit": "SECOND", "time": 10 } objects, like the topology, counted from when the workload starts.
+ * "to" is the coordinator if left out, and "*" on either end means every device but the other end. A periodic
+ * flow starts at a random point in its first period unless it has an "offset", and any flow stops at its "until".
+ * Payloads are a fixed size, or a random size between the two given, and never shorter than the tag that tells
+ * which flow sent them.
+ *
+ * A parent only sends down to a child in the ack to something the child sent up, so a flow toward a device that
+ * has gone quiet waits until it speaks again.
+ *
+ * Call update before every slot: it sends everything that came due, as soon as the device has room for it.
+ */
+
+class Workload {
+public:
+	struct Stats {
+		size_t generated;
+		size_t sent;
+		size_t delivered;
+		// from when it came due to when it arrived
+		uint64_t latency_total;
+		uint64_t latency_max;
+		// the most waiting for room in the send buffer at once, on any one device
+		size_t backlog_max;
+	};
+
+	Workload()
+		: m_rand(std::random_device()())
+		, m_start(0)
+		, m_network(nullptr) {}
+
+	// false if the scenario names a device that isn't in the topology, or anything else is off, and nothing is kept
+	bool load(const JsonObjectConst& scenario, const LoomNet::NetworkTopology& topology) {
+		std::vector<Flow> flows;
+		std::vector<Event> events;
+		for (const JsonObjectConst event : scenario["events"].as<JsonArrayConst>()) {
+			const char* name = event["name"];
+			const LoomNet::TimeInterval at = LoomNet::read_time_interval(event["at"]);
+			if (!name || at.is_none()) return false;
+			const LoomNet::TimeInterval every = LoomNet::read_time_interval(event["every"]);
+			events.push_back(Event{ name, LoomNet::TimeTicks(at).get_ticks(), every.is_none() ? 0 : LoomNet::TimeTicks(every).get_ticks(), 0 });
+		}
+		for (const JsonObjectConst flow : scenario["flows"].as<JsonArrayConst>()) {
+			Flow next{};
+			const char* name = flow["name"];
+			const char* pattern = flow["pattern"];
+			if (!name || !pattern) return false;
+			next.name = name;
+			// what it sends
+			const JsonVariantConst payload = flow["payload"];
+			const JsonArrayConst range = payload.as<JsonArrayConst>();
+			next.payload_min = !range.isNull() ? range[0] | 0 : payload | 8;
+			next.payload_max = !range.isNull() ? range[1] | 0 : next.payload_min;
+			if (next.payload_max < next.payload_min || next.payload_max > PAYLOAD_MAX) return false;
+			// and when
+			if (strcmp(pattern, "periodic") == 0) {
+				next.pattern = Pattern::PERIODIC;
+				next.interval = m_read_ticks(flow["period"]);
+			}
+			else if (strcmp(pattern, "poisson") == 0) {
+				next.pattern = Pattern::POISSON;
+				next.interval = m_read_ticks(flow["mean"]);
+			}
+			else if (strcmp(pattern, "burst") == 0) {
+				next.pattern = Pattern::BURST;
+				next.interval = m_read_ticks(flow["spacing"]);
+				next.count = flow["count"] | 1;
+				const char* on = flow["on"];
+				next.event = events.size();
+				for (size_t e = 0; on && e < events.size(); e++) if (events[e].name == on) next.event = e;
+				if (next.event == events.size() || !next.count) return false;
+			}
+			else return false;
+			if (!next.interval && next.pattern != Pattern::BURST) return false;
+			const LoomNet::TimeInterval offset = LoomNet::read_time_interval(flow["offset"]);
+			next.offset = offset.is_none() ? CLOCK_NONE : LoomNet::TimeTicks(offset).get_ticks();
+			const LoomNet::TimeInterval until = LoomNet::read_time_interval(flow["until"]);
+			next.until = until.is_none() ? CLOCK_NONE : LoomNet::TimeTicks(until).get_ticks();
+			// and between who
+			const char* from = flow["from"];
+			const char* to = flow["to"] | topology.get_device(0).name;
+			if (!from) return false;
+			for (uint16_t s = 0; s < topology.get_device_count(); s++) {
+				for (uint16_t d = 0; d < topology.get_device_count(); d++) {
+					const LoomNet::DeviceInfo& src = topology.get_device(s);
+					const LoomNet::DeviceInfo& dst = topology.get_device(d);
+					if (s == d || !m_matches(from, src.name) || !m_matches(to, dst.name)) continue;
+					next.sources.push_back(Source{ src.address, dst.address, CLOCK_NONE, {}, {} });
+				}
+			}
+			if (next.sources.empty()) return false;
+			next.stats = Stats{ 0, 0, 0, 0, 0, 0 };
+			flows.push_back(next);
+		}
+		if (scenario.containsKey("seed")) m_rand.seed(scenario["seed"].as<uint32_t>());
+		m_flows = flows;
+		m_events = events;
+		m_in_flight.clear();
+		return !m_flows.empty();
+	}
+
+	// start counting time, and hear about deliveries
+	void attach(TestNetwork& network) {
+		m_network = &network;
+		m_start = network.get_global_time();
+		network.on_delivered = [this](const uint16_t dst, const uint16_t src, const std::string& payload) { m_delivered(dst, src, payload); };
+		for (Flow& flow : m_flows) {
+			for (Source& source : flow.sources) {
+				if (flow.pattern == Pattern::PERIODIC)
+					source.next = m_start + (flow.offset != CLOCK_NONE ? flow.offset
+						: std::uniform_int_distribution<uint64_t>(0, flow.interval - 1)(m_rand));
+				else if (flow.pattern == Pattern::POISSON)
+					source.next = m_start + m_exponential(flow.interval);
+			}
+		}
+		for (Event& event : m_events) event.next = m_start + event.at;
+	}
+
+	void update() {
+		if (!m_network) return;
+		const uint64_t now = m_network->get_global_time();
+		// set off any events, which start bursts
+		for (size_t e = 0; e < m_events.size(); e++) {
+			Event& event = m_events[e];
+			while (event.next <= now) {
+				for (Flow& flow : m_flows) {
+					if (flow.pattern != Pattern::BURST || flow.event != e) continue;
+					for (Source& source : flow.sources)
+						for (size_t i = 0; i < flow.count; i++) source.burst.insert(event.next + i * flow.interval);
+				}
+				event.next = event.every ? event.next + event.every : CLOCK_NONE;
+			}
+		}
+		// everything that came due goes in line
+		for (Flow& flow : m_flows) {
+			for (Source& source : flow.sources) {
+				while (source.next <= now) {
+					if (!m_stopped(flow, source.next)) m_generate(flow, source, source.next);
+					source.next = flow.pattern == Pattern::PERIODIC ? source.next + flow.interval : source.next + m_exponential(flow.interval);
+				}
+				while (!source.burst.empty() && *source.burst.begin() <= now) {
+					if (!m_stopped(flow, *source.burst.begin())) m_generate(flow, source, *source.burst.begin());
+					source.burst.erase(source.burst.begin());
+				}
+			}
+		}
+		// and goes out if there's room for it
+		m_send_waiting();
+	}
+
+	// run the network with the workload for a number of slots
+	void run(const size_t slots) {
+		for (size_t i = 0; i < slots && m_network; i++) {
+			update();
+			m_network->next_slot();
+		}
+	}
+
+	// send what's still waiting and let the network finish up, without anything new, false if it never did
+	bool drain(const size_t max_slots) {
+		for (size_t i = 0; i < max_slots && m_network; i++) {
+			if (!m_waiting() && !m_network->pending_packet_count()) return true;
+			m_send_waiting();
+			m_network->next_slot();
+		}
+		return !m_waiting() && m_network && !m_network->pending_packet_count();
+	}
+
+	size_t get_flow_count() const { return m_flows.size(); }
+	const std::string& get_name(const size_t flow) const { return m_flows[flow].name; }
+	const Stats& get_stats(const size_t flow) const { return m_flows[flow].stats; }
+
+	void print_report(std::ostream& out) const {
+		for (const Flow& flow : m_flows) {
+			const Stats& stats = flow.stats;
+			out << std::dec << flow.name << " (" << flow.sources.size() << " sources): generated " << stats.generated
+				<< ", sent " << stats.sent << ", delivered " << stats.delivered;
+			if (stats.delivered)
+				out << ", latency " << stats.latency_total / stats.delivered / 1000 << "ms average, " << stats.latency_max / 1000 << "ms worst";
+			out << ", backlog " << stats.backlog_max << std::endl;
+		}
+	}
+
+private:
+	// the most a data packet can carry
+	static constexpr uint8_t PAYLOAD_MAX = LoomNet::PACKET_MAX - LoomNet::Packet::Structure::PAYLOAD - 2 - LoomNet::DataPacket::Structure::PAYLOAD;
+
+	enum class Pattern {
+		PERIODIC,
+		POISSON,
+		BURST,
+	};
+
+	struct Source {
+		uint16_t src;
+		uint16_t dst;
+		uint64_t next;
+		std::multiset<uint64_t> burst;
+		std::deque<std::string> waiting;
+	};
+
+	struct Flow {
+		std::string name;
+		Pattern pattern;
+		uint64_t interval;
+		uint64_t offset;
+		uint64_t until;
+		size_t count;
+		size_t event;
+		uint8_t payload_min;
+		uint8_t payload_max;
+		std::vector<Source> sources;
+		size_t sequence;
+		Stats stats;
+	};
+
+	struct Event {
+		std::string name;
+		uint64_t at;
+		uint64_t every;
+		uint64_t next;
+	};
+
+	static uint64_t m_read_ticks(const JsonObjectConst& obj) {
+		const LoomNet::TimeInterval time = LoomNet::read_time_interval(obj);
+		return time.is_none() ? 0 : LoomNet::TimeTicks(time).get_ticks();
+	}
+
+	static bool m_matches(const char* pattern, const char* name) { return !strcmp(pattern, "*") || !strcmp(pattern, name); }
+
+	bool m_stopped(const Flow& flow, const uint64_t due) const { return flow.until != CLOCK_NONE && due >= m_start + flow.until; }
+
+	uint64_t m_exponential(const uint64_t mean) {
+		return static_cast<uint64_t>(std::exponential_distribution<double>(1.0 / static_cast<double>(mean))(m_rand)) + 1;
+	}
+
+	void m_generate(Flow& flow, Source& source, const uint64_t due) {
+		// tag it with the flow and a sequence number, so we know where it came from when it shows up
+		const size_t index = static_cast<size_t>(&flow - m_flows.data());
+		std::string payload = std::to_string(index) + ":" + std::to_string(flow.sequence++);
+		const size_t length = std::uniform_int_distribution<size_t>(flow.payload_min, flow.payload_max)(m_rand);
+		if (payload.size() < length) payload.resize(length, '.');
+		source.waiting.push_back(payload);
+		m_in_flight.emplace(payload, InFlight{ index, due });
+		flow.stats.generated++;
+	}
+
+	void m_send_waiting() {
+		for (Flow& flow : m_flows) {
+			for (Source& source : flow.sources) {
+				flow.stats.backlog_max = std::max(flow.stats.backlog_max, source.waiting.size());
+				while (!source.waiting.empty() && m_can_send(source.src)
+					&& m_network->send_data_and_verify(source.src, source.dst, source.waiting.front())) {
+					source.waiting.pop_front();
+					flow.stats.sent++;
+				}
+			}
+		}
+	}
+
+	bool m_can_send(const uint16_t addr) const {
+		for (const auto& device : m_network->devices) {
+			if (device.get_router().get_self_addr() == addr)
+				return (device.get_status() & TestNetwork::NetStatus::NET_SEND_RDY) != 0;
+		}
+		return false;
+	}
+
+	bool m_waiting() const {
+		for (const Flow& flow : m_flows)
+			for (const Source& source : flow.sources)
+				if (!source.waiting.empty()) return true;
+		return false;
+	}
+
+	void m_delivered(const uint16_t, const uint16_t, const std::string& payload) {
+		const auto found = m_in_flight.find(payload);
+		if (found == m_in_flight.end()) return;
+		Stats& stats = m_flows[found->second.flow].stats;
+		const uint64_t now = m_network->get_global_time();
+		const uint64_t latency = now > found->second.due ? now - found->second.due : 0;
+		stats.delivered++;
+		stats.latency_total += latency;
+		stats.latency_max = std::max(stats.latency_max, latency);
+		m_in_flight.erase(found);
+	}
+
+	struct InFlight {
+		size_t flow;
+		uint64_t due;
+	};
+
+	std::vector<Flow> m_flows;
+	std::vector<Event> m_events;
+	std::map<std::string, InFlight> m_in_flight;
+	std::default_random_engine m_rand;
+	uint64_t m_start;
+	TestNetwork* m_network;
+};
\ No newline at end of file
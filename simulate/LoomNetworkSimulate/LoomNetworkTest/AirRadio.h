@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../../../src/LoomNetwork.h"
+#include <vector>
+#include <utility>
+#include <functional>
+
+/**
+ * Just enough of a shared channel to run a coordinator and an end device against each other
+ * in a unit test, one millisecond at a time.
+ */
+
+// everything sent so far, and the time in milliseconds, shared by every radio
+struct Air {
+	std::vector<std::pair<uint32_t, LoomNet::Packet>> sent;
+	uint32_t now = 0;
+	// packets from this address never make it, to break a link on purpose
+	uint16_t lost_from = LoomNet::ADDR_NONE;
+	// or any packet this says so for, to lose one in particular
+	std::function<bool(const LoomNet::Packet&)> lose;
+};
+
+// hears whatever was sent in the last millisecond, while it's awake
+class AirRadio : public LoomNet::RadioBase {
+public:
+	explicit AirRadio(Air& air)
+		: m_air(&air)
+		, m_state(State::DISABLED)
+		, m_heard(0) {}
+
+	LoomNet::TimeTicks get_time() const { return LoomNet::TimeTicks(LoomNet::TimeInterval::MILLISECOND, m_air->now); }
+	State get_state() const { return m_state; }
+	void enable() { m_state = State::SLEEP; }
+	void disable() { m_state = State::DISABLED; }
+	void sleep() { m_state = State::SLEEP; }
+	void wake() {
+		m_state = State::IDLE;
+		m_heard = m_air->sent.size();
+	}
+	LoomNet::Packet recv(LoomNet::TimeTicks& recv_stamp) {
+		recv_stamp = get_time();
+		while (m_heard < m_air->sent.size()) {
+			const std::pair<uint32_t, LoomNet::Packet>& sent = m_air->sent[m_heard++];
+			if (sent.first + 1 >= m_air->now) return sent.second;
+		}
+		return LoomNet::Packet(LoomNet::PacketCtrl::NONE, LoomNet::ADDR_NONE);
+	}
+	void send(const LoomNet::Packet& send) {
+		if (send.get_src() != m_air->lost_from && !(m_air->lose && m_air->lose(send))) m_air->sent.emplace_back(m_air->now, send);
+		// we don't hear ourselves
+		m_heard = m_air->sent.size();
+	}
+
+private:
+	Air* m_air;
+	State m_state;
+	size_t m_heard;
+};
+
+const LoomNet::Drift AIR_DRIFT(LoomNet::TimeInterval(LoomNet::TimeInterval::MILLISECOND, 20), LoomNet::TimeInterval(LoomNet::TimeInterval::MILLISECOND, 50), LoomNet::TimeInterval(LoomNet::TimeInterval::SECOND, 1));
+const LoomNet::NetworkInfo AIR_COORD = {
+	LoomNet::Router(LoomNet::DeviceType::COORDINATOR, LoomNet::ADDR_COORD, LoomNet::ADDR_NONE, 0, 1),
+	LoomNet::Slotter(LoomNet::SLOT_NONE, 1, 2, 1, 1, 0, 0, 1),
+	AIR_DRIFT,
+	LoomNet::BATCH_FIXED };
+const LoomNet::NetworkInfo AIR_END_DEVICE = {
+	LoomNet::Router(LoomNet::DeviceType::END_DEVICE, 0x0001, LoomNet::ADDR_COORD, 0, 0),
+	LoomNet::Slotter(0, 1, 2, 1, 1),
+	AIR_DRIFT,
+	LoomNet::BATCH_FIXED };
+
+// a device's share of a millisecond: wake up if it's time, else keep going
+template<class NetType>
+void air_step(NetType& network) {
+	if (network.get_status() & NetType::Status::NET_SLEEP_RDY) {
+		if (network.net_sleep_next_wake_time() <= network.get_radio().get_time()) network.net_sleep_wake_ack();
+	}
+	else network.net_update();
+}
\ No newline at end of file
@@ -120,4 +120,20 @@ TEST_F(CircularBufferFixture, HandlesFront) {
 	EXPECT_EQ(m_buf.back().m_i, m_answer[7]) << "Unexpected back() return value: " << m_buf.back().m_i;
 }
 
+TEST(CircularBuffer, CompactIndex) {
+	// the length and start take no more than the size needs
+	static_assert(sizeof(CircularBuffer<uint8_t, 4>) == 6, "byte index");
+	static_assert(sizeof(CircularBuffer<uint8_t, 300>) == 304, "short index");
+	// and the biggest buffer with a byte index still wraps around
+	CircularBuffer<uint8_t, 255> buf;
+	for (int i = 0; i < 255; i++) EXPECT_TRUE(buf.add_back(static_cast<uint8_t>(i)));
+	EXPECT_FALSE(buf.add_back(0));
+	EXPECT_EQ(buf.size(), 255u);
+	EXPECT_TRUE(buf.destroy_front());
+	EXPECT_TRUE(buf.add_back(255));
+	EXPECT_EQ(buf.front(), 1);
+	EXPECT_EQ(buf.back(), 255);
+	EXPECT_EQ(buf[253], 254);
+}
+
 
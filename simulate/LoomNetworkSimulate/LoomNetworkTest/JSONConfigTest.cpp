@@ -7,7 +7,7 @@ class ConfigFixtureBase : public ::testing::Test {
 public:
 	ConfigFixtureBase()
 		: ::testing::Test()
-		, m_doc(4069) {}
+		, m_doc(8192) {}
 
 protected:
 
@@ -23,6 +23,37 @@ protected:
 		EXPECT_EQ(cfg.route_info, truth_router);
 		EXPECT_EQ(cfg.slot_info, truth_slotter);
 		EXPECT_EQ(cfg.drift_info, truth_drifer);
+		// the whole network compiled into a table gives the same
+		DeviceInfo table[MAX_DEVICES];
+		const NetworkInfo compiled = read_network_topology(m_doc.as<JsonObjectConst>(), name, table, MAX_DEVICES);
+		EXPECT_EQ(compiled.route_info, truth_router);
+		EXPECT_EQ(compiled.slot_info, truth_slotter);
+		EXPECT_EQ(compiled.drift_info, truth_drifer);
+	}
+
+	NetworkInfo read_stream(const char* const name) const {
+		// one character at a time, as if from a serial port
+		std::string text;
+		serializeJsonPretty(m_doc, text);
+		TopologyStream stream(name);
+		for (const char c : text) stream.write(c);
+		return stream.get_info();
+	}
+
+	void test_stream() const {
+		// every device read from the stream matches the document, as does a missing one
+		DeviceInfo table[MAX_DEVICES];
+		const NetworkTopology topology(m_doc.as<JsonObjectConst>(), table, MAX_DEVICES);
+		for (uint16_t i = 0; i < topology.get_device_count(); i++) {
+			const char* name = topology.get_device(i).name;
+			const NetworkInfo truth = topology.get_info(topology.get_device(i));
+			const NetworkInfo info = read_stream(name);
+			EXPECT_EQ(info.route_info, truth.route_info) << name;
+			EXPECT_EQ(info.slot_info, truth.slot_info) << name;
+			EXPECT_EQ(info.drift_info, truth.drift_info) << name;
+			EXPECT_EQ(info.batch_info, truth.batch_info) << name;
+		}
+		EXPECT_EQ(read_stream("Error").route_info, ROUTER_ERROR);
 	}
 
 	DynamicJsonDocument m_doc;
@@ -477,4 +508,971 @@ TEST_F(FullConfigFixture, Error) {
 		ROUTER_ERROR,
 		SLOTTER_ERROR,
 		DRIFT_ERROR);
+}
+
+TEST_F(FullConfigFixture, Compile) {
+	DeviceInfo table[MAX_DEVICES];
+	const NetworkTopology topology(m_doc.as<JsonObjectConst>(), table, MAX_DEVICES);
+	ASSERT_TRUE(topology.is_valid());
+	ASSERT_EQ(topology.get_device_count(), 16);
+	EXPECT_STREQ(topology.get_device(0).name, "Coordinator");
+	EXPECT_STREQ(topology.get_device(15).name, "Router 3 Router 1 End Device 1");
+	// every device can be found both ways, and matches the single device lookup
+	for (uint16_t i = 0; i < topology.get_device_count(); i++) {
+		const DeviceInfo& device = topology.get_device(i);
+		EXPECT_EQ(topology.find(device.name), &device);
+		EXPECT_EQ(topology.find(device.address), &device);
+		const NetworkInfo info = topology.get_info(device);
+		const NetworkInfo truth = read_network_topology(m_doc.as<JsonObjectConst>(), device.name);
+		EXPECT_EQ(info.route_info, truth.route_info);
+		EXPECT_EQ(info.slot_info, truth.slot_info);
+		EXPECT_EQ(info.drift_info, truth.drift_info);
+	}
+	EXPECT_EQ(topology.find("Error"), nullptr);
+	EXPECT_EQ(topology.find(static_cast<uint16_t>(0x4000)), nullptr);
+	EXPECT_EQ(topology.find(static_cast<uint16_t>(0x1004)), nullptr);
+}
+
+TEST_F(FullConfigFixture, Constexpr) {
+	// what LoomNetworkCodegen writes for Router 3, built entirely at compile time
+	constexpr NetworkInfo router = {
+		Router(DeviceType::FIRST_ROUTER, 0x3000, ADDR_COORD, 1, 0),
+		Slotter(22, 24, 2, 1, 1, 1, 12, 1),
+		Drift(
+			TimeInterval(TimeInterval::SECOND, 3),
+			TimeInterval(TimeInterval::SECOND, 10),
+			TimeInterval(TimeInterval::SECOND, 10)),
+		BATCH_FIXED
+	};
+	static_assert(router.route_info.get_self_addr() == 0x3000, "address");
+	static_assert(router.slot_info.get_total_slots() == 24, "total slots");
+	static_assert(!router.batch_info.is_enabled(), "batch tuner");
+	static_assert(NETWORK_ERROR.slot_info.get_total_slots() == SLOT_ERROR, "error slotter");
+	test_config("Router 3", router.route_info, router.slot_info, router.drift_info);
+}
+
+TEST_F(FullConfigFixture, CompileTooSmall) {
+	DeviceInfo table[4];
+	const NetworkTopology topology(m_doc.as<JsonObjectConst>(), table, 4);
+	EXPECT_FALSE(topology.is_valid());
+	EXPECT_EQ(topology.get_device_count(), 0);
+}
+
+TEST_F(FullConfigFixture, CompileSmallTable) {
+	// a table just big enough for the network is all the lookups need
+	DeviceInfo table[17];
+	table[16].name = "guard";
+	EXPECT_EQ(get_addr(m_doc.as<JsonObjectConst>(), "Router 1 Router 2 End Device 2", table, 16), 0x1202);
+	const NetworkInfo info = read_network_topology(m_doc.as<JsonObjectConst>(), "Router 3", table, 16);
+	const NetworkInfo truth = read_network_topology(m_doc.as<JsonObjectConst>(), "Router 3");
+	EXPECT_EQ(info.route_info, truth.route_info);
+	EXPECT_EQ(info.slot_info, truth.slot_info);
+	EXPECT_EQ(info.drift_info, truth.drift_info);
+	EXPECT_EQ(info.batch_info, truth.batch_info);
+	EXPECT_STREQ(table[16].name, "guard");
+	// and one device short fails without writing past the end
+	table[15].name = "guard";
+	EXPECT_EQ(get_addr(m_doc.as<JsonObjectConst>(), "Router 3", table, 15), ADDR_ERROR);
+	EXPECT_EQ(read_network_topology(m_doc.as<JsonObjectConst>(), "Router 3", table, 15).route_info, ROUTER_ERROR);
+	EXPECT_STREQ(table[15].name, "guard");
+}
+
+TEST_F(FullConfigFixture, LargeConfig) {
+	// a config too big for the stream to keep is still fine when it's read from the document
+	m_doc["config"]["note"] = std::string(TopologyStream::CONFIG_MAX + 88, 'x');
+	test_config("Router 1 Router 2",
+		Router(DeviceType::SECOND_ROUTER, 0x1200, 0x1000, 0, 2),
+		Slotter(5, 24, 2, 1, 1, 3, 1, 2),
+		drift_truth);
+	EXPECT_EQ(get_addr(m_doc.as<JsonObjectConst>(), "Router 1 Router 2 End Device 2"), 0x1202);
+	// but not from a stream that has to keep its own copy
+	EXPECT_EQ(read_stream("Router 1 Router 2").route_info, ROUTER_ERROR);
+}
+
+TEST_F(FullConfigFixture, TooDeep) {
+	// the address scheme only has room for two layers of routers
+	JsonObject router = m_doc["root"]["children"][1]["children"][2]["children"].as<JsonArray>().createNestedObject();
+	router["name"] = "Router 1 Router 1 Router 1";
+	router["type"] = 1;
+	EXPECT_EQ(get_addr(m_doc.as<JsonObjectConst>(), "Router 1"), ADDR_ERROR);
+	test_config("Router 1",
+		ROUTER_ERROR,
+		SLOTTER_ERROR,
+		DRIFT_ERROR);
+}
+
+TEST_F(FullConfigFixture, Address) {
+	EXPECT_EQ(get_addr(m_doc.as<JsonObjectConst>(), "Router 1 Router 2 End Device 2"), 0x1202);
+	EXPECT_EQ(get_addr(m_doc.as<JsonObjectConst>(), "Coordinator"), ADDR_COORD);
+	EXPECT_EQ(get_addr(m_doc.as<JsonObjectConst>(), "Error"), ADDR_NONE);
+}
+
+TEST_F(FullConfigFixture, Stream) {
+	test_stream();
+}
+
+TEST_F(FullConfigFixture, StreamTooDeep) {
+	JsonObject router = m_doc["root"]["children"][1]["children"][2]["children"].as<JsonArray>().createNestedObject();
+	router["name"] = "Router 1 Router 1 Router 1";
+	router["type"] = 1;
+	EXPECT_EQ(read_stream("Coordinator").route_info, ROUTER_ERROR);
+}
+
+TEST_F(FullConfigFixture, StreamTruncated) {
+	std::string text;
+	serializeJson(m_doc, text);
+	TopologyStream stream("Router 1");
+	EXPECT_TRUE(stream.write(text.c_str(), text.size() - 1));
+	EXPECT_FALSE(stream.is_done());
+	EXPECT_EQ(stream.get_info().route_info, ROUTER_ERROR);
+	EXPECT_TRUE(stream.write('}'));
+	EXPECT_TRUE(stream.is_done());
+	EXPECT_EQ(stream.get_info().route_info, Router(DeviceType::FIRST_ROUTER, 0x1000, ADDR_COORD, 2, 3));
+}
+
+TEST_F(FullConfigFixture, Spare) {
+	const char* orders[] = { "LAYERED", "LATENCY", "WAKEUPS" };
+	for (const char* order : orders) {
+		SetUp();
+		m_doc["config"]["slot_order"] = order;
+		// reserve two end devices under Router 2 and one under the coordinator, and a router with only spares
+		JsonObject root = m_doc["root"];
+		JsonObject router_2 = root["children"][2];
+		router_2["spare"] = 2;
+		root["spare"] = 1;
+		JsonObject router_4 = root["children"].as<JsonArray>().createNestedObject();
+		router_4["name"] = "Router 4";
+		router_4["type"] = 1;
+		router_4["spare"] = 2;
+		DeviceInfo before_table[MAX_DEVICES];
+		const NetworkTopology before(m_doc.as<JsonObjectConst>(), before_table, MAX_DEVICES);
+		ASSERT_TRUE(before.is_valid()) << order;
+		const Slotter spares = before.get_info(*before.find("Router 4")).slot_info;
+		EXPECT_EQ(spares.get_recv_count(), 2) << order;
+		EXPECT_LT(spares.get_recv_slot(), spares.get_total_slots()) << order;
+		test_stream();
+		// filling the spares moves nobody else
+		JsonObject added = router_2["children"].as<JsonArray>().createNestedObject();
+		added["name"] = "Router 2 End Device 2";
+		added["type"] = 0;
+		router_2["spare"] = 1;
+		added = router_4.createNestedArray("children").createNestedObject();
+		added["name"] = "Router 4 End Device 1";
+		added["type"] = 0;
+		router_4["spare"] = 1;
+		added = root["children"].as<JsonArray>().createNestedObject();
+		added["name"] = "End Device 2";
+		added["type"] = 0;
+		root.remove("spare");
+		DeviceInfo after_table[MAX_DEVICES];
+		const NetworkTopology after(m_doc.as<JsonObjectConst>(), after_table, MAX_DEVICES);
+		ASSERT_EQ(after.get_device_count(), before.get_device_count() + 3) << order;
+		for (uint16_t i = 0; i < after.get_device_count(); i++) {
+			const DeviceInfo& device = after.get_device(i);
+			const bool is_new = !strcmp(device.name, "Router 2 End Device 2") || !strcmp(device.name, "Router 4 End Device 1") || !strcmp(device.name, "End Device 2");
+			EXPECT_EQ(after.compare(device, before), is_new ? CHANGE_ADDED : CHANGE_NONE) << order << " " << device.name;
+		}
+		EXPECT_EQ(after.find("Router 4 End Device 1")->address, 0x4001);
+		EXPECT_EQ(after.get_info(*after.find("Router 4 End Device 1")).slot_info.get_send_slot(), spares.get_recv_slot()) << order;
+		test_stream();
+	}
+}
+
+TEST_F(FullConfigFixture, Compare) {
+	DeviceInfo before_table[MAX_DEVICES];
+	const NetworkTopology before(m_doc.as<JsonObjectConst>(), before_table, MAX_DEVICES);
+	// without spares, a new end device shifts the slots of everyone
+	JsonObject added = m_doc["root"]["children"][2]["children"].as<JsonArray>().createNestedObject();
+	added["name"] = "Router 2 End Device 2";
+	added["type"] = 0;
+	DeviceInfo after_table[MAX_DEVICES];
+	const NetworkTopology after(m_doc.as<JsonObjectConst>(), after_table, MAX_DEVICES);
+	EXPECT_EQ(after.compare(*after.find("Router 2 End Device 2"), before), CHANGE_ADDED);
+	EXPECT_EQ(after.compare(*after.find("Router 2"), before), CHANGE_ROUTE | CHANGE_SLOT);
+	EXPECT_EQ(after.compare(*after.find("Router 3 Router 1 End Device 1"), before), CHANGE_SLOT);
+	EXPECT_EQ(before.compare(*before.find("Router 3"), before), CHANGE_NONE);
+	// and a spare can't be reserved under an end device
+	m_doc["root"]["children"][0]["spare"] = 1;
+	test_config("Coordinator",
+		ROUTER_ERROR,
+		SLOTTER_ERROR,
+		DRIFT_ERROR);
+	EXPECT_EQ(read_stream("Coordinator").route_info, ROUTER_ERROR);
+}
+
+TEST(TopologyStreamTest, KeyOrder) {
+	// the config after the devices, and each device's children before its type and name
+	const char json[] = "{\
+\"root\":{\"children\":[\
+	{\"children\":[{\"type\":0,\"name\":\"Router 1 End Device 1\"}],\"sensor\":true,\"type\":1,\"name\":\"Router 1\"},\
+	{\"name\":\"End Device 1\",\"type\":0}\
+],\"name\":\"Coordinator\"},\
+\"config\":{\"cycles_per_batch\":2,\"cycle_gap\":1,\"batch_gap\":1,\
+	\"slot_length\":{\"unit\":\"SECOND\",\"time\":10},\
+	\"max_drift\":{\"unit\":\"SECOND\",\"time\":10},\
+	\"min_drift\":{\"unit\":\"SECOND\",\"time\":3}}\
+}";
+	TopologyStream stream("Router 1");
+	EXPECT_TRUE(stream.write(json, sizeof(json) - 1));
+	EXPECT_EQ(stream.get_device_count(), 4);
+	const NetworkInfo info = stream.get_info();
+	EXPECT_EQ(info.route_info, Router(DeviceType::FIRST_ROUTER, 0x1000, ADDR_COORD, 0, 1));
+	EXPECT_EQ(info.slot_info, Slotter(1, 4, 2, 1, 1, 2, 0, 1));
+	// a device with children can't be an end device
+	TopologyStream bad("Coordinator");
+	EXPECT_FALSE(bad.write("{\"root\":{\"name\":\"Coordinator\",\"children\":[{\"children\":[{}],\"type\":0", 66));
+}
+
+class NestedConfigFixture : public ConfigFixtureBase {
+protected:
+	const static char config[];
+
+	const Drift drift_truth{
+		TimeInterval(TimeInterval::SECOND, 3),
+		TimeInterval(TimeInterval::SECOND, 10),
+		TimeInterval(TimeInterval::SECOND, 10),
+	};
+
+	const char* get_json() const override {
+		return config;
+	}
+
+	// the same topology is placed in each nested order
+	virtual const char* get_order() const = 0;
+
+	void SetUp() override {
+		ConfigFixtureBase::SetUp();
+		m_doc["config"]["slot_order"] = get_order();
+	}
+
+	uint16_t count_wakeups() const {
+		// times per cycle any device turns its radio on, counting a router that receives
+		// straight into its own send slots once
+		DeviceInfo table[MAX_DEVICES];
+		const NetworkTopology topology(m_doc.as<JsonObjectConst>(), table, MAX_DEVICES);
+		uint16_t wakeups = 0;
+		for (uint16_t i = 0; i < topology.get_device_count(); i++) {
+			const Slotter slots = topology.get_info(topology.get_device(i)).slot_info;
+			if (slots.get_send_count()) wakeups++;
+			if (slots.get_recv_count() && slots.get_recv_slot() + slots.get_recv_count() != slots.get_send_slot()) wakeups++;
+		}
+		return wakeups;
+	}
+};
+
+const char NestedConfigFixture::config[] = "\
+{\
+\"config\":{\
+	\"cycles_per_batch\":2,\
+	\"cycle_gap\":1,\
+	\"batch_gap\":1,\
+	\"slot_length\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":10\
+	},\
+	\"max_drift\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":10\
+	},\
+	\"min_drift\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":3\
+	}\
+},\
+\"root\":{\
+	\"name\":\"Coordinator\",\
+	\"sensor\":false,\
+	\"children\":[\
+		{\
+			\"name\":\"End Device 1\",\
+			\"type\":0,\
+			\"addr\":\"0x001\"\
+		},\
+		{\
+			\"name\":\"Router 1\",\
+			\"sensor\":false,\
+			\"type\":1,\
+			\"addr\":\"0x1000\",\
+			\"children\":[\
+				{\
+					\"name\":\"Router 1 End Device 1\",\
+					\"type\":0,\
+					\"addr\":\"0x1001\"\
+				},\
+				{\
+					\"name\":\"Router 1 End Device 2\",\
+					\"type\":0,\
+					\"addr\":\"0x1002\"\
+				},\
+				{\
+					\"name\":\"Router 1 Router 1\",\
+					\"sensor\":false,\
+					\"type\":1,\
+					\"addr\":\"0x1100\",\
+					\"children\":[\
+						{\
+							\"name\":\"Router 1 Router 1 End Device 1\",\
+							\"type\":0,\
+							\"addr\":\"0x1101\"\
+						}\
+					]\
+				},\
+				{\
+					\"name\":\"Router 1 Router 2\",\
+					\"sensor\":true,\
+					\"type\":1,\
+					\"addr\":\"0x1200\",\
+					\"children\":[\
+						{\
+							\"name\":\"Router 1 Router 2 End Device 1\",\
+							\"type\":0,\
+							\"addr\":\"0x1001\"\
+						},\
+						{\
+							\"name\":\"Router 1 Router 2 End Device 2\",\
+							\"type\":0,\
+							\"addr\":\"0x1202\"\
+						}\
+					]\
+				},\
+				{\
+					\"name\":\"Router 1 End Device 3\",\
+					\"type\":0,\
+					\"addr\":\"0x1003\"\
+				}\
+			]\
+		},\
+		{\
+			\"name\":\"Router 2\",\
+			\"sensor\":true,\
+			\"type\":1,\
+			\"addr\":\"0x2000\",\
+			\"children\":[\
+				{\
+					\"name\":\"Router 2 End Device 1\",\
+					\"type\":0,\
+					\"addr\":\"0x2001\"\
+				}\
+			]\
+		},\
+		{\
+			\"name\":\"Router 3\",\
+			\"sensor\":false,\
+			\"type\":1,\
+			\"addr\":\"0x3000\",\
+			\"children\":[\
+				{\
+					\"name\":\"Router 3 Router 1\",\
+					\"sensor\":false,\
+					\"type\":1,\
+					\"addr\":\"0x3100\",\
+					\"children\":[\
+						{\
+							\"name\":\"Router 3 Router 1 End Device 1\",\
+							\"type\":0,\
+							\"addr\":\"0x3101\"\
+						}\
+					]\
+				}\
+			]\
+		}\
+	]\
+}}";
+
+class LatencyConfigFixture : public NestedConfigFixture {
+protected:
+	const char* get_order() const override {
+		return "LATENCY";
+	}
+};
+
+class WakeupConfigFixture : public NestedConfigFixture {
+protected:
+	const char* get_order() const override {
+		return "WAKEUPS";
+	}
+};
+
+TEST_F(LatencyConfigFixture, Router3Router1EndDevice1) {
+	test_config("Router 3 Router 1 End Device 1",
+		Router(DeviceType::END_DEVICE, 0x3101, 0x3100, 0, 0),
+		Slotter(0, 24, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(LatencyConfigFixture, Router3Router1) {
+	test_config("Router 3 Router 1",
+		Router(DeviceType::SECOND_ROUTER, 0x3100, 0x3000, 0, 1),
+		Slotter(1, 24, 2, 1, 1, 1, 0, 1),
+		drift_truth);
+}
+
+TEST_F(LatencyConfigFixture, Router3) {
+	test_config("Router 3",
+		Router(DeviceType::FIRST_ROUTER, 0x3000, ADDR_COORD, 1, 0),
+		Slotter(22, 24, 2, 1, 1, 1, 1, 1),
+		drift_truth);
+}
+
+TEST_F(LatencyConfigFixture, Router2EndDevice1) {
+	test_config("Router 2 End Device 1",
+		Router(DeviceType::END_DEVICE, 0x2001, 0x2000, 0, 0),
+		Slotter(12, 24, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(LatencyConfigFixture, Router2) {
+	test_config("Router 2",
+		Router(DeviceType::FIRST_ROUTER, 0x2000, ADDR_COORD, 0, 1),
+		Slotter(13, 24, 2, 1, 1, 2, 12, 1),
+		drift_truth);
+}
+
+TEST_F(LatencyConfigFixture, Router1EndDevice3) {
+	test_config("Router 1 End Device 3",
+		Router(DeviceType::END_DEVICE, 0x1003, 0x1000, 0, 0),
+		Slotter(11, 24, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(LatencyConfigFixture, Router1Router2) {
+	test_config("Router 1 Router 2",
+		Router(DeviceType::SECOND_ROUTER, 0x1200, 0x1000, 0, 2),
+		Slotter(5, 24, 2, 1, 1, 3, 3, 2),
+		drift_truth);
+}
+
+TEST_F(LatencyConfigFixture, Router1Router2EndDevice2) {
+	test_config("Router 1 Router 2 End Device 2",
+		Router(DeviceType::END_DEVICE, 0x1202, 0x1200, 0, 0),
+		Slotter(4, 24, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(LatencyConfigFixture, Router1Router1) {
+	test_config("Router 1 Router 1",
+		Router(DeviceType::SECOND_ROUTER, 0x1100, 0x1000, 0, 1),
+		Slotter(8, 24, 2, 1, 1, 1, 2, 1),
+		drift_truth);
+}
+
+TEST_F(LatencyConfigFixture, Router1Router1EndDevice1) {
+	test_config("Router 1 Router 1 End Device 1",
+		Router(DeviceType::END_DEVICE, 0x1101, 0x1100, 0, 0),
+		Slotter(2, 24, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(LatencyConfigFixture, Router1) {
+	test_config("Router 1",
+		Router(DeviceType::FIRST_ROUTER, 0x1000, ADDR_COORD, 2, 3),
+		Slotter(15, 24, 2, 1, 1, 7, 5, 7),
+		drift_truth);
+}
+
+TEST_F(LatencyConfigFixture, EndDevice1) {
+	test_config("End Device 1",
+		Router(DeviceType::END_DEVICE, 0x0001, ADDR_COORD, 0, 0),
+		Slotter(23, 24, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(LatencyConfigFixture, Coordinator) {
+	test_config("Coordinator",
+		Router(DeviceType::COORDINATOR, ADDR_COORD, ADDR_NONE, 3, 1),
+		Slotter(SLOT_NONE, 24, 2, 1, 1, 0, 13, 11),
+		drift_truth);
+}
+
+TEST_F(WakeupConfigFixture, Router3Router1EndDevice1) {
+	test_config("Router 3 Router 1 End Device 1",
+		Router(DeviceType::END_DEVICE, 0x3101, 0x3100, 0, 0),
+		Slotter(0, 24, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(WakeupConfigFixture, Router3Router1) {
+	test_config("Router 3 Router 1",
+		Router(DeviceType::SECOND_ROUTER, 0x3100, 0x3000, 0, 1),
+		Slotter(1, 24, 2, 1, 1, 1, 0, 1),
+		drift_truth);
+}
+
+TEST_F(WakeupConfigFixture, Router3) {
+	test_config("Router 3",
+		Router(DeviceType::FIRST_ROUTER, 0x3000, ADDR_COORD, 1, 0),
+		Slotter(22, 24, 2, 1, 1, 1, 1, 1),
+		drift_truth);
+}
+
+TEST_F(WakeupConfigFixture, Router2EndDevice1) {
+	test_config("Router 2 End Device 1",
+		Router(DeviceType::END_DEVICE, 0x2001, 0x2000, 0, 0),
+		Slotter(2, 24, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(WakeupConfigFixture, Router2) {
+	test_config("Router 2",
+		Router(DeviceType::FIRST_ROUTER, 0x2000, ADDR_COORD, 0, 1),
+		Slotter(20, 24, 2, 1, 1, 2, 2, 1),
+		drift_truth);
+}
+
+TEST_F(WakeupConfigFixture, Router1EndDevice3) {
+	test_config("Router 1 End Device 3",
+		Router(DeviceType::END_DEVICE, 0x1003, 0x1000, 0, 0),
+		Slotter(12, 24, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(WakeupConfigFixture, Router1Router2) {
+	test_config("Router 1 Router 2",
+		Router(DeviceType::SECOND_ROUTER, 0x1200, 0x1000, 0, 2),
+		Slotter(7, 24, 2, 1, 1, 3, 3, 2),
+		drift_truth);
+}
+
+TEST_F(WakeupConfigFixture, Router1Router2EndDevice2) {
+	test_config("Router 1 Router 2 End Device 2",
+		Router(DeviceType::END_DEVICE, 0x1202, 0x1200, 0, 0),
+		Slotter(4, 24, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(WakeupConfigFixture, Router1Router1) {
+	test_config("Router 1 Router 1",
+		Router(DeviceType::SECOND_ROUTER, 0x1100, 0x1000, 0, 1),
+		Slotter(6, 24, 2, 1, 1, 1, 5, 1),
+		drift_truth);
+}
+
+TEST_F(WakeupConfigFixture, Router1Router1EndDevice1) {
+	test_config("Router 1 Router 1 End Device 1",
+		Router(DeviceType::END_DEVICE, 0x1101, 0x1100, 0, 0),
+		Slotter(5, 24, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(WakeupConfigFixture, Router1) {
+	test_config("Router 1",
+		Router(DeviceType::FIRST_ROUTER, 0x1000, ADDR_COORD, 2, 3),
+		Slotter(13, 24, 2, 1, 1, 7, 6, 7),
+		drift_truth);
+}
+
+TEST_F(WakeupConfigFixture, EndDevice1) {
+	test_config("End Device 1",
+		Router(DeviceType::END_DEVICE, 0x0001, ADDR_COORD, 0, 0),
+		Slotter(23, 24, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(WakeupConfigFixture, Coordinator) {
+	test_config("Coordinator",
+		Router(DeviceType::COORDINATOR, ADDR_COORD, ADDR_NONE, 3, 1),
+		Slotter(SLOT_NONE, 24, 2, 1, 1, 0, 13, 11),
+		drift_truth);
+}
+
+TEST_F(WakeupConfigFixture, Wakeups) {
+	// configuration order saves nothing over LATENCY: in any nested order only the first router
+	// under each parent receives straight into its send slots, and every other router wakes twice
+	EXPECT_EQ(count_wakeups(), 19);
+	m_doc["config"]["slot_order"] = "LATENCY";
+	EXPECT_EQ(count_wakeups(), 19);
+}
+
+class BadOrderConfigFixture : public ConfigFixtureBase {
+protected:
+	const static char config[];
+
+	const char* get_json() const override {
+		return config;
+	}
+};
+
+const char BadOrderConfigFixture::config[] = "\
+{\
+\"config\":{\
+	\"cycles_per_batch\":2,\
+	\"cycle_gap\":1,\
+	\"batch_gap\":1,\
+	\"slot_order\":\"FASTEST\",\
+	\"slot_length\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":10\
+	},\
+	\"max_drift\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":10\
+	},\
+	\"min_drift\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":3\
+	}\
+},\
+\"root\":{\
+	\"name\":\"Coordinator\",\
+	\"children\":[\
+		{\
+			\"name\":\"End Device 1\",\
+			\"type\":0\
+		}\
+	]\
+}}";
+
+TEST_F(BadOrderConfigFixture, Error) {
+	test_config("End Device 1",
+		ROUTER_ERROR,
+		SLOTTER_ERROR,
+		DRIFT_ERROR);
+}
+
+class GroupConfigFixture : public ConfigFixtureBase {
+protected:
+	const static char config[];
+
+	const Drift drift_truth{
+		TimeInterval(TimeInterval::SECOND, 3),
+		TimeInterval(TimeInterval::SECOND, 10),
+		TimeInterval(TimeInterval::SECOND, 10),
+	};
+
+	const char* get_json() const override {
+		return config;
+	}
+};
+
+const char GroupConfigFixture::config[] = "\
+{\
+\"config\":{\
+	\"cycles_per_batch\":2,\
+	\"cycle_gap\":1,\
+	\"batch_gap\":1,\
+	\"slot_order\":\"LATENCY\",\
+	\"slot_length\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":10\
+	},\
+	\"max_drift\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":10\
+	},\
+	\"min_drift\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":3\
+	}\
+},\
+\"root\":{\
+	\"name\":\"Coordinator\",\
+	\"children\":[\
+		{\
+			\"name\":\"Router 1\",\
+			\"type\":1,\
+			\"sensor\":true,\
+			\"group\":1,\
+			\"children\":[\
+				{\
+					\"name\":\"Router 1 End Device 1\",\
+					\"type\":0\
+				},\
+				{\
+					\"name\":\"Router 1 End Device 2\",\
+					\"type\":0\
+				}\
+			]\
+		},\
+		{\
+			\"name\":\"Router 2\",\
+			\"type\":1,\
+			\"sensor\":true,\
+			\"group\":2,\
+			\"children\":[\
+				{\
+					\"name\":\"Router 2 End Device 1\",\
+					\"type\":0\
+				},\
+				{\
+					\"name\":\"Router 2 End Device 2\",\
+					\"type\":0\
+				}\
+			]\
+		},\
+		{\
+			\"name\":\"End Device 1\",\
+			\"type\":0\
+		}\
+	]\
+}}";
+
+TEST_F(GroupConfigFixture, Router2EndDevice2) {
+	test_config("Router 2 End Device 2",
+		Router(DeviceType::END_DEVICE, 0x2002, 0x2000, 0, 0),
+		Slotter(1, 9, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(GroupConfigFixture, Router2EndDevice1) {
+	test_config("Router 2 End Device 1",
+		Router(DeviceType::END_DEVICE, 0x2001, 0x2000, 0, 0),
+		Slotter(0, 9, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(GroupConfigFixture, Router2) {
+	test_config("Router 2",
+		Router(DeviceType::FIRST_ROUTER, 0x2000, ADDR_COORD, 0, 2),
+		Slotter(5, 9, 2, 1, 1, 3, 0, 2),
+		drift_truth);
+}
+
+TEST_F(GroupConfigFixture, Router1EndDevice2) {
+	test_config("Router 1 End Device 2",
+		Router(DeviceType::END_DEVICE, 0x1002, 0x1000, 0, 0),
+		Slotter(1, 9, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(GroupConfigFixture, Router1EndDevice1) {
+	test_config("Router 1 End Device 1",
+		Router(DeviceType::END_DEVICE, 0x1001, 0x1000, 0, 0),
+		Slotter(0, 9, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(GroupConfigFixture, Router1) {
+	test_config("Router 1",
+		Router(DeviceType::FIRST_ROUTER, 0x1000, ADDR_COORD, 0, 2),
+		Slotter(2, 9, 2, 1, 1, 3, 0, 2),
+		drift_truth);
+}
+
+TEST_F(GroupConfigFixture, EndDevice1) {
+	test_config("End Device 1",
+		Router(DeviceType::END_DEVICE, 0x0001, ADDR_COORD, 0, 0),
+		Slotter(8, 9, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(GroupConfigFixture, Coordinator) {
+	test_config("Coordinator",
+		Router(DeviceType::COORDINATOR, ADDR_COORD, ADDR_NONE, 2, 1),
+		Slotter(SLOT_NONE, 9, 2, 1, 1, 0, 2, 7),
+		drift_truth);
+}
+
+class LayeredGroupConfigFixture : public ConfigFixtureBase {
+protected:
+	const static char config[];
+
+	const char* get_json() const override {
+		return config;
+	}
+};
+
+const char LayeredGroupConfigFixture::config[] = "\
+{\
+\"config\":{\
+	\"cycles_per_batch\":2,\
+	\"cycle_gap\":1,\
+	\"batch_gap\":1,\
+	\"slot_length\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":10\
+	},\
+	\"max_drift\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":10\
+	},\
+	\"min_drift\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":3\
+	}\
+},\
+\"root\":{\
+	\"name\":\"Coordinator\",\
+	\"children\":[\
+		{\
+			\"name\":\"Router 1\",\
+			\"type\":1,\
+			\"group\":1,\
+			\"children\":[\
+				{\
+					\"name\":\"Router 1 End Device 1\",\
+					\"type\":0\
+				}\
+			]\
+		}\
+	]\
+}}";
+
+TEST_F(GroupConfigFixture, Stream) {
+	test_stream();
+}
+
+TEST_F(LayeredGroupConfigFixture, Error) {
+	test_config("Router 1",
+		ROUTER_ERROR,
+		SLOTTER_ERROR,
+		DRIFT_ERROR);
+}
+
+class AdaptiveConfigFixture : public ConfigFixtureBase {
+protected:
+	const static char config[];
+
+	const char* get_json() const override {
+		return config;
+	}
+};
+
+const char AdaptiveConfigFixture::config[] = "\
+{\
+\"config\":{\
+	\"cycles_per_batch\":2,\
+	\"cycle_gap\":1,\
+	\"batch_gap\":1,\
+	\"adaptive\":{\
+		\"cycles_per_batch\":[2, 4],\
+		\"cycle_gap\":[1, 3]\
+	},\
+	\"slot_length\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":10\
+	},\
+	\"max_drift\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":10\
+	},\
+	\"min_drift\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":3\
+	}\
+},\
+\"root\":{\
+	\"name\":\"Coordinator\",\
+	\"children\":[\
+		{\
+			\"name\":\"End Device 1\",\
+			\"type\":0\
+		}\
+	]\
+}}";
+
+TEST_F(AdaptiveConfigFixture, Coordinator) {
+	const NetworkInfo cfg = read_network_topology(m_doc.as<JsonObjectConst>(), "Coordinator");
+	EXPECT_EQ(cfg.slot_info, Slotter(SLOT_NONE, 1, 2, 1, 1, 0, 0, 1));
+	EXPECT_EQ(cfg.batch_info, BatchTuner(2, 4, 1, 3, 1, 1, 2));
+}
+
+TEST_F(AdaptiveConfigFixture, EndDevice1) {
+	const NetworkInfo cfg = read_network_topology(m_doc.as<JsonObjectConst>(), "End Device 1");
+	EXPECT_EQ(cfg.slot_info, Slotter(0, 1, 2, 1, 1));
+	EXPECT_EQ(cfg.batch_info, BATCH_FIXED);
+}
+
+TEST_F(AdaptiveConfigFixture, Stream) {
+	test_stream();
+}
+
+TEST_F(AdaptiveConfigFixture, Error) {
+	// the configured value has to be inside the range
+	m_doc["config"]["adaptive"]["cycle_gap"][0] = 2;
+	test_config("Coordinator",
+		ROUTER_ERROR,
+		SLOTTER_ERROR,
+		DRIFT_ERROR);
+}
+
+class RadioConfigFixture : public ConfigFixtureBase {
+protected:
+	const static char config[];
+
+	const Drift drift_truth{
+		TimeInterval(TimeInterval::MILLISECOND, 353),
+		TimeInterval(TimeInterval::MILLISECOND, 20),
+		TimeInterval(TimeInterval::MILLISECOND, 373),
+	};
+
+	const char* get_json() const override {
+		return config;
+	}
+};
+
+const char RadioConfigFixture::config[] = "\
+{\
+\"config\":{\
+	\"cycles_per_batch\":2,\
+	\"cycle_gap\":1,\
+	\"batch_gap\":1,\
+	\"radio\":{\
+		\"modem\":[146, 160, 4],\
+		\"preamble\":12\
+	},\
+	\"max_drift\":{\
+		\"unit\":\"MILLISECOND\",\
+		\"time\":20\
+	}\
+},\
+\"root\":{\
+	\"name\":\"Coordinator\",\
+	\"children\":[\
+		{\
+			\"name\":\"End Device 1\",\
+			\"type\":0\
+		}\
+	]\
+}}";
+
+TEST_F(RadioConfigFixture, EndDevice1) {
+	test_config("End Device 1",
+		Router(DeviceType::END_DEVICE, 0x0001, ADDR_COORD, 0, 0),
+		Slotter(0, 1, 2, 1, 1),
+		drift_truth);
+}
+
+TEST_F(RadioConfigFixture, Turnaround) {
+	// a slower turnaround makes everything longer
+	JsonObject turnaround = m_doc["config"]["radio"].createNestedObject("turnaround");
+	turnaround["unit"] = "MILLISECOND";
+	turnaround["time"] = 20;
+	test_config("End Device 1",
+		Router(DeviceType::END_DEVICE, 0x0001, ADDR_COORD, 0, 0),
+		Slotter(0, 1, 2, 1, 1),
+		Drift(TimeInterval(TimeInterval::MILLISECOND, 383), TimeInterval(TimeInterval::MILLISECOND, 20), TimeInterval(TimeInterval::MILLISECOND, 403)));
+}
+
+TEST_F(RadioConfigFixture, LongerSlot) {
+	// set by hand, but still long enough
+	JsonObject slot_length = m_doc["config"].createNestedObject("slot_length");
+	slot_length["unit"] = "SECOND";
+	slot_length["time"] = 1;
+	test_config("End Device 1",
+		Router(DeviceType::END_DEVICE, 0x0001, ADDR_COORD, 0, 0),
+		Slotter(0, 1, 2, 1, 1),
+		Drift(drift_truth.min_drift, drift_truth.max_drift, TimeInterval(TimeInterval::SECOND, 1)));
+}
+
+TEST_F(RadioConfigFixture, ShortSlot) {
+	// set by hand, but too short for the handshake
+	JsonObject slot_length = m_doc["config"].createNestedObject("slot_length");
+	slot_length["unit"] = "MILLISECOND";
+	slot_length["time"] = 300;
+	test_config("End Device 1",
+		ROUTER_ERROR,
+		SLOTTER_ERROR,
+		DRIFT_ERROR);
+}
+
+TEST_F(RadioConfigFixture, Stream) {
+	test_stream();
+}
+
+TEST_F(RadioConfigFixture, BadModem) {
+	m_doc["config"]["radio"]["modem"][0] = 255;
+	test_config("End Device 1",
+		ROUTER_ERROR,
+		SLOTTER_ERROR,
+		DRIFT_ERROR);
 }
\ No newline at end of file
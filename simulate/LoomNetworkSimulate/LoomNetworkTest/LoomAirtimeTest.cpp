@@ -0,0 +1,64 @@
+#include "pch.h"
+#include "../../../src/LoomAirtime.h"
+
+using namespace LoomNet;
+
+TEST(LoraAirtime, Decode) {
+	// LoraRadio's setup
+	const LoraAirtime airtime(0b10010010, 0b10100000, 0x04, 12);
+
+	EXPECT_TRUE(airtime.is_valid());
+	EXPECT_EQ(airtime.get_bandwidth(), 500000u);
+	EXPECT_EQ(airtime.get_spreading_factor(), 10);
+	EXPECT_EQ(airtime.get_coding_rate(), 5);
+	EXPECT_TRUE(airtime.has_explicit_header());
+	EXPECT_FALSE(airtime.has_crc());
+	EXPECT_FALSE(airtime.has_low_rate_optimize());
+	EXPECT_EQ(airtime.get_symbol_time(), 2048u);
+}
+
+TEST(LoraAirtime, Invalid) {
+	// bandwidth out of range
+	EXPECT_FALSE(LoraAirtime(0xA2, 0x74, 0x04, 8).is_valid());
+	// spreading factor out of range
+	EXPECT_FALSE(LoraAirtime(0x72, 0xD4, 0x04, 8).is_valid());
+	// spreading factor 6 needs implicit header mode
+	EXPECT_FALSE(LoraAirtime(0x72, 0x64, 0x04, 8).is_valid());
+	EXPECT_TRUE(LoraAirtime(0x73, 0x64, 0x04, 8).is_valid());
+	EXPECT_EQ(LoraAirtime(0xA2, 0x74, 0x04, 8).get_airtime(PACKET_MAX), 0u);
+}
+
+TEST(LoraAirtime, Airtime) {
+	// radio defaults: 125kHz, 4/5, SF7, CRC on
+	EXPECT_EQ(LoraAirtime(0x72, 0x74, 0x04, 8).get_airtime(10), 41216u);
+	// SF12 with low data rate optimize
+	EXPECT_EQ(LoraAirtime(0x72, 0xC4, 0x0C, 8).get_airtime(PACKET_MAX), 1810432u);
+	// LoraRadio's setup
+	const LoraAirtime airtime(0b10010010, 0b10100000, 0x04, 12);
+	EXPECT_EQ(airtime.get_airtime(PACKET_MAX), 121344u);
+	EXPECT_EQ(airtime.get_airtime(LoraAirtime::ACK_LENGTH), 59904u);
+}
+
+TEST(LoraAirtime, Timings) {
+	const LoraAirtime airtime(0b10010010, 0b10100000, 0x04, 12);
+
+	EXPECT_EQ(airtime.get_handshake_time(), 121344 * 2 + 59904 + LoraAirtime::TURNAROUND_US * 3);
+	EXPECT_EQ(airtime.get_handshake_time(0), 121344u * 2 + 59904);
+	// rounded up to the millisecond, plus the drift
+	const TimeInterval drift(TimeInterval::MILLISECOND, 20);
+	EXPECT_EQ(airtime.get_min_drift(drift), TimeInterval(TimeInterval::MILLISECOND, 353));
+	EXPECT_EQ(airtime.get_slot_length(drift), TimeInterval(TimeInterval::MILLISECOND, 373));
+	// anything bad stays bad
+	EXPECT_TRUE(airtime.get_slot_length(TIME_NONE).is_none());
+	EXPECT_TRUE(LoraAirtime(0xA2, 0x74, 0x04, 8).get_slot_length(drift).is_none());
+}
+
+TEST(LoraAirtime, SampleInterval) {
+	// 8.25 + 4.25 - 6 symbols of 1024us
+	EXPECT_EQ(LoraAirtime(0x72, 0x74, 0x04, 8).get_sample_interval(), 6400u);
+	// LoraRadio's setup
+	EXPECT_EQ(LoraAirtime(0b10010010, 0b10100000, 0x04, 12).get_sample_interval(), 20992u);
+	// too short to catch, or no radio at all
+	EXPECT_EQ(LoraAirtime(0x72, 0x74, 0x04, 1).get_sample_interval(), 0u);
+	EXPECT_EQ(LoraAirtime(0xA2, 0x74, 0x04, 8).get_sample_interval(), 0u);
+}
\ No newline at end of file
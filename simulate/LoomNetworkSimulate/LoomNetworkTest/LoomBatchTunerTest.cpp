@@ -0,0 +1,137 @@
+#include "pch.h"
+#include "../../../src/LoomBatchTuner.h"
+#include "AirRadio.h"
+
+using namespace LoomNet;
+
+// simulate a batch with a given number of busy recieve slots out of ten
+static void run_batch(BatchTuner& tuner, const uint8_t busy) {
+	for (uint8_t i = 0; i < 10; i++) {
+		tuner.count_slot();
+		if (i < busy) tuner.count_busy();
+	}
+}
+
+TEST(BatchTuner, Fixed) {
+	BatchTuner tuner = BATCH_FIXED;
+	Slotter slotter(SLOT_NONE, 24, 2, 1, 1, 0, 13, 11);
+
+	run_batch(tuner, 10);
+	ASSERT_FALSE(tuner.tune(slotter));
+	ASSERT_EQ(slotter, Slotter(SLOT_NONE, 24, 2, 1, 1, 0, 13, 11));
+}
+
+TEST(BatchTuner, NoTraffic) {
+	BatchTuner tuner(2, 4, 1, 4, 1, 4, 1);
+	Slotter slotter(SLOT_NONE, 24, 2, 1, 1, 0, 13, 11);
+
+	// no recieve slots have happened yet
+	ASSERT_FALSE(tuner.tune(slotter));
+}
+
+TEST(BatchTuner, Idle) {
+	BatchTuner tuner(2, 4, 1, 3, 1, 2, 1);
+	Slotter slotter(SLOT_NONE, 24, 3, 1, 1, 0, 13, 11);
+
+	// grow the cycle gap, then the batch gap, then drop cycles
+	const uint8_t answers[][3] = { { 3, 2, 1 }, { 3, 3, 1 }, { 3, 3, 2 }, { 2, 3, 2 } };
+	for (const auto& ex : answers) {
+		run_batch(tuner, 0);
+		ASSERT_TRUE(tuner.tune(slotter));
+		EXPECT_EQ(slotter.get_cycles_per_refresh(), ex[0]);
+		EXPECT_EQ(slotter.get_cycle_gap(), ex[1]);
+		EXPECT_EQ(slotter.get_batch_gap(), ex[2]);
+	}
+	// out of room
+	run_batch(tuner, 0);
+	ASSERT_FALSE(tuner.tune(slotter));
+	EXPECT_EQ(tuner.get_trend(), BatchTuner::Trend::IDLE);
+}
+
+TEST(BatchTuner, Busy) {
+	BatchTuner tuner(2, 3, 1, 3, 0, 2, 1);
+	Slotter slotter(SLOT_NONE, 24, 2, 2, 1, 0, 13, 11);
+
+	// shrink the cycle gap, then the batch gap, then add cycles
+	const uint8_t answers[][3] = { { 2, 1, 1 }, { 2, 1, 0 }, { 3, 1, 0 } };
+	for (const auto& ex : answers) {
+		run_batch(tuner, 9);
+		ASSERT_TRUE(tuner.tune(slotter));
+		EXPECT_EQ(slotter.get_cycles_per_refresh(), ex[0]);
+		EXPECT_EQ(slotter.get_cycle_gap(), ex[1]);
+		EXPECT_EQ(slotter.get_batch_gap(), ex[2]);
+	}
+	run_batch(tuner, 10);
+	ASSERT_FALSE(tuner.tune(slotter));
+	EXPECT_EQ(tuner.get_last_load(), 100);
+}
+
+TEST(BatchTuner, Hysteresis) {
+	BatchTuner tuner(2, 4, 1, 4, 1, 4, 2);
+	Slotter slotter(SLOT_NONE, 24, 2, 2, 1, 0, 13, 11);
+
+	// a single busy batch isn't enough
+	run_batch(tuner, 8);
+	ASSERT_FALSE(tuner.tune(slotter));
+	// neither is bouncing between busy and idle
+	run_batch(tuner, 1);
+	ASSERT_FALSE(tuner.tune(slotter));
+	run_batch(tuner, 8);
+	ASSERT_FALSE(tuner.tune(slotter));
+	// the dead band resets the streak too
+	run_batch(tuner, 5);
+	ASSERT_FALSE(tuner.tune(slotter));
+	EXPECT_EQ(tuner.get_trend(), BatchTuner::Trend::STEADY);
+	run_batch(tuner, 8);
+	ASSERT_FALSE(tuner.tune(slotter));
+	// but two in a row is
+	run_batch(tuner, 8);
+	ASSERT_TRUE(tuner.tune(slotter));
+	EXPECT_EQ(slotter.get_cycle_gap(), 1);
+	// and the streak starts over after a change
+	run_batch(tuner, 8);
+	ASSERT_FALSE(tuner.tune(slotter));
+}
+
+TEST(BatchTuner, MissedRefresh) {
+	Air air;
+	// idle, so the batch drops from four cycles to two a cycle at a time, and then stays there
+	// each step brings the refresh two slots sooner, which is well outside where the end device would look for it
+	const NetworkInfo tuned_coord = { AIR_COORD.route_info, Slotter(SLOT_NONE, 1, 4, 1, 1, 0, 0, 1), AIR_DRIFT, BatchTuner(2, 4, 1, 1, 1, 1, 1) };
+	const NetworkInfo end_device_info = { AIR_END_DEVICE.route_info, Slotter(0, 1, 4, 1, 1), AIR_DRIFT, BATCH_FIXED };
+	// the end device never hears the refresh with the first change in it
+	uint8_t first_cycles = 0;
+	bool lost = false;
+	uint32_t next_refresh = 0;
+	air.lose = [&](const Packet& packet) {
+		if (packet.get_control() != PacketCtrl::REFRESH_INITIAL) return false;
+		if (lost) {
+			if (!next_refresh) next_refresh = air.now;
+			return false;
+		}
+		const uint8_t cycles = packet.as<RefreshPacket>().get_cycles_per_batch();
+		if (!first_cycles) first_cycles = cycles;
+		return lost = cycles != first_cycles;
+	};
+	Network<AirRadio> coord(tuned_coord, AirRadio(air));
+	Network<AirRadio> end_device(end_device_info, AirRadio(air));
+	// run through the refresh after the lost one, the end device going first so it's listening for the very first
+	for (; air.now < 60000 && (!next_refresh || air.now < next_refresh + 100); air.now++) {
+		air_step(end_device);
+		air_step(coord);
+	}
+	ASSERT_TRUE(lost);
+	EXPECT_EQ(coord.get_mac().get_slotter().get_cycles_per_refresh(), 2);
+	// instead of guessing with the old batch, it listened for the next refresh and took the new one
+	EXPECT_EQ(end_device.get_mac().get_slotter().get_cycles_per_refresh(), 2);
+	EXPECT_EQ(end_device.get_last_error(), Network<AirRadio>::Error::NET_OK);
+	// and is in step with the coordinator again
+	const uint8_t payload[] = { 1 };
+	end_device.app_send(ADDR_COORD, 0, payload, sizeof(payload));
+	const uint32_t until = air.now + 60000;
+	for (; air.now < until && !(coord.get_status() & Network<AirRadio>::Status::NET_RECV_RDY); air.now++) {
+		air_step(coord);
+		air_step(end_device);
+	}
+	EXPECT_TRUE(coord.get_status() & Network<AirRadio>::Status::NET_RECV_RDY);
+}
\ No newline at end of file
@@ -0,0 +1,218 @@
+#include "pch.h"
+#include "../../../src/LoomMAC.h"
+#include <vector>
+
+using namespace LoomNet;
+
+// a radio that hears whatever the test puts on the air, at whatever time the test sets
+class SampleRadio : public Radio {
+public:
+	SampleRadio()
+		: m_time(0)
+		, m_interval(TimeInterval::MILLISECOND, 10)
+		, m_air(PacketCtrl::NONE, ADDR_NONE)
+		, m_state(State::DISABLED) {}
+
+	TimeTicks get_time() const override { return m_time; }
+	State get_state() const override { return m_state; }
+	void enable() override { m_state = State::SLEEP; }
+	void disable() override { m_state = State::DISABLED; }
+	void sleep() override { m_state = State::SLEEP; }
+	void wake() override { m_state = State::IDLE; }
+	Packet recv(TimeTicks& recv_stamp) override {
+		recv_stamp = m_time;
+		const Packet ret = m_air;
+		m_air = Packet(PacketCtrl::NONE, ADDR_NONE);
+		return ret;
+	}
+	void send(const Packet& send) override {}
+	TimeTicks get_sample_interval() const override { return m_interval; }
+
+	TimeTicks m_time;
+	TimeTicks m_interval;
+	Packet m_air;
+	State m_state;
+};
+
+// the same radio written like a driver, with nothing virtual
+class DirectRadio : public RadioBase {
+public:
+	DirectRadio()
+		: m_time(0)
+		, m_interval(TimeInterval::MILLISECOND, 10)
+		, m_state(State::DISABLED)
+		, m_sent(0) {}
+
+	TimeTicks get_time() const { return m_time; }
+	State get_state() const { return m_state; }
+	void enable() { m_state = State::SLEEP; }
+	void disable() { m_state = State::DISABLED; }
+	void sleep() { m_state = State::SLEEP; }
+	void wake() { m_state = State::IDLE; }
+	Packet recv(TimeTicks& recv_stamp) {
+		recv_stamp = m_time;
+		return Packet(PacketCtrl::NONE, ADDR_NONE);
+	}
+	void send(const Packet& send) { m_sent++; }
+	TimeTicks get_sample_interval() const { return m_interval; }
+
+	TimeTicks m_time;
+	TimeTicks m_interval;
+	State m_state;
+	size_t m_sent;
+};
+
+class SampleFixture : public ::testing::Test {
+protected:
+	SampleFixture()
+		: m_mac(0x1001,
+			DeviceType::END_DEVICE,
+			Slotter(9, 24, 2, 1, 1),
+			Drift(TimeInterval(TimeInterval::MILLISECOND, 20), TimeInterval(TimeInterval::MILLISECOND, 50), TimeInterval(TimeInterval::SECOND, 1)),
+			BATCH_FIXED,
+			m_radio) {}
+
+	// let the MAC look for the network at a time
+	void poll(const uint64_t millis) {
+		m_radio.m_time = TimeTicks(TimeInterval::MILLISECOND, static_cast<uint32_t>(millis));
+		if (m_mac.get_status() == MAC::State::MAC_SLEEP_RDY) m_mac.sleep_wake_ack();
+		m_mac.check_for_refresh();
+	}
+
+	SampleRadio m_radio;
+	MAC m_mac;
+};
+
+TEST_F(SampleFixture, ColdSample) {
+	poll(0);
+	// nothing heard, so sleep until the next sample
+	EXPECT_EQ(m_mac.get_status(), MAC::State::MAC_SLEEP_RDY);
+	EXPECT_EQ(m_radio.get_state(), Radio::State::SLEEP);
+	EXPECT_EQ(m_mac.sleep_next_wake_time(), TimeTicks(TimeInterval::MILLISECOND, 10));
+	// waking for a sample goes right back to looking
+	m_radio.m_time = m_mac.sleep_next_wake_time();
+	m_mac.sleep_wake_ack();
+	EXPECT_EQ(m_mac.get_status(), MAC::State::MAC_REFRESH_WAIT);
+	EXPECT_EQ(m_radio.get_state(), Radio::State::IDLE);
+	EXPECT_EQ(m_mac.get_slotter().get_state(), Slotter::State::SLOT_WAIT_REFRESH);
+}
+
+TEST_F(SampleFixture, Continuous) {
+	m_radio.m_interval = TICKS_NONE;
+	poll(0);
+	EXPECT_EQ(m_mac.get_status(), MAC::State::MAC_REFRESH_WAIT);
+	EXPECT_EQ(m_radio.get_state(), Radio::State::IDLE);
+}
+
+TEST_F(SampleFixture, Narrow) {
+	poll(0);
+	// hear someone else's data transmission at the start of their slot
+	Packet data = DataPacket::Factory(0x1000, 0x2001, 0x2001, 0, 0, nullptr, 0);
+	data.set_framecheck();
+	m_radio.m_air = data;
+	poll(1234);
+	EXPECT_EQ(m_mac.get_status(), MAC::State::MAC_SLEEP_RDY);
+	// still inside the window around the slot start, so keep sampling
+	EXPECT_EQ(m_mac.sleep_next_wake_time(), TimeTicks(TimeInterval::MILLISECOND, 1244));
+	// past the window, so skip to where the next one opens: drift + sample before the next slot
+	poll(1300);
+	EXPECT_EQ(m_mac.sleep_next_wake_time(), TimeTicks(TimeInterval::MILLISECOND, 2174));
+	EXPECT_EQ(m_mac.get_slotter().get_state(), Slotter::State::SLOT_WAIT_REFRESH);
+}
+
+TEST_F(SampleFixture, Refresh) {
+	poll(0);
+	poll(10);
+	Packet refresh = RefreshPacket::Factory(0x0000,
+		TimeInterval(TimeInterval::SECOND, 2),
+		TimeInterval(TimeInterval::SECOND, 60),
+		0);
+	refresh.set_framecheck();
+	m_radio.m_air = refresh;
+	poll(20);
+	// joined, so the slotter takes over from sampling
+	EXPECT_EQ(m_mac.get_status(), MAC::State::MAC_SLEEP_RDY);
+	EXPECT_NE(m_mac.get_slotter().get_state(), Slotter::State::SLOT_WAIT_REFRESH);
+	m_mac.sleep_wake_ack();
+	EXPECT_GE(m_mac.sleep_next_wake_time(), TimeTicks(TimeInterval::MILLISECOND, 2020));
+}
+
+// writes every value it's handed as bytes, or reads them back in the same order
+struct ByteArchive {
+	template<class T>
+	void operator()(T& value) {
+		uint8_t* raw = reinterpret_cast<uint8_t*>(&value);
+		for (size_t i = 0; i < sizeof(T); i++) {
+			if (loading) raw[i] = bytes[at++];
+			else bytes.push_back(raw[i]);
+		}
+	}
+
+	std::vector<uint8_t> bytes;
+	size_t at;
+	bool loading;
+};
+
+TEST_F(SampleFixture, CopyAndSnapshot) {
+	poll(0);
+	poll(10);
+	Packet refresh = RefreshPacket::Factory(0x0000,
+		TimeInterval(TimeInterval::SECOND, 2),
+		TimeInterval(TimeInterval::SECOND, 60),
+		0);
+	refresh.set_framecheck();
+	m_radio.m_air = refresh;
+	poll(20);
+	// a copy on another radio carries on from the same place
+	SampleRadio other;
+	const MAC copy(m_mac, other);
+	EXPECT_EQ(copy.get_status(), m_mac.get_status());
+	EXPECT_EQ(copy.get_slotter().get_state(), m_mac.get_slotter().get_state());
+	EXPECT_EQ(copy.sleep_next_wake_time(), m_mac.sleep_next_wake_time());
+	// and so does a fresh one with the same configuration, given a snapshot
+	ByteArchive saved{ {}, 0, false };
+	m_mac.snapshot(saved);
+	MAC fresh(0x1001,
+		DeviceType::END_DEVICE,
+		Slotter(9, 24, 2, 1, 1),
+		Drift(TimeInterval(TimeInterval::MILLISECOND, 20), TimeInterval(TimeInterval::MILLISECOND, 50), TimeInterval(TimeInterval::SECOND, 1)),
+		BATCH_FIXED,
+		other);
+	EXPECT_NE(fresh.sleep_next_wake_time(), m_mac.sleep_next_wake_time());
+	ByteArchive loaded{ saved.bytes, 0, true };
+	fresh.snapshot(loaded);
+	EXPECT_EQ(loaded.at, saved.bytes.size());
+	EXPECT_EQ(fresh.get_status(), m_mac.get_status());
+	EXPECT_EQ(fresh.get_slotter().get_state(), m_mac.get_slotter().get_state());
+	EXPECT_EQ(fresh.sleep_next_wake_time(), m_mac.sleep_next_wake_time());
+}
+
+TEST(MACRadio, DirectAndAdapted) {
+	// one MAC calls the driver directly, the other goes through the virtual interface to the same kind of driver
+	DirectRadio direct_radio;
+	DirectRadio adapted_radio;
+	RadioAdapter<DirectRadio> adapter(adapted_radio);
+	const Drift timing(TimeInterval(TimeInterval::MILLISECOND, 20), TimeInterval(TimeInterval::MILLISECOND, 50), TimeInterval(TimeInterval::SECOND, 1));
+	BasicMAC<DirectRadio> direct(0x1001, DeviceType::END_DEVICE, Slotter(9, 24, 2, 1, 1), timing, BATCH_FIXED, direct_radio);
+	MAC adapted(0x1001, DeviceType::END_DEVICE, Slotter(9, 24, 2, 1, 1), timing, BATCH_FIXED, adapter);
+	for (const uint32_t millis : { 0, 10, 20, 30 }) {
+		direct_radio.m_time = adapted_radio.m_time = TimeTicks(TimeInterval::MILLISECOND, millis);
+		if (direct.get_status() == MAC::State::MAC_SLEEP_RDY) direct.sleep_wake_ack();
+		if (adapted.get_status() == MAC::State::MAC_SLEEP_RDY) adapted.sleep_wake_ack();
+		direct.check_for_refresh();
+		adapted.check_for_refresh();
+		EXPECT_EQ(direct.get_status(), adapted.get_status());
+		EXPECT_EQ(direct.sleep_next_wake_time(), adapted.sleep_next_wake_time());
+		EXPECT_EQ(direct_radio.get_state(), adapted_radio.get_state());
+	}
+	// and a coordinator sends its refresh through either
+	BasicMAC<DirectRadio> direct_coord(ADDR_COORD, DeviceType::COORDINATOR, Slotter(9, 24, 2, 1, 1), timing, BATCH_FIXED, direct_radio);
+	MAC adapted_coord(ADDR_COORD, DeviceType::COORDINATOR, Slotter(9, 24, 2, 1, 1), timing, BATCH_FIXED, adapter);
+	direct_coord.check_for_refresh();
+	adapted_coord.check_for_refresh();
+	EXPECT_EQ(direct_radio.m_sent, 1u);
+	EXPECT_EQ(adapted_radio.m_sent, 1u);
+	EXPECT_EQ(direct_coord.get_status(), MAC::State::MAC_SLEEP_RDY);
+	EXPECT_EQ(adapted_coord.get_status(), MAC::State::MAC_SLEEP_RDY);
+	EXPECT_EQ(direct_coord.sleep_next_wake_time(), adapted_coord.sleep_next_wake_time());
+}
\ No newline at end of file
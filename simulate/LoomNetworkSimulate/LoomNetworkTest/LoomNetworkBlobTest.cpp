@@ -0,0 +1,141 @@
+#include "pch.h"
+#include "../../../src/LoomNetworkConfig.h"
+#include "../../../src/LoomNetworkBlob.h"
+
+using namespace LoomNet;
+
+class BlobFixture : public ::testing::Test {
+public:
+	BlobFixture()
+		: ::testing::Test()
+		, m_doc(4069)
+		, m_size(0) {}
+
+protected:
+	const static char config[];
+
+	void SetUp() override {
+		ASSERT_FALSE(deserializeJson(m_doc, config));
+		m_topology = new NetworkTopology(m_doc.as<JsonObjectConst>(), m_table, MAX_DEVICES);
+		ASSERT_TRUE(m_topology->is_valid());
+		m_size = m_topology->write_blob(m_blob, sizeof(m_blob));
+	}
+
+	void TearDown() override {
+		delete m_topology;
+	}
+
+	NetworkInfo read(const uint16_t address) {
+		MemoryBlobReader reader(m_blob, m_size);
+		return read_network_blob(reader, address);
+	}
+
+	DynamicJsonDocument m_doc;
+	DeviceInfo m_table[MAX_DEVICES];
+	NetworkTopology* m_topology;
+	uint8_t m_blob[BlobReader::get_size(MAX_DEVICES)];
+	uint32_t m_size;
+};
+
+const char BlobFixture::config[] = "\
+{\
+\"config\":{\
+	\"cycles_per_batch\":2,\
+	\"cycle_gap\":1,\
+	\"batch_gap\":1,\
+	\"slot_length\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":10\
+	},\
+	\"max_drift\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":10\
+	},\
+	\"min_drift\":{\
+		\"unit\":\"SECOND\",\
+		\"time\":3\
+	},\
+	\"adaptive\":{\
+		\"cycles_per_batch\":[2,4],\
+		\"batch_gap\":[1,8],\
+		\"hold\":3\
+	}\
+},\
+\"root\":{\
+	\"name\":\"Coordinator\",\
+	\"sensor\":false,\
+	\"children\":[\
+		{\
+			\"name\":\"End Device 1\",\
+			\"type\":0\
+		},\
+		{\
+			\"name\":\"Router 1\",\
+			\"sensor\":true,\
+			\"type\":1,\
+			\"children\":[\
+				{\
+					\"name\":\"Router 1 End Device 1\",\
+					\"type\":0\
+				},\
+				{\
+					\"name\":\"Router 1 Router 1\",\
+					\"sensor\":false,\
+					\"type\":1,\
+					\"children\":[\
+						{\
+							\"name\":\"Router 1 Router 1 End Device 1\",\
+							\"type\":0\
+						}\
+					]\
+				}\
+			]\
+		},\
+		{\
+			\"name\":\"End Device 2\",\
+			\"type\":0\
+		}\
+	]\
+}\
+}";
+
+TEST_F(BlobFixture, RoundTrip) {
+	EXPECT_EQ(m_size, BlobReader::get_size(m_topology->get_device_count()));
+	for (uint16_t i = 0; i < m_topology->get_device_count(); i++) {
+		const DeviceInfo& device = m_topology->get_device(i);
+		const NetworkInfo truth = m_topology->get_info(device);
+		const NetworkInfo info = read(device.address);
+		EXPECT_EQ(info.route_info, truth.route_info) << device.name;
+		EXPECT_EQ(info.slot_info, truth.slot_info) << device.name;
+		EXPECT_EQ(info.drift_info, truth.drift_info) << device.name;
+		EXPECT_EQ(info.batch_info, truth.batch_info) << device.name;
+	}
+}
+
+TEST_F(BlobFixture, UnknownAddress) {
+	const NetworkInfo info = read(0x2000);
+	EXPECT_EQ(info.route_info, ROUTER_ERROR);
+	EXPECT_EQ(info.slot_info, SLOTTER_ERROR);
+	EXPECT_EQ(info.drift_info, DRIFT_ERROR);
+}
+
+TEST_F(BlobFixture, Corrupted) {
+	// flip a bit in the last record, which only the CRC covers
+	m_blob[m_size - 3] ^= 0x01;
+	EXPECT_EQ(read(ADDR_COORD).route_info, ROUTER_ERROR);
+}
+
+TEST_F(BlobFixture, WrongVersion) {
+	m_blob[BlobReader::Header::VERSION] = BLOB_VERSION + 1;
+	EXPECT_EQ(read(ADDR_COORD).route_info, ROUTER_ERROR);
+}
+
+TEST_F(BlobFixture, Truncated) {
+	m_size -= 1;
+	EXPECT_EQ(read(ADDR_COORD).route_info, ROUTER_ERROR);
+}
+
+TEST_F(BlobFixture, TooSmall) {
+	uint8_t small[BlobReader::get_size(4)];
+	EXPECT_EQ(m_topology->write_blob(small, sizeof(small)), 0u);
+}
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "pch.h"
+#include "AirRadio.h"
+
+using namespace LoomNet;
+
+struct QueueEntry {
+	uint16_t dst;
+	int id;
+
+	uint16_t get_dst() const { return dst; }
+};
+
+TEST(SendQueuePolicy, Fifo) {
+	FifoSendQueue<QueueEntry, 3> queue;
+	EXPECT_TRUE(queue.push({ 1, 0 }));
+	EXPECT_TRUE(queue.push({ 2, 1 }));
+	EXPECT_TRUE(queue.push({ 1, 2 }));
+	EXPECT_FALSE(queue.push({ 1, 3 }));
+	EXPECT_TRUE(queue.full());
+	// the oldest for each neighbor goes first
+	EXPECT_EQ(queue[queue.find(1)].id, 0);
+	EXPECT_EQ(queue[queue.find(2)].id, 1);
+	EXPECT_EQ(queue.find(3), queue.size());
+	queue.remove(queue.find(1));
+	EXPECT_EQ(queue[queue.find(1)].id, 2);
+	EXPECT_TRUE(queue.drop_oldest());
+	EXPECT_EQ(queue.size(), 1u);
+	EXPECT_EQ(queue[0].id, 2);
+}
+
+TEST(SendQueuePolicy, Newest) {
+	NewestSendQueue<QueueEntry, 3> queue;
+	queue.push({ 1, 0 });
+	queue.push({ 2, 1 });
+	queue.push({ 1, 2 });
+	// the newest for each neighbor goes first
+	EXPECT_EQ(queue[queue.find(1)].id, 2);
+	queue.remove(queue.find(1));
+	EXPECT_EQ(queue[queue.find(1)].id, 0);
+	EXPECT_EQ(queue[queue.find(2)].id, 1);
+	EXPECT_EQ(queue.find(3), queue.size());
+	// but making room still drops the oldest
+	EXPECT_TRUE(queue.drop_oldest());
+	EXPECT_EQ(queue.find(1), queue.size());
+}
+
+TEST(DedupPolicy, Fingerprint) {
+	const uint8_t payload[] = { 1 };
+	const Packet first = DataPacket::Factory(ADDR_COORD, 0x0001, 0x0001, 0, 0, payload, 1);
+	const Packet again = DataPacket::Factory(ADDR_COORD, 0x0001, 0x0001, 0, 1, payload, 1);
+	const Packet second = DataPacket::Factory(ADDR_COORD, 0x0001, 0x0001, 1, 0, payload, 1);
+	const Packet other = DataPacket::Factory(ADDR_COORD, 0x0002, 0x0002, 0, 0, payload, 1);
+	FingerprintDedup<2> dedup;
+	EXPECT_FALSE(dedup.seen(first.as<DataPacket>()));
+	// only the original sender and rolling ID count
+	EXPECT_TRUE(dedup.seen(again.as<DataPacket>()));
+	EXPECT_FALSE(dedup.seen(second.as<DataPacket>()));
+	// the oldest is forgotten to make room
+	EXPECT_FALSE(dedup.seen(other.as<DataPacket>()));
+	EXPECT_FALSE(dedup.seen(first.as<DataPacket>()));
+	dedup.reset();
+	EXPECT_FALSE(dedup.seen(other.as<DataPacket>()));
+}
+
+TEST(DedupPolicy, None) {
+	const uint8_t payload[] = { 1 };
+	const Packet first = DataPacket::Factory(ADDR_COORD, 0x0001, 0x0001, 0, 0, payload, 1);
+	NoDedup<2> dedup;
+	EXPECT_FALSE(dedup.seen(first.as<DataPacket>()));
+	EXPECT_FALSE(dedup.seen(first.as<DataPacket>()));
+}
+
+TEST(RetryPolicy, Decisions) {
+	EXPECT_TRUE(AlwaysRetry::retry(1));
+	EXPECT_TRUE(AlwaysRetry::retry(UINT8_MAX));
+	EXPECT_FALSE(NoRetry::retry(1));
+	EXPECT_TRUE(LimitedRetry<3>::retry(1));
+	EXPECT_TRUE(LimitedRetry<3>::retry(2));
+	EXPECT_FALSE(LimitedRetry<3>::retry(3));
+}
+
+template<class Retry>
+using RetryNetwork = Network<AirRadio, 4, 4, 8, AnyRole, FifoSendQueue, FingerprintDedup, Retry>;
+
+// an end device sends to a coordinator that never hears it, stopping once stop says so
+template<class Retry, class Stop>
+RetryNetwork<Retry> send_unheard(const uint32_t millis, Stop stop) {
+	Air air;
+	air.lost_from = 0x0001;
+	RetryNetwork<Retry> coord(AIR_COORD, AirRadio(air));
+	RetryNetwork<Retry> end_device(AIR_END_DEVICE, AirRadio(air));
+	const uint8_t payload[] = { 1 };
+	end_device.app_send(ADDR_COORD, 0, payload, sizeof(payload));
+	for (; air.now < millis && !stop(end_device); air.now++) {
+		air_step(coord);
+		air_step(end_device);
+	}
+	EXPECT_EQ(end_device.get_last_error(), RetryNetwork<Retry>::Error::NET_OK);
+	EXPECT_FALSE(coord.get_status() & RetryNetwork<Retry>::Status::NET_RECV_RDY);
+	return RetryNetwork<Retry>(end_device, AirRadio(air));
+}
+
+TEST(RetryPolicy, Always) {
+	const RetryNetwork<AlwaysRetry> end_device = send_unheard<AlwaysRetry>(20000, [](const RetryNetwork<AlwaysRetry>&) { return false; });
+	ASSERT_EQ(end_device.get_send_queue().size(), 1u);
+	EXPECT_GE(end_device.get_send_queue()[0].failures, 3);
+}
+
+TEST(RetryPolicy, None) {
+	// dropped after the first try
+	const RetryNetwork<NoRetry> end_device = send_unheard<NoRetry>(20000, [](const RetryNetwork<NoRetry>& net) { return net.get_send_queue().empty(); });
+	EXPECT_TRUE(end_device.get_send_queue().empty());
+}
+
+TEST(RetryPolicy, Limited) {
+	using Net = RetryNetwork<LimitedRetry<3>>;
+	// kept after two failures
+	const Net kept = send_unheard<LimitedRetry<3>>(20000, [](const Net& net) { return !net.get_send_queue().empty() && net.get_send_queue()[0].failures == 2; });
+	ASSERT_EQ(kept.get_send_queue().size(), 1u);
+	EXPECT_EQ(kept.get_send_queue()[0].failures, 2);
+	// and dropped after the third
+	const Net dropped = send_unheard<LimitedRetry<3>>(20000, [](const Net& net) { return net.get_send_queue().empty(); });
+	EXPECT_TRUE(dropped.get_send_queue().empty());
+}
+
+template<class Overflow>
+using OverflowNetwork = Network<AirRadio, 2, 2, 8, AnyRole, FifoSendQueue, FingerprintDedup, AlwaysRetry, Overflow>;
+
+// three packets into a send queue with room for two, returning the sequence numbers left
+template<class Overflow>
+std::vector<uint8_t> overflow_send(typename OverflowNetwork<Overflow>::Error& error) {
+	Air air;
+	OverflowNetwork<Overflow> end_device(AIR_END_DEVICE, AirRadio(air));
+	const uint8_t payload[] = { 1 };
+	for (uint8_t seq = 0; seq < 3; seq++) end_device.app_send(ADDR_COORD, seq, payload, sizeof(payload));
+	error = end_device.get_last_error();
+	std::vector<uint8_t> left;
+	for (size_t i = 0; i < end_device.get_send_queue().size(); i++)
+		left.push_back(end_device.get_packet(end_device.get_send_queue()[i]).template as<DataPacket>().get_seq());
+	return left;
+}
+
+// three packets sent to an end device with room for two, that never reads them
+template<class Overflow>
+OverflowNetwork<Overflow> overflow_recv() {
+	Air air;
+	OverflowNetwork<Overflow> coord(AIR_COORD, AirRadio(air));
+	OverflowNetwork<Overflow> end_device(AIR_END_DEVICE, AirRadio(air));
+	const uint8_t payload[] = { 1 };
+	const auto step = [&] {
+		air_step(coord);
+		air_step(end_device);
+		if (coord.get_status() & OverflowNetwork<Overflow>::Status::NET_RECV_RDY) coord.app_recv();
+		air.now++;
+	};
+	// the coordinator can only answer the end device, so give it something to say each time
+	for (uint8_t seq = 0; seq < 3; seq++) {
+		end_device.app_send(ADDR_COORD, seq, payload, sizeof(payload));
+		coord.app_send(0x0001, seq, payload, sizeof(payload));
+		const uint32_t until = air.now + 30000;
+		while (air.now < until && !coord.get_send_queue().empty()) step();
+		EXPECT_TRUE(coord.get_send_queue().empty());
+		// and let the end device finish the exchange
+		for (const uint32_t settle = air.now + 100; air.now < settle;) step();
+	}
+	return OverflowNetwork<Overflow>(end_device, AirRadio(air));
+}
+
+TEST(OverflowPolicy, Halt) {
+	OverflowNetwork<HaltOnOverflow>::Error error;
+	EXPECT_EQ(overflow_send<HaltOnOverflow>(error), std::vector<uint8_t>({ 0, 1 }));
+	EXPECT_EQ(error, OverflowNetwork<HaltOnOverflow>::Error::SEND_BUF_FULL);
+	EXPECT_EQ(overflow_recv<HaltOnOverflow>().get_last_error(), OverflowNetwork<HaltOnOverflow>::Error::RECV_BUF_FULL);
+}
+
+TEST(OverflowPolicy, DropNewest) {
+	OverflowNetwork<DropNewestOnOverflow>::Error error;
+	EXPECT_EQ(overflow_send<DropNewestOnOverflow>(error), std::vector<uint8_t>({ 0, 1 }));
+	EXPECT_EQ(error, OverflowNetwork<DropNewestOnOverflow>::Error::NET_OK);
+	OverflowNetwork<DropNewestOnOverflow> end_device = overflow_recv<DropNewestOnOverflow>();
+	EXPECT_EQ(end_device.get_last_error(), OverflowNetwork<DropNewestOnOverflow>::Error::NET_OK);
+	// the newest comes out first
+	EXPECT_EQ(end_device.app_recv().as<DataPacket>().get_seq(), 1);
+	EXPECT_EQ(end_device.app_recv().as<DataPacket>().get_seq(), 0);
+	EXPECT_FALSE(end_device.get_status() & OverflowNetwork<DropNewestOnOverflow>::Status::NET_RECV_RDY);
+}
+
+TEST(OverflowPolicy, DropOldest) {
+	OverflowNetwork<DropOldestOnOverflow>::Error error;
+	EXPECT_EQ(overflow_send<DropOldestOnOverflow>(error), std::vector<uint8_t>({ 1, 2 }));
+	EXPECT_EQ(error, OverflowNetwork<DropOldestOnOverflow>::Error::NET_OK);
+	OverflowNetwork<DropOldestOnOverflow> end_device = overflow_recv<DropOldestOnOverflow>();
+	EXPECT_EQ(end_device.get_last_error(), OverflowNetwork<DropOldestOnOverflow>::Error::NET_OK);
+	EXPECT_EQ(end_device.app_recv().as<DataPacket>().get_seq(), 2);
+	EXPECT_EQ(end_device.app_recv().as<DataPacket>().get_seq(), 1);
+	EXPECT_FALSE(end_device.get_status() & OverflowNetwork<DropOldestOnOverflow>::Status::NET_RECV_RDY);
+}
\ No newline at end of file
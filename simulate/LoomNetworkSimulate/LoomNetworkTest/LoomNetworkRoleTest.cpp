@@ -0,0 +1,73 @@
+#include "pch.h"
+#include "AirRadio.h"
+
+using namespace LoomNet;
+
+// a coordinator and an end device send each other a packet, returning everything that went over the air
+template<class CoordType, class EndDeviceType>
+std::vector<std::pair<uint32_t, Packet>> exchange() {
+	Air air;
+	CoordType coord(AIR_COORD, AirRadio(air));
+	EndDeviceType end_device(AIR_END_DEVICE, AirRadio(air));
+	const uint8_t up[] = { 1, 2, 3 };
+	const uint8_t down[] = { 4, 5 };
+	end_device.app_send(ADDR_COORD, 0, up, sizeof(up));
+	coord.app_send(0x0001, 0, down, sizeof(down));
+	bool coord_got = false;
+	bool end_device_got = false;
+	for (; air.now < 20000 && !(coord_got && end_device_got); air.now++) {
+		air_step(coord);
+		air_step(end_device);
+		EXPECT_EQ(coord.get_last_error(), CoordType::Error::NET_OK);
+		EXPECT_EQ(end_device.get_last_error(), EndDeviceType::Error::NET_OK);
+		if (coord.get_status() & CoordType::Status::NET_RECV_RDY) {
+			const Packet got = coord.app_recv();
+			EXPECT_EQ(got.as<DataPacket>().get_orig_src(), 0x0001);
+			EXPECT_EQ(got.as<DataPacket>().get_payload_length(), sizeof(up));
+			EXPECT_EQ(got.as<DataPacket>().get_payload()[2], 3);
+			coord_got = true;
+		}
+		if (end_device.get_status() & EndDeviceType::Status::NET_RECV_RDY) {
+			const Packet got = end_device.app_recv();
+			EXPECT_EQ(got.as<DataPacket>().get_orig_src(), ADDR_COORD);
+			EXPECT_EQ(got.as<DataPacket>().get_payload_length(), sizeof(down));
+			EXPECT_EQ(got.as<DataPacket>().get_payload()[1], 5);
+			end_device_got = true;
+		}
+	}
+	EXPECT_TRUE(coord_got);
+	EXPECT_TRUE(end_device_got);
+	return air.sent;
+}
+
+TEST(NetworkRole, SameAsAnyRole) {
+	// leaving out code a device never runs mustn't change what it does
+	const std::vector<std::pair<uint32_t, Packet>> any = exchange<Network<AirRadio>, Network<AirRadio>>();
+	const std::vector<std::pair<uint32_t, Packet>> built = exchange<CoordinatorNetwork<AirRadio>, EndDeviceNetwork<AirRadio>>();
+	ASSERT_EQ(any.size(), built.size());
+	for (size_t i = 0; i < any.size(); i++) {
+		EXPECT_EQ(any[i].first, built[i].first);
+		EXPECT_TRUE(any[i].second == built[i].second);
+	}
+}
+
+TEST(NetworkRole, Mismatch) {
+	Air air;
+	// every build but the right one closes before doing anything
+	EndDeviceNetwork<AirRadio> end_device(AIR_COORD, AirRadio(air));
+	RouterNetwork<AirRadio> router(AIR_END_DEVICE, AirRadio(air));
+	CoordinatorNetwork<AirRadio> coord(AIR_END_DEVICE, AirRadio(air));
+	EXPECT_EQ(end_device.get_last_error(), EndDeviceNetwork<AirRadio>::Error::ROLE_MISMATCH);
+	EXPECT_EQ(router.get_last_error(), RouterNetwork<AirRadio>::Error::ROLE_MISMATCH);
+	EXPECT_EQ(coord.get_last_error(), CoordinatorNetwork<AirRadio>::Error::ROLE_MISMATCH);
+	EXPECT_EQ(end_device.net_update(), EndDeviceNetwork<AirRadio>::Status::NET_CLOSED);
+	EXPECT_TRUE(air.sent.empty());
+	// and the right one starts like any other
+	CoordinatorNetwork<AirRadio> right(AIR_COORD, AirRadio(air));
+	EXPECT_EQ(right.get_last_error(), CoordinatorNetwork<AirRadio>::Error::NET_OK);
+	right.net_update();
+	EXPECT_EQ(air.sent.size(), 1u);
+	// a configuration known while compiling can be checked then
+	static_assert(EndDeviceRole::allows(Router(DeviceType::END_DEVICE, 0x0001, ADDR_COORD, 0, 0).get_device_type()), "end device build for an end device");
+	static_assert(!RouterRole::allows(Router(DeviceType::COORDINATOR, ADDR_COORD, ADDR_NONE, 0, 1).get_device_type()), "router build for a coordinator");
+}
\ No newline at end of file
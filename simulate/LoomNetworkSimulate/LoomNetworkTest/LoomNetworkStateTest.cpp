@@ -0,0 +1,109 @@
+#include "pch.h"
+#include "../../../src/LoomNetworkState.h"
+#include "AirRadio.h"
+
+using namespace LoomNet;
+
+class StateFixture : public ::testing::Test {
+protected:
+	const NetworkState m_state{
+		0x1202,
+		24,
+		3,
+		2,
+		7,
+		200,
+		TimeTicks(123456789012ULL),
+		TimeTicks(TimeInterval::SECOND, 300)
+	};
+	MemoryStateStore m_store;
+};
+
+// copies the stored bytes, so they can be changed and written back
+class RawStore : public MemoryStateStore {
+public:
+	uint8_t get(const uint8_t index) {
+		uint8_t buf[StateStore::Field::STATE_SIZE];
+		read(buf, sizeof(buf));
+		return buf[index];
+	}
+
+	void set(const uint8_t index, const uint8_t value) {
+		uint8_t buf[StateStore::Field::STATE_SIZE];
+		read(buf, sizeof(buf));
+		buf[index] = value;
+		write(buf, sizeof(buf));
+	}
+};
+
+TEST_F(StateFixture, RoundTrip) {
+	ASSERT_TRUE(write_network_state(m_store, m_state));
+	NetworkState state{};
+	ASSERT_TRUE(read_network_state(m_store, state));
+	EXPECT_EQ(state.address, m_state.address);
+	EXPECT_EQ(state.total_slots, m_state.total_slots);
+	EXPECT_EQ(state.cycles_per_batch, m_state.cycles_per_batch);
+	EXPECT_EQ(state.cycle_gap, m_state.cycle_gap);
+	EXPECT_EQ(state.batch_gap, m_state.batch_gap);
+	EXPECT_EQ(state.rolling_id, m_state.rolling_id);
+	EXPECT_EQ(state.next_refresh, m_state.next_refresh);
+	EXPECT_EQ(state.refresh_period, m_state.refresh_period);
+}
+
+TEST_F(StateFixture, Empty) {
+	NetworkState state{};
+	EXPECT_FALSE(read_network_state(m_store, state));
+}
+
+TEST_F(StateFixture, Corrupted) {
+	RawStore store;
+	ASSERT_TRUE(write_network_state(store, m_state));
+	store.set(StateStore::Field::NEXT_REFRESH + 3, store.get(StateStore::Field::NEXT_REFRESH + 3) ^ 0x10);
+	NetworkState state{};
+	EXPECT_FALSE(read_network_state(store, state));
+}
+
+TEST_F(StateFixture, WrongVersion) {
+	RawStore store;
+	ASSERT_TRUE(write_network_state(store, m_state));
+	store.set(StateStore::Field::VERSION, STATE_VERSION + 1);
+	NetworkState state{};
+	EXPECT_FALSE(read_network_state(store, state));
+}
+
+TEST_F(StateFixture, Truncated) {
+	// a write cut short by the power going out
+	RawStore store;
+	ASSERT_TRUE(write_network_state(store, m_state));
+	uint8_t buf[StateStore::Field::STATE_SIZE];
+	ASSERT_TRUE(store.read(buf, sizeof(buf)));
+	ASSERT_TRUE(store.write(buf, StateStore::Field::CRC));
+	NetworkState state{};
+	EXPECT_FALSE(read_network_state(store, state));
+}
+
+TEST(StateRestore, ClockRestarted) {
+	Air air;
+	Network<AirRadio> coord(AIR_COORD, AirRadio(air));
+	Network<AirRadio> end_device(AIR_END_DEVICE, AirRadio(air));
+	// stay on for a few refreshes, so the next one is well past how long a period is
+	for (; air.now < 60000; air.now++) {
+		air_step(end_device);
+		air_step(coord);
+	}
+	MemoryStateStore store;
+	ASSERT_TRUE(end_device.save_state(store));
+	NetworkState saved{};
+	ASSERT_TRUE(read_network_state(store, saved));
+	ASSERT_GT(saved.next_refresh, saved.refresh_period + saved.refresh_period);
+	// a clock that kept counting through the power loss sleeps until the next refresh
+	Network<AirRadio> kept(AIR_END_DEVICE, AirRadio(air));
+	EXPECT_TRUE(kept.restore_state(store));
+	EXPECT_TRUE(kept.get_status() & Network<AirRadio>::Status::NET_SLEEP_RDY);
+	// one that started over would sleep for as long as the device had been on, so it listens instead
+	air.now = 0;
+	Network<AirRadio> restarted(AIR_END_DEVICE, AirRadio(air));
+	EXPECT_FALSE(restarted.restore_state(store));
+	EXPECT_FALSE(restarted.get_status() & Network<AirRadio>::Status::NET_SLEEP_RDY);
+	EXPECT_EQ(restarted.get_mac().get_slotter().get_state(), Slotter::State::SLOT_WAIT_REFRESH);
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "pch.h"
+#include "AirRadio.h"
+
+using namespace LoomNet;
+
+using SubscribeNetwork = Network<AirRadio, 4, 4, 8>;
+
+// what a handler was given, copied out while the view was still good
+struct Heard {
+	std::vector<uint8_t> payload;
+	uint16_t orig_src;
+	uint8_t seq;
+};
+
+static void remember(const PayloadView& view, void* context) {
+	static_cast<std::vector<Heard>*>(context)->push_back({ std::vector<uint8_t>(view.payload, view.payload + view.length), view.orig_src, view.seq });
+}
+
+// the end device sends the coordinator each payload in turn, which the coordinator never reads from its recieve buffer
+static void send_up(Air& air, SubscribeNetwork& coord, SubscribeNetwork& end_device, const std::vector<std::vector<uint8_t>>& payloads) {
+	for (uint8_t seq = 0; seq < payloads.size(); seq++) {
+		end_device.app_send(ADDR_COORD, seq, payloads[seq].data(), static_cast<uint8_t>(payloads[seq].size()));
+		// and something back each time, so the end device has a reason to listen
+		coord.app_send(0x0001, seq, payloads[seq].data(), 1);
+		for (const uint32_t until = air.now + 30000; air.now < until && !end_device.get_send_queue().empty(); air.now++) {
+			air_step(coord);
+			air_step(end_device);
+			if (end_device.get_status() & SubscribeNetwork::Status::NET_RECV_RDY) end_device.app_recv_done();
+		}
+		EXPECT_TRUE(end_device.get_send_queue().empty());
+		for (const uint32_t settle = air.now + 100; air.now < settle; air.now++) {
+			air_step(coord);
+			air_step(end_device);
+		}
+	}
+	EXPECT_EQ(coord.get_last_error(), SubscribeNetwork::Error::NET_OK);
+}
+
+TEST(NetworkSubscribe, Handler) {
+	Air air;
+	SubscribeNetwork coord(AIR_COORD, AirRadio(air));
+	SubscribeNetwork end_device(AIR_END_DEVICE, AirRadio(air));
+	std::vector<Heard> heard;
+	EXPECT_TRUE(coord.subscribe(remember, &heard));
+	send_up(air, coord, end_device, { { 7, 8, 9 }, { 10 } });
+	ASSERT_EQ(heard.size(), 2u);
+	EXPECT_EQ(heard[0].payload, std::vector<uint8_t>({ 7, 8, 9 }));
+	EXPECT_EQ(heard[0].orig_src, 0x0001);
+	EXPECT_EQ(heard[0].seq, 0);
+	EXPECT_EQ(heard[1].payload, std::vector<uint8_t>({ 10 }));
+	EXPECT_EQ(heard[1].seq, 1);
+	// nothing went through the recieve buffer, or stayed in the pool
+	EXPECT_FALSE(coord.get_status() & SubscribeNetwork::Status::NET_RECV_RDY);
+	EXPECT_EQ(coord.get_pool().available(), 4u + 4u + 1u);
+}
+
+TEST(NetworkSubscribe, Filters) {
+	Air air;
+	SubscribeNetwork coord(AIR_COORD, AirRadio(air));
+	SubscribeNetwork end_device(AIR_END_DEVICE, AirRadio(air));
+	std::vector<Heard> port_one, port_two, other_src, anything;
+	EXPECT_TRUE(coord.subscribe(remember, &port_one, ADDR_NONE, 1));
+	EXPECT_TRUE(coord.subscribe(remember, &port_two, 0x0001, 2));
+	EXPECT_TRUE(coord.subscribe(remember, &other_src, 0x0002));
+	send_up(air, coord, end_device, { { 1, 5 }, { 2, 6 }, { 3, 7 } });
+	// each goes to every handler that matches, and nobody wanted the last one
+	ASSERT_EQ(port_one.size(), 1u);
+	EXPECT_EQ(port_one[0].payload[1], 5);
+	ASSERT_EQ(port_two.size(), 1u);
+	EXPECT_EQ(port_two[0].payload[1], 6);
+	EXPECT_TRUE(other_src.empty());
+	ASSERT_TRUE(coord.get_status() & SubscribeNetwork::Status::NET_RECV_RDY);
+	EXPECT_EQ(coord.app_recv().as<DataPacket>().get_payload()[1], 7);
+	EXPECT_FALSE(coord.get_status() & SubscribeNetwork::Status::NET_RECV_RDY);
+	// a handler can be taken away, and then there's room for another
+	EXPECT_TRUE(coord.subscribe(remember, &anything));
+	EXPECT_FALSE(coord.subscribe(remember, &anything));
+	coord.unsubscribe(remember, &port_one);
+	coord.unsubscribe(remember, &port_two);
+	coord.unsubscribe(remember, &other_src);
+	EXPECT_TRUE(coord.subscribe(remember, &port_one, ADDR_NONE, 1));
+	send_up(air, coord, end_device, { { 1, 8 } });
+	ASSERT_EQ(anything.size(), 1u);
+	ASSERT_EQ(port_one.size(), 2u);
+	EXPECT_EQ(port_one[1].payload[1], 8);
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "pch.h"
+#include "AirRadio.h"
+#include "../../../src/LoomPacketPool.h"
+
+using namespace LoomNet;
+
+TEST(PacketPool, AllocRelease) {
+	PacketPool<3> pool;
+	static_assert(sizeof(PacketPool<3>::Handle) == 1, "byte handles");
+	EXPECT_EQ(pool.available(), 3u);
+	const PacketPool<3>::Handle first = pool.alloc(Packet(PacketCtrl::DATA_TRANS, 0x0001));
+	const PacketPool<3>::Handle second = pool.alloc(Packet(PacketCtrl::DATA_TRANS, 0x0002));
+	const PacketPool<3>::Handle third = pool.alloc(Packet(PacketCtrl::DATA_TRANS, 0x0003));
+	EXPECT_EQ(pool.alloc(Packet(PacketCtrl::DATA_TRANS, 0x0004)), PacketPool<3>::NONE);
+	EXPECT_EQ(pool.available(), 0u);
+	// every slot is its own
+	EXPECT_EQ(pool[first].get_src(), 0x0001);
+	EXPECT_EQ(pool[second].get_src(), 0x0002);
+	EXPECT_EQ(pool[third].get_src(), 0x0003);
+	// and a freed one is handed out again, for the next packet
+	pool.release(second);
+	EXPECT_EQ(pool.available(), 1u);
+	const PacketPool<3>::Handle again = pool.alloc(Packet(PacketCtrl::DATA_TRANS, 0x0005));
+	EXPECT_EQ(again, second);
+	EXPECT_EQ(pool[again].get_src(), 0x0005);
+	EXPECT_EQ(pool[first].get_src(), 0x0001);
+	// a copy has its own packets, in the same slots
+	PacketPool<3> copy(pool);
+	copy[first].set_src(0x0006);
+	EXPECT_EQ(copy[third].get_src(), 0x0003);
+	EXPECT_EQ(pool[first].get_src(), 0x0001);
+	pool.reset();
+	EXPECT_EQ(pool.available(), 3u);
+	EXPECT_EQ(copy.available(), 0u);
+}
+
+TEST(PacketPool, NetworkFreesEverySlot) {
+	using Net = Network<AirRadio, 4, 4, 8>;
+	Air air;
+	Net coord(AIR_COORD, AirRadio(air));
+	Net end_device(AIR_END_DEVICE, AirRadio(air));
+	const size_t slots = coord.get_pool().available();
+	EXPECT_EQ(slots, 4u + 4u + 1u);
+	const uint8_t payload[] = { 1, 2, 3 };
+	end_device.app_send(ADDR_COORD, 0, payload, sizeof(payload));
+	coord.app_send(0x0001, 1, payload, sizeof(payload));
+	EXPECT_EQ(end_device.get_pool().available(), slots - 1);
+	bool coord_got = false;
+	bool end_device_got = false;
+	for (; air.now < 20000 && !(coord_got && end_device_got); air.now++) {
+		air_step(coord);
+		air_step(end_device);
+		if (coord.get_status() & Net::Status::NET_RECV_RDY) {
+			// read where it is, in the slot the MAC handed it to
+			const Packet& got = coord.app_recv_peek();
+			EXPECT_EQ(&got, &coord.app_recv_peek());
+			EXPECT_EQ(got.as<DataPacket>().get_payload()[2], 3);
+			coord.app_recv_done();
+			coord_got = true;
+		}
+		if (end_device.get_status() & Net::Status::NET_RECV_RDY) {
+			EXPECT_EQ(end_device.app_recv().as<DataPacket>().get_seq(), 1);
+			end_device_got = true;
+		}
+	}
+	EXPECT_TRUE(coord_got);
+	EXPECT_TRUE(end_device_got);
+	// nothing sent, recieved or read is left holding a slot
+	EXPECT_EQ(coord.get_pool().available(), slots);
+	EXPECT_EQ(end_device.get_pool().available(), slots);
+}
\ No newline at end of file
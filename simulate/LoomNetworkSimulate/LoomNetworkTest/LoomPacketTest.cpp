@@ -76,6 +76,37 @@ TEST(LoomPacket, RefreshPacketRaw) {
 	EXPECT_EQ(refresh.get_packet_length(), 11);
 }
 
+TEST(LoomPacket, RefreshPacketBatch) {
+	const Packet test = RefreshPacket::Factory(0xDEAD,
+		TimeInterval(TimeInterval::MILLISECOND, 5),
+		TimeInterval(TimeInterval::SECOND, 400),
+		0, 3, 2, 1);
+	const RefreshPacket& refresh = test.as<RefreshPacket>();
+
+	EXPECT_EQ(refresh.get_control(), PacketCtrl::REFRESH_INITIAL);
+	EXPECT_EQ(refresh.get_data_interval(), TimeInterval(TimeInterval::MILLISECOND, 5));
+	EXPECT_EQ(refresh.get_refresh_interval(), TimeInterval(TimeInterval::SECOND, 400));
+	EXPECT_TRUE(refresh.has_batch_params());
+	EXPECT_EQ(refresh.get_cycles_per_batch(), 3);
+	EXPECT_EQ(refresh.get_cycle_gap(), 2);
+	EXPECT_EQ(refresh.get_batch_gap(), 1);
+	EXPECT_EQ(refresh.get_packet_length(), 14);
+}
+
+TEST(LoomPacket, RefreshPacketBatchRaw) {
+	constexpr uint8_t raw[] = { 0x01, 0xAD, 0xDE, 0b01010001, 5, 0x90, 0x01, 0x00, 0x00, 3, 2, 1, 0x00, 0x00 };
+	const Packet test(raw, sizeof(raw));
+	const RefreshPacket& refresh = test.as<RefreshPacket>();
+
+	EXPECT_EQ(refresh.get_data_interval(), TimeInterval(TimeInterval::MILLISECOND, 5));
+	EXPECT_EQ(refresh.get_refresh_interval(), TimeInterval(TimeInterval::SECOND, 400));
+	EXPECT_TRUE(refresh.has_batch_params());
+	EXPECT_EQ(refresh.get_cycles_per_batch(), 3);
+	EXPECT_EQ(refresh.get_cycle_gap(), 2);
+	EXPECT_EQ(refresh.get_batch_gap(), 1);
+	EXPECT_EQ(refresh.get_packet_length(), 14);
+}
+
 TEST(LoomPacket, ACKPacket) {
 	const Packet test = ACKPacket::Factory(0xDEAD);
 	const ACKPacket& ack = test.as<ACKPacket>();
@@ -91,4 +122,14 @@ TEST(LoomPacket, ACKPacketRaw) {
 
 	EXPECT_EQ(ack.get_control(), PacketCtrl::DATA_ACK);
 	EXPECT_EQ(ack.get_src(), 0xDEAD);
+}
+
+TEST(LoomPacket, Fingerprint) {
+	const uint8_t payload[] = { 1 };
+	const Packet test = DataPacket::Factory(ADDR_COORD, 0xDEAD, 0xBEEF, 0x42, 0, payload, sizeof(payload));
+	const PacketFingerprint print(test.as<DataPacket>());
+	static_assert(sizeof(PacketFingerprint) == 3, "fingerprints are packed");
+
+	EXPECT_EQ(print.get_src(), 0xBEEF);
+	EXPECT_EQ(print.get_rolling_id(), 0x42);
 }
\ No newline at end of file
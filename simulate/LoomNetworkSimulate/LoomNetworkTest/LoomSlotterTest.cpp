@@ -120,4 +120,24 @@ TEST(Slotter, Coordinator) {
 		slotter.next_state();
 		i++;
 	}
+}
+
+TEST(Slotter, BatchParams) {
+	Slotter slotter(9, 24, 2, 1, 1); // generic end device
+
+	// allowed while waiting for the refresh
+	ASSERT_TRUE(slotter.set_batch_params(3, 2, 4));
+	ASSERT_EQ(slotter.get_slots_per_refresh(), (24 + 2) * 3 - 2 + 4 + REFRESH_CYCLE_SLOTS);
+	// and right after it, before the first data cycle
+	slotter.next_state();
+	ASSERT_TRUE(slotter.set_batch_params(2, 1, 1));
+	// but not in the middle of a batch
+	slotter.next_state();
+	ASSERT_FALSE(slotter.set_batch_params(3, 1, 1));
+	ASSERT_EQ(slotter.get_cycles_per_refresh(), 2);
+	// or with values the configuration wouldn't allow
+	slotter.reset();
+	ASSERT_FALSE(slotter.set_batch_params(1, 1, 1));
+	ASSERT_FALSE(slotter.set_batch_params(2, 0, 1));
+	ASSERT_EQ(slotter, Slotter(9, 24, 2, 1, 1));
 }
\ No newline at end of file
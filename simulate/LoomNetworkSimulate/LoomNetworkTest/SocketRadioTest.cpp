@@ -0,0 +1,98 @@
+#include "pch.h"
+
+// unix sockets only exist on the Linux host
+#ifdef __linux__
+
+#include "../../../src/Radios/SocketRadio.h"
+#include "../../../src/LoomNetworkPacket.h"
+#include <cstdlib>
+#include <string>
+
+using namespace LoomNet;
+
+class SocketRadioFixture : public ::testing::Test {
+protected:
+	SocketRadioFixture()
+		: m_dir(m_make_dir())
+		, m_first(m_dir.c_str(), 0x0001)
+		, m_second(m_dir.c_str(), 0x0002) {}
+
+	~SocketRadioFixture() {
+		rmdir(m_dir.c_str());
+	}
+
+	void SetUp() override {
+		m_first.enable();
+		m_first.wake();
+		m_second.enable();
+		m_second.wake();
+	}
+
+	void TearDown() override {
+		for (SocketRadio* radio : { &m_first, &m_second }) {
+			if (radio->get_state() == Radio::State::IDLE) radio->sleep();
+			if (radio->get_state() == Radio::State::SLEEP) radio->disable();
+		}
+	}
+
+	static std::string m_make_dir() {
+		char dir[] = "/tmp/LoomSocketRadioXXXXXX";
+		return mkdtemp(dir) ? dir : "";
+	}
+
+	static Packet m_packet() {
+		const uint8_t payload[] = "hello";
+		Packet packet = DataPacket::Factory(0x0002, 0x0001, 0x0001, 0, 0, payload, sizeof(payload));
+		packet.set_framecheck();
+		return packet;
+	}
+
+	const std::string m_dir;
+	SocketRadio m_first;
+	SocketRadio m_second;
+};
+
+TEST_F(SocketRadioFixture, SendRecv) {
+	ASSERT_FALSE(m_dir.empty());
+	const Packet sent = m_packet();
+	m_first.send(sent);
+	TimeTicks stamp;
+	const Packet heard = m_second.recv(stamp);
+	EXPECT_FALSE(stamp.is_none());
+	ASSERT_EQ(heard.get_control(), PacketCtrl::DATA_TRANS);
+	EXPECT_TRUE(heard.check_packet());
+	EXPECT_EQ(heard.get_packet_length(), sent.get_packet_length());
+	EXPECT_EQ(heard.as<DataPacket>().get_orig_src(), 0x0001);
+	// we don't hear ourselves, and there's only one copy
+	EXPECT_EQ(m_first.recv(stamp).get_control(), PacketCtrl::NONE);
+	EXPECT_EQ(m_second.recv(stamp).get_control(), PacketCtrl::NONE);
+}
+
+TEST_F(SocketRadioFixture, Asleep) {
+	m_second.sleep();
+	m_first.send(m_packet());
+	m_second.wake();
+	TimeTicks stamp;
+	EXPECT_EQ(m_second.recv(stamp).get_control(), PacketCtrl::NONE);
+}
+
+TEST_F(SocketRadioFixture, Disabled) {
+	m_second.sleep();
+	m_second.disable();
+	// nobody left to hear it, which is fine
+	m_first.send(m_packet());
+	m_second.enable();
+	m_second.wake();
+	TimeTicks stamp;
+	EXPECT_EQ(m_second.recv(stamp).get_control(), PacketCtrl::NONE);
+}
+
+TEST_F(SocketRadioFixture, TimeScale) {
+	const SocketRadio fast(m_dir.c_str(), 0x0003, 1000);
+	const TimeTicks real = m_first.get_time();
+	const TimeTicks scaled = fast.get_time();
+	EXPECT_GE(scaled.get_ticks(), real.get_ticks() * 1000);
+	EXPECT_GE(m_first.get_time(), real);
+}
+
+#endif
\ No newline at end of file
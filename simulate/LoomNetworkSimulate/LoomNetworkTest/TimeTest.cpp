@@ -212,4 +212,71 @@ TEST(TimeInterval, Downcast) {
 
 	EXPECT_EQ(test.get_unit(), Unit::SECOND);
 	EXPECT_EQ(test.get_time(), 4294);
+}
+
+TEST(TimeTicks, Convert) {
+	// conversions happen at compile time
+	static_assert(TimeTicks(Unit::SECOND, 10).get_ticks() == 10000000ULL, "Seconds to ticks");
+	static_assert(TimeTicks(Unit::NONE, 10).is_none(), "None to ticks");
+
+	EXPECT_EQ(TimeTicks(TimeInterval(Unit::DAY, 2)).get_ticks(), 172800000000ULL);
+	EXPECT_TRUE(TimeTicks(TIME_NONE).is_none());
+	// too big for 64 bits of microseconds
+	EXPECT_EQ(TimeTicks(Unit::DAY, UINT32_MAX).get_ticks(), TimeTicks::MAX);
+
+	// and back again, rounding down
+	TimeInterval result = TimeTicks(Unit::MILLISECOND, 1500).to_interval();
+	EXPECT_EQ(result.get_unit(), Unit::MICROSECOND);
+	EXPECT_EQ(result.get_time(), 1500000u);
+	result = TimeTicks(Unit::SECOND, 5000).to_interval();
+	EXPECT_EQ(result.get_unit(), Unit::MILLISECOND);
+	EXPECT_EQ(result.get_time(), 5000000u);
+	result = TimeTicks(TimeTicks::MAX).to_interval();
+	EXPECT_EQ(result.get_unit(), Unit::DAY);
+	EXPECT_EQ(result.get_time(), 213503982u);
+	EXPECT_TRUE(TICKS_NONE.to_interval().is_none());
+}
+
+
+TEST(TimeTicks, Arithmetic) {
+	const TimeTicks second(Unit::SECOND, 1);
+	EXPECT_EQ((second + TimeTicks(Unit::MILLISECOND, 5)).get_ticks(), 1005000ULL);
+	EXPECT_EQ((second * 3).get_ticks(), 3000000ULL);
+	EXPECT_EQ((second * 3 - TimeTicks(Unit::MILLISECOND, 5)).get_ticks(), 2995000ULL);
+
+	// saturate instead of overflowing
+	EXPECT_EQ((TimeTicks(TimeTicks::MAX) + second).get_ticks(), TimeTicks::MAX);
+	EXPECT_EQ((TimeTicks(TimeTicks::MAX) * 2).get_ticks(), TimeTicks::MAX);
+	EXPECT_EQ((second - second * 2).get_ticks(), 0ULL);
+
+	// NONE sticks
+	EXPECT_TRUE((second + TICKS_NONE).is_none());
+	EXPECT_TRUE((TICKS_NONE - second).is_none());
+	EXPECT_TRUE((TICKS_NONE * 2).is_none());
+}
+
+TEST(TimeTicks, Comparision) {
+	const TimeTicks second(Unit::SECOND, 1);
+	EXPECT_TRUE(second == TimeTicks(Unit::MILLISECOND, 1000));
+	EXPECT_TRUE(second < TimeTicks(Unit::MILLISECOND, 1001));
+	EXPECT_TRUE(second <= second);
+	EXPECT_TRUE(second > TimeTicks(Unit::MICROSECOND, 999999));
+	EXPECT_TRUE(second >= second);
+
+	// comparing with nothing is always false
+	EXPECT_FALSE(second < TICKS_NONE);
+	EXPECT_FALSE(second >= TICKS_NONE);
+	EXPECT_FALSE(TICKS_NONE > second);
+	EXPECT_TRUE(TICKS_NONE == TICKS_NONE);
+}
+
+TEST(TimeTicks, CounterRollover) {
+	TickCounter clock(Unit::MILLISECOND);
+	const TimeTicks before = clock.update(UINT32_MAX - 10);
+	EXPECT_EQ(before.get_ticks(), (static_cast<uint64_t>(UINT32_MAX) - 10) * 1000);
+	// millis() rolls over after 49 days, but time keeps going forward
+	const TimeTicks after = clock.update(10);
+	EXPECT_TRUE(after > before);
+	EXPECT_EQ((after - before).get_ticks(), 21000ULL);
+	EXPECT_EQ(clock.update(20).get_ticks(), (static_cast<uint64_t>(UINT32_MAX) + 21) * 1000);
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <stdlib.h>
+#include <stdint.h>
 
 /**
  * Templated implementation of a fixed-size deque
@@ -14,6 +15,16 @@ struct aligned_storage {
 	};
 };
 
+// the smallest unsigned integer that can count to max, so a small buffer doesn't spend a size_t on its length
+template<size_t max, bool fits_byte = (max <= UINT8_MAX), bool fits_short = (max <= UINT16_MAX)>
+struct buffer_index { using type = size_t; };
+
+template<size_t max, bool fits_short>
+struct buffer_index<max, true, fits_short> { using type = uint8_t; };
+
+template<size_t max>
+struct buffer_index<max, false, true> { using type = uint16_t; };
+
 #ifdef ARDUINO_ARCH_AVR
 // Default placement versions of operator new.
 inline void* operator new(size_t, void* __p) throw() { return __p; }
@@ -32,6 +43,7 @@ public:
 
 	// create an aligned array type 
 	using array_t = typename aligned_storage<sizeof(T), alignof(T)>::type;
+	using index_t = typename buffer_index<max_size>::type;
 
 	CircularBuffer<T, max_size>()
 		: m_array{}
@@ -53,6 +65,16 @@ public:
 
 	CircularBuffer& operator=(CircularBuffer& rhs) = delete;
 
+	// the buffer as it sits in memory, so only for plain data like packets, see Network::snapshot
+	// it's compacted first, so the same contents always look the same
+	template<class Archive>
+	void snapshot(Archive& archive) {
+		m_compact();
+		archive(m_array);
+		archive(m_length);
+		archive(m_start);
+	}
+
 	/** misc functions */
 	const array_t* get_raw() const { return m_array; }
 	array_t* get_raw() { return m_array; }
@@ -202,7 +224,7 @@ public:
 		// copy the memory over from the back or the front, whichever is closest
 		if (iter.m_index >= (m_length >> 1)) {
 			// copy from the back
-			for (auto i = iter.m_index; i < m_length - 1; i++) {
+			for (auto i = iter.m_index; i + 1 < m_length; i++) {
 				m_array[m_get_true_index(i, m_start)] = m_array[m_get_true_index(i + 1, m_start)];
 			}
 		}
@@ -226,7 +248,7 @@ public:
 		// copy the memory over from the back or the front, whichever is closest
 		if (iter.m_index >= (m_length >> 1)) {
 			// copy from the back
-			for (auto i = iter.m_index; i < m_length - 1; i++) {
+			for (auto i = iter.m_index; i + 1 < m_length; i++) {
 				m_array[m_get_true_index(i, m_start)] = m_array[m_get_true_index(i + 1, m_start)];
 			}
 		}
@@ -244,6 +266,14 @@ public:
 	}
 
 private:
+
+	// move what's in the buffer to the front and clear everything after it
+	void m_compact() {
+		array_t compact[max_size] = {};
+		for (size_t i = 0; i < m_length; i++) compact[i] = m_array[m_get_true_index(i, m_start)];
+		for (size_t i = 0; i < max_size; i++) m_array[i] = compact[i];
+		m_start = 0;
+	}
 	
 	static size_t m_get_true_index(const size_t index, const size_t m_start) {
 		const auto corIndex = m_start + index;
@@ -251,6 +281,6 @@ private:
 	}
 
 	array_t m_array[max_size];
-	size_t m_length;
-	size_t m_start;
+	index_t m_length;
+	index_t m_start;
 };
\ No newline at end of file
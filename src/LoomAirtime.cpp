@@ -0,0 +1,88 @@
+#include "LoomAirtime.h"
+
+using namespace LoomNet;
+
+// bandwidths selectable in register 0x1D, in Hz
+static constexpr uint32_t m_bandwidths[] = { 7800, 10400, 15600, 20800, 31250, 41700, 62500, 125000, 250000, 500000 };
+
+LoraAirtime::LoraAirtime(const uint8_t reg_1d, const uint8_t reg_1e, const uint8_t reg_26, const uint16_t preamble)
+	: m_reg_1d(reg_1d)
+	, m_reg_1e(reg_1e)
+	, m_reg_26(reg_26)
+	, m_preamble(preamble) {}
+
+uint32_t LoraAirtime::get_bandwidth() const {
+	const uint8_t index = m_reg_1d >> 4;
+	return index < sizeof(m_bandwidths) / sizeof(m_bandwidths[0]) ? m_bandwidths[index] : 0;
+}
+
+bool LoraAirtime::is_valid() const {
+	const uint8_t sf = get_spreading_factor();
+	const uint8_t cr = get_coding_rate();
+	return get_bandwidth() != 0
+		&& sf >= 6 && sf <= 12
+		&& cr >= 5 && cr <= 8
+		// spreading factor 6 only works in implicit header mode
+		&& (sf != 6 || !has_explicit_header());
+}
+
+uint32_t LoraAirtime::get_symbol_time() const {
+	if (!is_valid()) return 0;
+	const uint64_t chirps = static_cast<uint64_t>(1) << get_spreading_factor();
+	return static_cast<uint32_t>((chirps * 1000000 + get_bandwidth() - 1) / get_bandwidth());
+}
+
+uint64_t LoraAirtime::m_quarter_symbols(const uint8_t length) const {
+	// preamble, plus 4.25 symbols of sync word
+	const uint64_t preamble = static_cast<uint64_t>(m_preamble) * 4 + 17;
+	// the payload symbol count from the datasheet:
+	// 8 + max(ceil((8PL - 4SF + 28 + 16CRC - 20IH) / (4(SF - 2DE))) * CR, 0)
+	const int32_t sf = get_spreading_factor();
+	const int32_t bits = 8 * static_cast<int32_t>(length) - 4 * sf + 28
+		+ (has_crc() ? 16 : 0)
+		- (has_explicit_header() ? 0 : 20);
+	const int32_t per_block = 4 * (sf - (has_low_rate_optimize() ? 2 : 0));
+	const int32_t blocks = bits > 0 ? (bits + per_block - 1) / per_block : 0;
+	const uint64_t payload = 8 + static_cast<uint64_t>(blocks) * get_coding_rate();
+	return preamble + payload * 4;
+}
+
+uint32_t LoraAirtime::get_airtime(const uint8_t length) const {
+	if (!is_valid()) return 0;
+	// work in quarter symbols so the sync word stays exact
+	const uint64_t chirps = m_quarter_symbols(length) << get_spreading_factor();
+	const uint64_t divisor = static_cast<uint64_t>(get_bandwidth()) * 4;
+	const uint64_t time = (chirps * 1000000 + divisor - 1) / divisor;
+	return time > UINT32_MAX ? 0 : static_cast<uint32_t>(time);
+}
+
+uint32_t LoraAirtime::get_handshake_time(const uint32_t turnaround_us) const {
+	const uint32_t data = get_airtime(PACKET_MAX);
+	const uint32_t ack = get_airtime(ACK_LENGTH);
+	if (!data || !ack) return 0;
+	// DATA_TRANS and ACK_W_DATA can both be full packets
+	const uint64_t time = static_cast<uint64_t>(data) * 2 + ack + static_cast<uint64_t>(turnaround_us) * 3;
+	return time > UINT32_MAX ? 0 : static_cast<uint32_t>(time);
+}
+
+TimeInterval LoraAirtime::m_handshake_interval(const uint32_t turnaround_us) const {
+	const uint32_t time = get_handshake_time(turnaround_us);
+	if (!time) return TIME_NONE;
+	// the radios keep time in milliseconds
+	return { TimeInterval::MILLISECOND, (time + 999) / 1000 };
+}
+
+uint32_t LoraAirtime::get_sample_interval() const {
+	// the preamble is sent for another 4.25 symbols after the programmed length
+	const uint32_t quarters = static_cast<uint32_t>(m_preamble) * 4 + 17;
+	if (!is_valid() || quarters <= SAMPLE_SYMBOLS * 4) return 0;
+	return static_cast<uint32_t>((static_cast<uint64_t>(quarters - SAMPLE_SYMBOLS * 4) * get_symbol_time()) / 4);
+}
+
+TimeInterval LoraAirtime::get_min_drift(const TimeInterval& max_drift, const uint32_t turnaround_us) const {
+	return m_handshake_interval(turnaround_us) + max_drift;
+}
+
+TimeInterval LoraAirtime::get_slot_length(const TimeInterval& max_drift, const uint32_t turnaround_us) const {
+	return get_min_drift(max_drift, turnaround_us) + max_drift;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include "LoomNetworkUtility.h"
+#include "LoomNetworkTime.h"
+
+/**
+ * LoRa time-on-air calculator, following the Semtech SX127x datasheet
+ * Takes the same register values as RF95::ModemConfig, so the radio and the
+ * network configuration can share a single modem setup
+ */
+
+namespace LoomNet {
+	class LoraAirtime {
+	public:
+		// the ACK packet is only a control byte and a source address
+		static constexpr uint8_t ACK_LENGTH = 3;
+		// time for a radio to switch between transmitting and recieving, and
+		// for the MAC to process the packet in between
+		static constexpr uint32_t TURNAROUND_US = 10000;
+		// a channel activity check takes about two symbols, and the reciever needs
+		// about four more symbols of preamble left after it to lock on
+		static constexpr uint8_t SAMPLE_SYMBOLS = 6;
+
+		LoraAirtime(const uint8_t reg_1d, const uint8_t reg_1e, const uint8_t reg_26, const uint16_t preamble);
+
+		// register 0x1D
+		uint32_t get_bandwidth() const;
+		uint8_t get_coding_rate() const { return ((m_reg_1d >> 1) & 0x07) + 4; }
+		bool has_explicit_header() const { return !(m_reg_1d & 0x01); }
+		// register 0x1E
+		uint8_t get_spreading_factor() const { return m_reg_1e >> 4; }
+		bool has_crc() const { return (m_reg_1e & 0x04) != 0; }
+		// register 0x26
+		bool has_low_rate_optimize() const { return (m_reg_26 & 0x08) != 0; }
+		uint16_t get_preamble() const { return m_preamble; }
+		bool is_valid() const;
+
+		// all times are in microseconds, rounded up
+		uint32_t get_symbol_time() const;
+		uint32_t get_airtime(const uint8_t length) const;
+		// a full DATA_TRANS, ACK_W_DATA, ACK exchange with turnarounds in between
+		uint32_t get_handshake_time(const uint32_t turnaround_us = TURNAROUND_US) const;
+		// longest time between channel activity checks that can't miss a whole preamble, zero if the preamble is too short
+		uint32_t get_sample_interval() const;
+
+		// shortest safe timings for the handshake, given how far apart any two clocks can be
+		// min_drift is the recieve timeout, and the slot leaves room for a late peer to time out too
+		TimeInterval get_min_drift(const TimeInterval& max_drift, const uint32_t turnaround_us = TURNAROUND_US) const;
+		TimeInterval get_slot_length(const TimeInterval& max_drift, const uint32_t turnaround_us = TURNAROUND_US) const;
+
+	private:
+		uint64_t m_quarter_symbols(const uint8_t length) const;
+		TimeInterval m_handshake_interval(const uint32_t turnaround_us) const;
+
+		const uint8_t m_reg_1d;
+		const uint8_t m_reg_1e;
+		const uint8_t m_reg_26;
+		const uint16_t m_preamble;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "LoomBatchTuner.h"
+
+using namespace LoomNet;
+
+bool BatchTuner::tune(Slotter& slot) {
+	// the very first refresh has no traffic to go off of
+	if (!is_enabled() || !m_slots) return false;
+	m_last_load = static_cast<uint8_t>((static_cast<uint32_t>(m_busy) * 100) / m_slots);
+	m_slots = 0;
+	m_busy = 0;
+	// anything between the two thresholds leaves the schedule alone, and a trend
+	// has to last for a few batches before we act on it
+	const Trend trend = m_last_load >= BUSY_PERCENT
+		? Trend::BUSY
+		: (m_last_load <= IDLE_PERCENT ? Trend::IDLE : Trend::STEADY);
+	if (trend != m_trend) {
+		m_trend = trend;
+		m_streak = 0;
+	}
+	if (trend == Trend::STEADY || ++m_streak < m_hold) return false;
+	m_streak = 0;
+	// move a single step at a time: gaps first, then the number of cycles
+	uint8_t cycles = slot.get_cycles_per_refresh();
+	uint8_t cycle_gap = slot.get_cycle_gap();
+	uint8_t batch_gap = slot.get_batch_gap();
+	if (trend == Trend::BUSY) {
+		if (cycle_gap > m_min_cycle_gap) cycle_gap--;
+		else if (batch_gap > m_min_batch_gap) batch_gap--;
+		else if (cycles < m_max_cycles) cycles++;
+		else return false;
+	}
+	else {
+		if (cycle_gap < m_max_cycle_gap) cycle_gap++;
+		else if (batch_gap < m_max_batch_gap) batch_gap++;
+		else if (cycles > m_min_cycles) cycles--;
+		else return false;
+	}
+	return slot.set_batch_params(cycles, cycle_gap, batch_gap);
+}
+
+void BatchTuner::reset() {
+	m_trend = Trend::STEADY;
+	m_streak = 0;
+	m_last_load = 0;
+	m_slots = 0;
+	m_busy = 0;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+#include <stdint.h>
+#include "LoomSlotter.h"
+
+/**
+ * Coordinator side tracker that adjusts the batch parameters to the traffic seen
+ * during each batch. The new parameters are sent out with the next refresh.
+ */
+
+namespace LoomNet {
+	class BatchTuner {
+	public:
+		enum class Trend : uint8_t {
+			STEADY,
+			BUSY,
+			IDLE
+		};
+
+		// percent of the coordinator's recieve slots carrying data
+		static constexpr uint8_t BUSY_PERCENT = 75;
+		static constexpr uint8_t IDLE_PERCENT = 25;
+
+		constexpr BatchTuner(	const uint8_t	min_cycles,
+								const uint8_t	max_cycles,
+								const uint8_t	min_cycle_gap,
+								const uint8_t	max_cycle_gap,
+								const uint8_t	min_batch_gap,
+								const uint8_t	max_batch_gap,
+								const uint8_t	hold_batches)
+			: m_min_cycles(min_cycles)
+			, m_max_cycles(max_cycles)
+			, m_min_cycle_gap(min_cycle_gap)
+			, m_max_cycle_gap(max_cycle_gap)
+			, m_min_batch_gap(min_batch_gap)
+			, m_max_batch_gap(max_batch_gap)
+			, m_hold(hold_batches)
+			, m_trend(Trend::STEADY)
+			, m_streak(0)
+			, m_last_load(0)
+			, m_slots(0)
+			, m_busy(0) {}
+
+		// a tuner that never changes anything
+		constexpr BatchTuner()
+			: BatchTuner(0, 0, 0, 0, 0, 0, 0) {}
+
+		bool operator==(const BatchTuner& rhs) const {
+			return (rhs.m_min_cycles == m_min_cycles)
+				&& (rhs.m_max_cycles == m_max_cycles)
+				&& (rhs.m_min_cycle_gap == m_min_cycle_gap)
+				&& (rhs.m_max_cycle_gap == m_max_cycle_gap)
+				&& (rhs.m_min_batch_gap == m_min_batch_gap)
+				&& (rhs.m_max_batch_gap == m_max_batch_gap)
+				&& (rhs.m_hold == m_hold);
+		}
+
+		constexpr bool is_enabled() const { return m_hold != 0; }
+		constexpr uint8_t get_min_cycles() const { return m_min_cycles; }
+		constexpr uint8_t get_max_cycles() const { return m_max_cycles; }
+		constexpr uint8_t get_min_cycle_gap() const { return m_min_cycle_gap; }
+		constexpr uint8_t get_max_cycle_gap() const { return m_max_cycle_gap; }
+		constexpr uint8_t get_min_batch_gap() const { return m_min_batch_gap; }
+		constexpr uint8_t get_max_batch_gap() const { return m_max_batch_gap; }
+		constexpr uint8_t get_hold() const { return m_hold; }
+		Trend get_trend() const { return m_trend; }
+		uint8_t get_last_load() const { return m_last_load; }
+
+		// call once for every recieve slot, and once more if data arrived in that slot
+		void count_slot() { if (m_slots != UINT16_MAX) m_slots++; }
+		void count_busy() { if (m_busy != UINT16_MAX) m_busy++; }
+		// call at the batch boundary, returns true if the slotter was changed
+		bool tune(Slotter& slot);
+		void reset();
+		// everything that changes while running, see Network::snapshot
+		template<class Archive>
+		void snapshot(Archive& archive) {
+			archive(m_trend);
+			archive(m_streak);
+			archive(m_last_load);
+			archive(m_slots);
+			archive(m_busy);
+		}
+
+	private:
+		const uint8_t m_min_cycles;
+		const uint8_t m_max_cycles;
+		const uint8_t m_min_cycle_gap;
+		const uint8_t m_max_cycle_gap;
+		const uint8_t m_min_batch_gap;
+		const uint8_t m_max_batch_gap;
+		// batches in a row a trend must hold before the schedule moves
+		const uint8_t m_hold;
+		Trend m_trend;
+		uint8_t m_streak;
+		uint8_t m_last_load;
+		uint16_t m_slots;
+		uint16_t m_busy;
+	};
+
+	constexpr BatchTuner BATCH_FIXED = BatchTuner();
+}
\ No newline at end of file
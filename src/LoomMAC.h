@@ -7,18 +7,26 @@
 #include "LoomRadio.h"
 #include "LoomNetworkInfo.h"
 #include "LoomNetworkTime.h"
+#include "LoomNetworkState.h"
+#include "LoomNetworkRole.h"
 
 /** 
  * Loom Medium Access Control 
  * Operates synchronously
+ *
+ * Templated on the radio driver, so every radio call in the polling loop goes straight
+ * to the driver and can be inlined. MAC is the one for a radio picked at runtime, through
+ * the virtual Radio interface, see RadioAdapter. A role leaves out the refresh code the
+ * device never runs, see LoomNetworkRole.h.
  */
 
 /** This class will serve entirely for simulation for now */
 namespace LoomNet {
-	class MAC {
+	// everything about the MAC that doesn't depend on the radio
+	class MACBase {
 	public:
 
-		enum class State {
+		enum class State : uint8_t {
 			MAC_SLEEP_RDY,
 			MAC_DATA_SEND_RDY,
 			MAC_DATA_WAIT,
@@ -28,14 +36,14 @@ namespace LoomNet {
 			MAC_CLOSED
 		};
 
-		enum class SendType {
+		enum class SendType : uint8_t {
 			MAC_ACK_WITH_DATA,
 			MAC_ACK_NO_DATA,
 			MAC_DATA,
 			NONE
 		};
 
-		enum class Error {
+		enum class Error : uint8_t {
 			MAC_OK,
 			SEND_FAILED,
 			WRONG_PACKET_TYPE,
@@ -43,14 +51,22 @@ namespace LoomNet {
 			REFRESH_PACKET_ERR,
 			INVALID_CONFIG,
 		};
+	};
+
+	template<class RadioImpl, class Role = AnyRole>
+	class BasicMAC : public MACBase {
+	public:
 
-		MAC(	const uint16_t self_addr, 
+		BasicMAC(	const uint16_t self_addr, 
 				const DeviceType self_type, 
 				const Slotter& slot,
 				const Drift& timing,
-				Radio& radio);
+				const BatchTuner& tuner,
+				RadioImpl& radio);
+		// the same MAC in the same state, talking through a different radio
+		BasicMAC(const BasicMAC& rhs, RadioImpl& radio);
 
-		bool operator==(const MAC& rhs) const {
+		bool operator==(const BasicMAC& rhs) const {
 			return (rhs.m_slot == m_slot)
 				&& (rhs.m_self_addr == m_self_addr)
 				&& (rhs.m_self_type == m_self_type);
@@ -60,18 +76,48 @@ namespace LoomNet {
 		Error get_last_error() const { return m_last_error; }
 		const Slotter& get_slotter() const { return m_slot; }
 		const Drift& get_drift() const { return m_timings; }
+		const BatchTuner& get_tuner() const { return m_tuner; }
 		uint16_t get_cur_send_address() const { return m_cur_send_addr; }
 
 		void reset();
 		void sleep_wake_ack();
-		TimeInterval sleep_next_wake_time() const;
+		TimeTicks sleep_next_wake_time() const;
 		// make sure the address is correct!
 		bool send_fragment(const Packet& frag);
-		Packet get_staged_packet();
+		// the staged packet where it is, until it's taken or dropped
+		const Packet& peek_staged_packet() const { return m_staging; }
+		// copy the staged packet out into a buffer of the caller's, and move on
+		bool take_staged_packet(Packet& into);
+		// move on without it, when the network has no use for it
+		void drop_staged_packet();
 		void send_pass();
 		State check_for_data();
 		void data_pass();
 		void check_for_refresh();
+		// the timing needed to rejoin after losing power, false until the first refresh
+		bool save_state(NetworkState& state) const;
+		// sleep until the next refresh instead of listening for it, only right after power on or reset
+		bool restore_state(const NetworkState& state);
+		// everything that changes while running, but not the configuration, see Network::snapshot
+		template<class Archive>
+		void snapshot(Archive& archive) {
+			m_slot.snapshot(archive);
+			m_tuner.snapshot(archive);
+			archive(m_state);
+			archive(m_send_type);
+			archive(m_last_error);
+			archive(m_cur_send_addr);
+			archive(m_time_wake_start);
+			archive(m_staging);
+			archive(m_next_refresh);
+			archive(m_next_data);
+			archive(m_refresh_period);
+			archive(m_rejoining);
+			archive(m_batch_tuned);
+			archive(m_next_sample);
+			archive(m_slot_phase);
+			archive(m_fail_count);
+		}
 	private:
 
 		void m_send_ack() {
@@ -80,23 +126,574 @@ namespace LoomNet {
 		}
 
 		void m_halt_error(const Error error);
+		// whether we're the coordinator, which a build for one role knows without looking
+		bool m_sends_refresh() const {
+			return Role::sends_refresh && (!Role::follows_refresh || m_self_type == DeviceType::COORDINATOR);
+		}
+		// sleep until the next channel sample while looking for the first refresh, if the radio can
+		void m_sleep_until_sample();
+		// whether m_staging is waiting on the network, which empties it by setting it to NONE
+		bool m_has_staged() const { return m_staging.get_control() != PacketCtrl::NONE; }
 
 		Slotter m_slot;
+		BatchTuner m_tuner;
 		State m_state;
 		SendType m_send_type;
 		Error m_last_error;
+		// the refresh we woke for came from a saved state, so don't trust it until we hear one
+		bool m_rejoining;
+		// the last refresh carried batch parameters, so the next one might change them
+		bool m_batch_tuned;
+		uint8_t m_fail_count;
 		uint16_t m_cur_send_addr;
-		TimeInterval m_time_wake_start;
+		TimeTicks m_time_wake_start;
 		Packet m_staging;
-		bool m_staged;
-		TimeInterval m_next_refresh;
-		TimeInterval m_next_data;
-		uint8_t m_fail_count;
-		Radio& m_radio;
+		TimeTicks m_next_refresh;
+		TimeTicks m_next_data;
+		// time from one refresh to the next, as last announced
+		TimeTicks m_refresh_period;
+		// when to check the channel again while looking for the network, NONE if we're listening the whole time
+		TimeTicks m_next_sample;
+		// when we last heard the start of a slot while looking for the network, so we can sample around it
+		TimeTicks m_slot_phase;
+		RadioImpl& m_radio;
 		const uint16_t m_self_addr;
 		const DeviceType m_self_type;
 		const Drift m_timings;
-		// TODO: remove
-		int m_check_count = 0;
+		// m_timings as ticks, so we don't convert units every poll
+		const TimeTicks m_slot_ticks;
+		const TimeTicks m_min_drift_ticks;
+		const TimeTicks m_max_drift_ticks;
 	};
+
+	// the MAC for a radio picked at runtime, built once in LoomMAC.cpp
+	using MAC = BasicMAC<Radio>;
+}
+
+
+template<class RadioImpl, class Role>
+LoomNet::BasicMAC<RadioImpl, Role>::BasicMAC(const uint16_t self_addr, const DeviceType self_type, const Slotter& slot, const Drift& timing, const BatchTuner& tuner, RadioImpl& radio)
+	: m_slot(slot)
+	, m_tuner(tuner)
+	, m_state(State::MAC_REFRESH_WAIT)
+	, m_send_type(SendType::NONE)
+	, m_last_error(Error::MAC_OK)
+	, m_rejoining(false)
+	, m_batch_tuned(false)
+	, m_fail_count(0)
+	, m_cur_send_addr(ADDR_NONE)
+	, m_time_wake_start(TICKS_NONE)
+	, m_staging(PacketCtrl::NONE, ADDR_NONE)
+	, m_next_refresh(TICKS_NONE)
+	, m_next_data(TICKS_NONE)
+	, m_refresh_period(TICKS_NONE)
+	, m_next_sample(TICKS_NONE)
+	, m_slot_phase(TICKS_NONE)
+	, m_radio(radio)
+	, m_self_addr(self_addr)
+	, m_self_type(self_type)
+	, m_timings(timing)
+	, m_slot_ticks(timing.slot_length)
+	, m_min_drift_ticks(timing.min_drift)
+	, m_max_drift_ticks(timing.max_drift) {
+	// error check
+	if (slot.get_state() == Slotter::State::SLOT_ERROR
+		|| self_type == DeviceType::ERROR
+		|| !Role::allows(self_type)
+		|| self_addr == ADDR_ERROR
+		|| self_addr == ADDR_NONE)
+		m_halt_error(Error::INVALID_CONFIG);
+}
+
+template<class RadioImpl, class Role>
+LoomNet::BasicMAC<RadioImpl, Role>::BasicMAC(const BasicMAC& rhs, RadioImpl& radio)
+	: m_slot(rhs.m_slot)
+	, m_tuner(rhs.m_tuner)
+	, m_state(rhs.m_state)
+	, m_send_type(rhs.m_send_type)
+	, m_last_error(rhs.m_last_error)
+	, m_rejoining(rhs.m_rejoining)
+	, m_batch_tuned(rhs.m_batch_tuned)
+	, m_fail_count(rhs.m_fail_count)
+	, m_cur_send_addr(rhs.m_cur_send_addr)
+	, m_time_wake_start(rhs.m_time_wake_start)
+	, m_staging(rhs.m_staging)
+	, m_next_refresh(rhs.m_next_refresh)
+	, m_next_data(rhs.m_next_data)
+	, m_refresh_period(rhs.m_refresh_period)
+	, m_next_sample(rhs.m_next_sample)
+	, m_slot_phase(rhs.m_slot_phase)
+	, m_radio(radio)
+	, m_self_addr(rhs.m_self_addr)
+	, m_self_type(rhs.m_self_type)
+	, m_timings(rhs.m_timings)
+	, m_slot_ticks(rhs.m_slot_ticks)
+	, m_min_drift_ticks(rhs.m_min_drift_ticks)
+	, m_max_drift_ticks(rhs.m_max_drift_ticks) {}
+
+template<class RadioImpl, class Role>
+void LoomNet::BasicMAC<RadioImpl, Role>::reset() {
+	m_state = State::MAC_REFRESH_WAIT;
+	m_send_type = SendType::NONE;
+	m_last_error = Error::MAC_OK;
+	m_staging = Packet(PacketCtrl::NONE, ADDR_NONE);
+	m_next_refresh = TICKS_NONE;
+	m_next_data = TICKS_NONE;
+	m_refresh_period = TICKS_NONE;
+	m_rejoining = false;
+	m_batch_tuned = false;
+	m_next_sample = TICKS_NONE;
+	m_slot_phase = TICKS_NONE;
+	m_time_wake_start = TICKS_NONE;
+	m_cur_send_addr = ADDR_NONE;
+	m_slot.reset();
+	m_tuner.reset();
+	m_fail_count = 0;
+	// reset radio
+	if (m_radio.get_state() == Radio::State::IDLE) m_radio.sleep();
+	m_radio.disable();
+	m_radio.enable();
+	m_radio.wake();
+}
+
+template<class RadioImpl, class Role>
+void LoomNet::BasicMAC<RadioImpl, Role>::sleep_wake_ack() {
+	// TODO: timing stuff here
+	// in the meantime, we assume that the timing is always correct
+	// if we're sampling for the first refresh, go back to looking without touching the slotter
+	if (m_next_refresh.is_none() && !m_next_sample.is_none()) {
+		m_next_sample = TICKS_NONE;
+		m_state = State::MAC_REFRESH_WAIT;
+		m_radio.wake();
+		return;
+	}
+	// update our state
+	const Slotter::State cur_state = m_slot.get_state();
+	if (cur_state == Slotter::State::SLOT_WAIT_REFRESH) {
+		m_state = State::MAC_REFRESH_WAIT;
+		m_send_type = SendType::NONE;
+		// wake the radio premptivly to improve recieving response time
+		m_radio.wake();
+	}
+	else if (cur_state == Slotter::State::SLOT_SEND || cur_state == Slotter::State::SLOT_SEND_W_SYNC) {
+		m_state = State::MAC_DATA_SEND_RDY;
+		m_send_type = SendType::MAC_DATA;
+		// set the current send address to our parent
+		m_cur_send_addr = get_parent(m_self_addr, m_self_type);
+	}
+	else if (cur_state == Slotter::State::SLOT_RECV || cur_state == Slotter::State::SLOT_RECV_W_SYNC) {
+		m_state = State::MAC_DATA_WAIT;
+		m_send_type = SendType::MAC_ACK_WITH_DATA;
+		if (Role::sends_refresh) m_tuner.count_slot();
+		// wake the radio premptivly to improve recieving response time
+		m_radio.wake();
+	}
+	else m_state = State::MAC_CLOSED;
+	// reset the wake time to what it's supposed to be
+	m_time_wake_start = sleep_next_wake_time();
+	// move the slotter forward
+	m_slot.next_state();
+}
+
+// simulation time is in slots remaining
+// we do one slot for debugging purposes
+
+template<class RadioImpl, class Role>
+LoomNet::TimeTicks LoomNet::BasicMAC<RadioImpl, Role>::sleep_next_wake_time() const {
+	const Slotter::State state = m_slot.get_state();
+	const TimeTicks rel_sleep = m_slot_ticks * m_slot.get_slot_wait();
+	if (m_next_refresh.is_none() && !m_next_sample.is_none())
+		return m_next_sample;
+	else if (state == Slotter::State::SLOT_WAIT_REFRESH)
+		return m_next_refresh;
+	// else if it's the first cycle, we have to account for synchronizing the data
+	// cycle
+	else if ((state == Slotter::State::SLOT_RECV_W_SYNC || state == Slotter::State::SLOT_SEND_W_SYNC) && !m_next_data.is_none())
+		return m_next_data + rel_sleep;
+	else
+		return m_time_wake_start + rel_sleep + m_slot_ticks;
+}
+
+// make sure the address is correct!
+
+template<class RadioImpl, class Role>
+bool LoomNet::BasicMAC<RadioImpl, Role>::send_fragment(const Packet& frag) {
+	// sanity check
+	if (m_state == State::MAC_DATA_SEND_RDY && !m_has_staged()) {
+		// write to the "network"
+		m_staging = frag;
+		// set the ACK bit if needed
+		if (m_send_type == SendType::MAC_ACK_WITH_DATA)
+			m_staging.set_control(PacketCtrl::DATA_ACK_W_DATA);
+		else
+			m_staging.set_control(PacketCtrl::DATA_TRANS);
+		// set the self address
+		m_staging.set_src(m_self_addr);
+		// commit the framecheck
+		m_staging.set_framecheck();
+		// wake the radio if needed
+		if (m_radio.get_state() == Radio::State::SLEEP) m_radio.wake();
+		m_radio.send(m_staging);
+		// change the state!
+		if (m_send_type == SendType::MAC_DATA) {
+			m_state = State::MAC_DATA_WAIT;
+			m_send_type = SendType::MAC_ACK_NO_DATA;
+		}
+		else if (m_send_type == SendType::MAC_ACK_WITH_DATA) {
+			m_state = State::MAC_DATA_WAIT;
+			m_send_type = SendType::NONE;
+		}
+		else {
+			m_state = State::MAC_SLEEP_RDY;
+			m_radio.sleep();
+		}
+		return true;
+	}
+	return false;
+}
+
+template<class RadioImpl, class Role>
+bool LoomNet::BasicMAC<RadioImpl, Role>::take_staged_packet(Packet& into) {
+	if (!m_has_staged()) return false;
+	into = m_staging;
+	drop_staged_packet();
+	return true;
+}
+
+template<class RadioImpl, class Role>
+void LoomNet::BasicMAC<RadioImpl, Role>::drop_staged_packet() {
+	if (m_has_staged()) {
+		if (m_state == State::MAC_DATA_RECV_RDY && m_send_type == SendType::MAC_ACK_WITH_DATA) {
+			// next state!
+			m_state = State::MAC_DATA_SEND_RDY;
+			// additionally, set the send endpoint to the recieved address
+			m_cur_send_addr = m_staging.get_src();
+		}
+		else {
+			// next state!
+			m_state = State::MAC_SLEEP_RDY;
+			m_radio.sleep();
+		}
+		// empty the staging area
+		m_staging.set_control(PacketCtrl::NONE);
+	}
+}
+
+template<class RadioImpl, class Role>
+void LoomNet::BasicMAC<RadioImpl, Role>::send_pass() {
+	if (m_state == State::MAC_DATA_SEND_RDY) {
+		// check if we need to send an ACK
+		if (m_send_type == SendType::MAC_ACK_WITH_DATA) {
+			// send a regular ACK instead of a fancy one
+			m_send_ack();
+		}
+		// set the state to sleep
+		m_state = State::MAC_SLEEP_RDY;
+		// radio is already asleep
+		if (m_radio.get_state() == Radio::State::IDLE)
+			m_radio.sleep();
+	}
+}
+
+template<class RadioImpl, class Role>
+LoomNet::MACBase::State LoomNet::BasicMAC<RadioImpl, Role>::check_for_data() {
+	if (m_state == State::MAC_DATA_WAIT) {
+		// check our network
+		TimeTicks stamp(TICKS_NONE);
+		const Packet& recv(m_radio.recv(stamp));
+		// check that the packet is not emptey, is not corrupted, and not from ourselves
+		if (recv.get_control() != PacketCtrl::NONE
+			&& recv.check_packet(m_cur_send_addr)
+			&& recv.get_src() != m_self_addr) {
+			// a packet! wow.
+			// check to see if it's the right kind of packet
+			const PacketCtrl ctrl = recv.get_control();
+			if (ctrl == PacketCtrl::DATA_TRANS && m_send_type == SendType::MAC_ACK_WITH_DATA) {
+				// first stage packet, recieve it then signal we're ready to send
+				if (Role::sends_refresh) m_tuner.count_busy();
+				m_staging = recv;
+				m_state = State::MAC_DATA_RECV_RDY;
+			}
+			else if (ctrl == PacketCtrl::DATA_ACK_W_DATA && m_send_type == SendType::MAC_ACK_NO_DATA) {
+				// second stage packet with data, send an ACK and tell the device
+				// can recieve
+				m_send_ack();
+				// ready for next reply
+				m_staging = recv;
+				m_state = State::MAC_DATA_RECV_RDY;
+			}
+			else if (ctrl == PacketCtrl::DATA_ACK
+				&& (m_send_type == SendType::MAC_ACK_NO_DATA || m_send_type == SendType::NONE)) {
+
+				// clear the staged packet, since it sent successfully
+				m_staging.set_control(PacketCtrl::NONE);
+				// set fail count to zero
+				m_fail_count = 0;
+				// got an ACK! Guess we're finished with this transaction
+				m_state = State::MAC_SLEEP_RDY;
+				m_radio.sleep();
+			}
+			else {
+				// TODO: make error handling less brittle
+				m_halt_error(Error::WRONG_PACKET_TYPE);
+			}
+		}
+		else {
+			if (recv.get_control() != PacketCtrl::NONE) {
+				// Serial.println("Discarded corrputed packet");
+			}
+			// check the timeout
+			const TimeTicks delta = m_radio.get_time() - m_time_wake_start;
+			if (delta >= m_min_drift_ticks) {
+				// I suppose you have nothing to say for yourself
+				// very well
+				// increment fail counter depending on if we transmitted and didn't get anything back
+				if ((m_send_type == SendType::MAC_ACK_NO_DATA
+					|| m_send_type == SendType::NONE)
+					&& ++m_fail_count >= FAIL_MAX) {
+					// reset the slotter, to trigger a refresh
+					m_slot.reset();
+				}
+				m_send_type = SendType::NONE;
+				if (m_has_staged()) m_state = State::MAC_DATA_SEND_FAIL;
+				else {
+					m_state = State::MAC_SLEEP_RDY;
+					m_radio.sleep();
+				}
+			}
+		}
+	}
+	return m_state;
+}
+
+template<class RadioImpl, class Role>
+void LoomNet::BasicMAC<RadioImpl, Role>::data_pass() {
+	// we don't or can't recieve whatever is happening for this slot
+	// ignore all and move on
+	if (m_state == State::MAC_DATA_WAIT) {
+		// we had no room for this slot's data, which counts as a busy slot
+		if (Role::sends_refresh && m_send_type == SendType::MAC_ACK_WITH_DATA) m_tuner.count_busy();
+		m_state = State::MAC_SLEEP_RDY;
+		if (m_radio.get_state() == Radio::State::IDLE) m_radio.sleep();
+	}
+}
+
+template<class RadioImpl, class Role>
+void LoomNet::BasicMAC<RadioImpl, Role>::check_for_refresh() {
+	// wake the radio if needed, since this is the first function called on startup
+	if (m_radio.get_state() == Radio::State::DISABLED) {
+		m_radio.enable();
+		m_radio.wake();
+	}
+	// reset fail count since fail count is per batch
+	m_fail_count = 0;
+	// the coordinator picks the batch parameters for the coming batch before announcing it
+	if (m_sends_refresh()) m_tuner.tune(m_slot);
+	// calculate the number of slots remaining until the next refresh using preconfigured values
+	const uint32_t slots_until_refresh = m_slot.get_slots_per_refresh();
+	// if we're a router or end device, just check and see if anyone has transmitted a signal
+	// and if we haven't already (this should only happen on first power on) set the idle timestamp
+	if (m_time_wake_start.is_none())
+		m_time_wake_start = m_radio.get_time();
+	if (!m_sends_refresh()) {
+		// check our "network"
+		TimeTicks stamp(TICKS_NONE);
+		const Packet& recv(m_radio.recv(stamp));
+		if (recv.get_control() != PacketCtrl::NONE) {
+			// guess we got a refresh packet!
+			// Additionally, we are supposed to do retransmission here, but I
+			// have to ignore that for now
+			// TODO: Retransmission
+			if (recv.get_control() == PacketCtrl::REFRESH_INITIAL
+				&& recv.check_packet(m_self_addr)) {
+				const RefreshPacket& ref_frag = recv.as<RefreshPacket>();
+				// follow the batch parameters of the coordinator, if it sent any
+				if (ref_frag.has_batch_params()
+					&& !m_slot.set_batch_params(ref_frag.get_cycles_per_batch(), ref_frag.get_cycle_gap(), ref_frag.get_batch_gap())) {
+					m_halt_error(Error::REFRESH_PACKET_ERR);
+					return;
+				}
+				m_batch_tuned = ref_frag.has_batch_params();
+				// set the next data and refresh cycle based on the data
+				m_next_data = TimeTicks(ref_frag.get_data_interval()) + stamp;
+				m_next_refresh = TimeTicks(ref_frag.get_refresh_interval()) + stamp;
+				// we wake up max_drift before the coordinator sends
+				m_refresh_period = TimeTicks(ref_frag.get_refresh_interval()) + m_max_drift_ticks;
+				m_rejoining = false;
+				m_slot_phase = TICKS_NONE;
+				m_state = State::MAC_SLEEP_RDY;
+				m_radio.sleep();
+				// increment the slotter state, if we haven't already via sleep_wake_ack
+				if (m_slot.get_state() == Slotter::State::SLOT_WAIT_REFRESH)
+					m_slot.next_state();
+			}
+			// anything else means the network is out there, so keep sampling
+			// data transmissions and refreshes both start right at the beginning of a slot
+			else if (m_next_refresh.is_none()) {
+				if (recv.get_control() == PacketCtrl::DATA_TRANS || recv.get_control() == PacketCtrl::REFRESH_INITIAL)
+					m_slot_phase = stamp;
+				m_sleep_until_sample();
+			}
+		}
+		// if we haven't recieved anything, track how many slots it's been
+		// if it's been over the reasonable number of slots, fail
+		else {
+			const TimeTicks delta = m_radio.get_time() - m_time_wake_start;
+			const TimeTicks refresh_cycle_length = m_slot_ticks * REFRESH_CYCLE_SLOTS;
+			if (m_next_refresh.is_none()) {
+				// if we lost a tuned refresh the batch may have grown by a step, which is never more than another batch
+				if (delta >= m_slot_ticks * (slots_until_refresh * (m_batch_tuned ? 2U : 1U) + REFRESH_CYCLE_SLOTS)) {
+					// first refresh didn't work, so hard fail
+					m_halt_error(Error::REFRESH_TIMEOUT);
+				}
+				else m_sleep_until_sample();
+			}
+			else if (m_rejoining && delta >= refresh_cycle_length) {
+				// the saved timing was wrong, so listen for the next refresh like on first power on
+				m_rejoining = false;
+				m_next_refresh = TICKS_NONE;
+				m_time_wake_start = m_radio.get_time();
+			}
+			else if (!m_rejoining && m_batch_tuned && delta >= refresh_cycle_length - m_max_drift_ticks) {
+				// the refresh we missed could have changed the batch, and guessing with the old one would
+				// keep us out of sync for good, so listen for the next refresh like on first power on
+				m_next_refresh = TICKS_NONE;
+				m_time_wake_start = m_radio.get_time();
+			}
+			else if (!m_rejoining && delta >= refresh_cycle_length - m_max_drift_ticks) {
+				// no refresh, but I guess we can just guess the values we got are still correct
+				// create values based on preconfigured settings and previous timings
+				m_next_data = m_time_wake_start + refresh_cycle_length;
+				// subtract what we've already waited from the total slots until refersh
+				m_next_refresh = m_time_wake_start + m_slot_ticks * slots_until_refresh;
+				m_state = State::MAC_SLEEP_RDY;
+				m_radio.sleep();
+			}
+		}
+	}
+	// else we're a coordinator and we need to do the refresh ourselves
+	else {
+		// write to the network
+		// TODO: exact timings
+		// subtract the drift we correct with when waking up to transmit
+		const TimeTicks next_data_ticks = m_slot_ticks * REFRESH_CYCLE_SLOTS - m_max_drift_ticks;
+		const TimeTicks next_refresh_ticks = m_slot_ticks * slots_until_refresh - m_max_drift_ticks;
+		// the packet keeps the unit compressed format, so downcast both to the right sizes
+		TimeInterval next_data_relative(next_data_ticks.to_interval());
+		TimeInterval next_refresh_relative(next_refresh_ticks.to_interval());
+		next_data_relative.downcast(UCHAR_MAX);
+		next_refresh_relative.downcast(USHRT_MAX);
+		// error check our timing stuff
+		if (next_data_relative.is_none() || next_refresh_relative.is_none()) {
+			m_halt_error(Error::REFRESH_PACKET_ERR);
+			return;
+		}
+		// else send the packet!
+		Packet frag = m_tuner.is_enabled()
+			? RefreshPacket::Factory(m_self_addr,
+				next_data_relative,
+				next_refresh_relative,
+				0,
+				m_slot.get_cycles_per_refresh(),
+				m_slot.get_cycle_gap(),
+				m_slot.get_batch_gap())
+			: RefreshPacket::Factory(m_self_addr,
+				next_data_relative,
+				next_refresh_relative,
+				0);
+		frag.set_framecheck();
+		const TimeTicks time_now(m_radio.get_time());
+		m_radio.send(frag);
+		// next state!
+		// use the values as sent, so we round the same way as everyone else
+		m_next_data = TimeTicks(next_data_relative) + time_now;
+		m_next_refresh = TimeTicks(next_refresh_relative) + m_max_drift_ticks + time_now;
+		m_refresh_period = m_next_refresh - time_now;
+		m_state = State::MAC_SLEEP_RDY;
+		m_radio.sleep();
+		// increment the slotter state, if we haven't already via sleep_wake_ack
+		if (m_slot.get_state() == Slotter::State::SLOT_WAIT_REFRESH)
+			m_slot.next_state();
+	}
+}
+
+template<class RadioImpl, class Role>
+bool LoomNet::BasicMAC<RadioImpl, Role>::save_state(NetworkState& state) const {
+	if (m_state == State::MAC_CLOSED || m_next_refresh.is_none() || m_refresh_period.is_none()) return false;
+	state.address = m_self_addr;
+	state.total_slots = m_slot.get_total_slots();
+	state.cycles_per_batch = m_slot.get_cycles_per_refresh();
+	state.cycle_gap = m_slot.get_cycle_gap();
+	state.batch_gap = m_slot.get_batch_gap();
+	state.next_refresh = m_next_refresh;
+	state.refresh_period = m_refresh_period;
+	return true;
+}
+
+template<class RadioImpl, class Role>
+bool LoomNet::BasicMAC<RadioImpl, Role>::restore_state(const NetworkState& state) {
+	const TimeTicks now = m_radio.get_time();
+	// only before we've started looking for the network, and with the same configuration
+	if (m_state != State::MAC_REFRESH_WAIT
+		|| !m_next_refresh.is_none()
+		|| !m_time_wake_start.is_none()
+		|| state.address != m_self_addr
+		|| state.total_slots != m_slot.get_total_slots()
+		|| state.next_refresh.is_none()
+		|| state.refresh_period.is_none()
+		|| !state.refresh_period.get_ticks()
+		// a refresh more than a period away means the clock started over while the power was off
+		|| (state.next_refresh > now && state.next_refresh - now > state.refresh_period)
+		|| !m_slot.set_batch_params(state.cycles_per_batch, state.cycle_gap, state.batch_gap)) return false;
+	// skip every refresh we missed while the power was off
+	m_next_refresh = state.next_refresh;
+	if (m_next_refresh < now)
+		m_next_refresh = m_next_refresh + state.refresh_period * static_cast<uint32_t>((now - m_next_refresh).get_ticks() / state.refresh_period.get_ticks() + 1);
+	m_refresh_period = state.refresh_period;
+	// the coordinator sets the timing, so it can always trust it
+	m_rejoining = !m_sends_refresh();
+	// the radio starts asleep after being enabled
+	if (m_radio.get_state() == Radio::State::DISABLED) m_radio.enable();
+	else if (m_radio.get_state() == Radio::State::IDLE) m_radio.sleep();
+	m_state = State::MAC_SLEEP_RDY;
+	return true;
+}
+
+template<class RadioImpl, class Role>
+void LoomNet::BasicMAC<RadioImpl, Role>::m_sleep_until_sample() {
+	const TimeTicks interval = m_radio.get_sample_interval();
+	if (interval.is_none() || !interval.get_ticks()) return;
+	const TimeTicks now = m_radio.get_time();
+	TimeTicks next = now + interval;
+	// once we know where slots start, only sample in the window around the start where
+	// the refresh could land, and skip the rest of the slot
+	const TimeTicks margin = m_max_drift_ticks + interval;
+	const uint64_t slot = m_slot_ticks.get_ticks();
+	if (!m_slot_phase.is_none() && slot && (margin + margin).get_ticks() < slot) {
+		// how far we are into the window, which opens margin before the slot start
+		const uint64_t into = ((now + margin).get_ticks() % slot + slot - m_slot_phase.get_ticks() % slot) % slot;
+		if (into + interval.get_ticks() > (margin + margin).get_ticks())
+			next = now + TimeTicks(slot - into);
+	}
+	m_next_sample = next;
+	m_state = State::MAC_SLEEP_RDY;
+	m_radio.sleep();
 }
+
+template<class RadioImpl, class Role>
+void LoomNet::BasicMAC<RadioImpl, Role>::m_halt_error(const Error error) {
+	m_last_error = error;
+	m_state = State::MAC_CLOSED;
+	// turn off radio (safely)
+	while (m_radio.get_state() != Radio::State::DISABLED) {
+		switch (m_radio.get_state()) {
+		case Radio::State::IDLE:
+			m_radio.sleep();
+		case Radio::State::SLEEP:
+			m_radio.disable();
+		default: return;
+		}
+	}
+}
+
+extern template class LoomNet::BasicMAC<LoomNet::Radio>;
@@ -8,17 +8,49 @@
 #include "LoomRadio.h"
 #include "LoomNetworkConfig.h"
 #include "LoomNetworkTime.h"
+#include "LoomNetworkState.h"
+#include "LoomNetworkRole.h"
+#include "LoomNetworkPolicy.h"
+#include "LoomPacketPool.h"
 
 /**
  * Loom Network Layer
  * Operates asynchronously
+ *
+ * A build for one role, like EndDeviceNetwork, leaves out the forwarding and refresh code
+ * that device never runs, see LoomNetworkRole.h. How packets are queued, deduplicated, retried
+ * and dropped when there's no room are policies, see LoomNetworkPolicy.h.
+ * The default buffers come to about 1.6KB, the LoomNetworkFootprint tool lists what each part takes.
+ * Packets are kept in one pool for both buffers and only their handles are queued, so a packet is
+ * copied in from the MAC or the application once, and read in place after that, see LoomPacketPool.h.
+ * An application can also subscribe a handler, which reads a recieved payload straight out of the MAC.
  */
 
 namespace LoomNet {
-	template<class RadioImpl, size_t send_buffer = 16U, size_t recv_buffer = 16U, size_t fingerprint_buffer = 32U>
+	// how many handlers a Network can have at once
+	constexpr uint8_t SUBSCRIBE_MAX = 4;
+	// a subscription for every port, since a port is only a byte
+	constexpr uint16_t PORT_ANY = 0x100;
+
+	// a packet for us, as a handler sees it, valid only until the handler returns
+	struct PayloadView {
+		const uint8_t* payload;
+		uint8_t length;
+		uint16_t orig_src;
+		uint8_t seq;
+	};
+
+	// context is whatever was given to subscribe, so the handler can find its way back to the application
+	using RecvHandler = void (*)(const PayloadView& view, void* context);
+
+	template<class RadioImpl, size_t send_buffer = 18U, size_t recv_buffer = 18U, size_t fingerprint_buffer = 32U, class Role = AnyRole,
+		template<class, size_t> class SendQueue = FifoSendQueue,
+		template<size_t> class Dedup = FingerprintDedup,
+		class Retry = AlwaysRetry,
+		class Overflow = HaltOnOverflow>
 	class Network {
 
-		// static_assert(std::is_base_of<Radio, RadioImpl>::value, "Radio implementation must conform to radio interface!");
+		// static_assert(std::is_base_of<RadioBase, RadioImpl>::value, "Radio implementation must conform to radio interface!");
 
 	public:
 		enum Status : uint8_t {
@@ -28,30 +60,49 @@ namespace LoomNet {
 			NET_SEND_RDY = (1 << 5)
 		};
 
-		enum class Error {
+		enum class Error : uint8_t {
 			NET_OK,
 			RECV_BUF_FULL,
 			SEND_BUF_FULL,
 			MAC_FAIL,
 			INVAL_MAC_STATE,
 			ROUTE_FAIL,
+			// the configuration is for a device this build leaves out
+			ROLE_MISMATCH,
 		};
 
+		// room for both buffers, and one more for a packet on its way from the MAC to either
+		// nothing else holds a slot, so a slot is always free unless that changes, which is still checked for
+		using Pool = PacketPool<send_buffer + recv_buffer + 1>;
+		using Handle = typename Pool::Handle;
+
+		// all bytes, so the handle isn't padded out for the address next to it
 		struct PacketWithDst {
-			PacketWithDst(const uint16_t start_dst, const Packet& start_packet)
-				: dst(start_dst)
-				, packet(start_packet) {}
+			PacketWithDst(const uint16_t start_dst, const Handle start_handle, const uint8_t start_failures = 0)
+				: handle(start_handle)
+				, failures(start_failures)
+				, m_dst{ static_cast<uint8_t>(start_dst & 0xff), static_cast<uint8_t>(start_dst >> 8) } {}
 
 			PacketWithDst(const PacketWithDst& rhs)
-				: dst(rhs.dst)
-				, packet(rhs.packet) {}
+				: handle(rhs.handle)
+				, failures(rhs.failures)
+				, m_dst{ rhs.m_dst[0], rhs.m_dst[1] } {}
 
-			uint16_t dst;
-			Packet packet;
+			uint16_t get_dst() const { return static_cast<uint16_t>(m_dst[0]) | static_cast<uint16_t>(m_dst[1]) << 8; }
+
+			// where the packet is in the pool, see get_packet
+			Handle handle;
+			// how many times the MAC has failed to send it, for the retry policy
+			uint8_t failures;
+
+		private:
+			uint8_t m_dst[2];
 		};
 
 		Network(const NetworkInfo& config, const RadioImpl& radio);
 		Network(const Network& rhs);
+		// the same device in the same state, on a different radio
+		Network(const Network& rhs, const RadioImpl& radio);
 
 		bool operator==(const Network& rhs) const {
 			return (rhs.m_mac == m_mac)
@@ -59,80 +110,152 @@ namespace LoomNet {
 				&& (rhs.m_addr == m_addr);
 		}
 
-		TimeInterval net_sleep_next_wake_time() const { return m_mac.sleep_next_wake_time(); }
-		TimeInterval net_sleep_next_wake_time_rel() const { return m_mac.sleep_next_wake_time() - m_radio.get_time(); }
+		TimeTicks net_sleep_next_wake_time() const { return m_mac.sleep_next_wake_time(); }
+		// zero if we are already late
+		TimeTicks net_sleep_next_wake_time_rel() const { return m_mac.sleep_next_wake_time() - m_radio.get_time(); }
 
 		void net_sleep_wake_ack();
 		uint8_t net_update();
 		void app_send(const Packet& send);
 		void app_send(const uint16_t dst_addr, const uint8_t seq, const uint8_t* raw_payload, const uint8_t length);
+		// a copy of the newest packet recieved, which is then freed
 		Packet app_recv();
+		// the newest packet recieved, read where it is until app_recv_done frees it
+		const Packet& app_recv_peek() const { return m_pool[m_buffer_recv.front()]; }
+		void app_recv_done();
+		/**
+		 * Have net_update call handler with each packet for us from src, and whose payload starts with port,
+		 * instead of putting it in the recieve buffer. ADDR_NONE and PORT_ANY match everything. The payload is
+		 * read where the MAC has it, so it's never copied, and the view is only good until the handler returns.
+		 * Every handler that matches gets the packet, and only packets nobody subscribed to end up in the
+		 * recieve buffer. A handler can send, but mustn't subscribe, unsubscribe or call net_update.
+		 * Returns false if there are already SUBSCRIBE_MAX handlers.
+		 */
+		bool subscribe(RecvHandler handler, void* context = nullptr, const uint16_t src = ADDR_NONE, const uint16_t port = PORT_ANY);
+		void unsubscribe(RecvHandler handler, void* context = nullptr);
 		void reset();
+		// keep the timing through a hard power down, see LoomNetworkState.h
+		bool save_state(StateStore& store) const;
+		bool restore_state(StateStore& store);
+		/**
+		 * Visit everything that changes while the device runs, for saving a whole simulation and picking it back up later.
+		 * The archive is called with a reference to each plain value (integers, enums, TimeTicks, packets, raw buffers), and
+		 * either writes it out or reads it back in, so the same walk does both. The configuration isn't included, so the
+		 * device has to be built from the same one first, and the radio needs a snapshot of its own.
+		 */
+		template<class Archive>
+		void snapshot(Archive& archive);
 
 		Error get_last_error() const { return m_last_error; }
 		uint8_t get_status() const { return m_status; }
 		const Router& get_router() const { return m_router; }
-		const MAC& get_mac() const { return m_mac; }
+		const BasicMAC<RadioImpl, Role>& get_mac() const { return m_mac; }
 		const RadioImpl& get_radio() const { return m_radio; }
+		const SendQueue<PacketWithDst, send_buffer>& get_send_queue() const { return m_buffer_send; }
+		const Packet& get_packet(const PacketWithDst& entry) const { return m_pool[entry.handle]; }
+		const Pool& get_pool() const { return m_pool; }
 
 	private:
+		// copies the packet into the pool first
 		void m_send_add(const uint16_t dst, const Packet& packet);
+		// queues a packet already in the pool, which is freed if there's no room
+		void m_send_add(const uint16_t dst, const Handle handle, const uint8_t failures = 0);
+		void m_drop_oldest_send();
+		// moves the MAC's staged packet into a free slot, or drops it and gives NONE if there isn't one
+		Handle m_take_staged();
+		// hand a packet for us to every handler that wants it, true if any did
+		bool m_dispatch(const DataPacket& packet);
 		uint8_t m_halt_error(Error error);
 		void m_update_state(const MAC::State mac_status);
 
 		RadioImpl m_radio;
-		MAC m_mac;
+		BasicMAC<RadioImpl, Role> m_mac;
 		Router m_router;
 
 		uint8_t m_rolling_id;
 
 		const uint16_t m_addr;
+		Pool m_pool;
 		// TODO: Implement in terms of a binary tree
-		CircularBuffer<PacketWithDst, send_buffer> m_buffer_send;
-		CircularBuffer<Packet, recv_buffer> m_buffer_recv;
-		CircularBuffer<PacketFingerprint, fingerprint_buffer> m_buffer_fingerprint;
+		SendQueue<PacketWithDst, send_buffer> m_buffer_send;
+		CircularBuffer<Handle, recv_buffer> m_buffer_recv;
+		Dedup<fingerprint_buffer> m_dedup;
+		// failures of the packet the MAC is sending, in case it fails again
+		uint8_t m_send_failures;
 
 		Error m_last_error;
 		uint8_t m_status;
+
+		struct Subscription {
+			RecvHandler handler;
+			void* context;
+			uint16_t src;
+			uint16_t port;
+		};
+
+		// set up by the application, so they're kept through a reset and left out of a snapshot
+		Subscription m_subscriptions[SUBSCRIBE_MAX];
+		uint8_t m_subscribed;
 	};
+
+	// builds with only what one kind of device needs
+	template<class RadioImpl, size_t send_buffer = 18U, size_t recv_buffer = 18U, size_t fingerprint_buffer = 32U>
+	using EndDeviceNetwork = Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, EndDeviceRole>;
+	template<class RadioImpl, size_t send_buffer = 18U, size_t recv_buffer = 18U, size_t fingerprint_buffer = 32U>
+	using RouterNetwork = Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, RouterRole>;
+	template<class RadioImpl, size_t send_buffer = 18U, size_t recv_buffer = 18U, size_t fingerprint_buffer = 32U>
+	using CoordinatorNetwork = Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, CoordinatorRole>;
 };
 
-template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer>
-LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer>::Network(const NetworkInfo& config, const RadioImpl& radio)
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::Network(const NetworkInfo& config, const RadioImpl& radio)
 	: m_radio(radio)
 	, m_mac(config.route_info.get_self_addr(),
 		config.route_info.get_device_type(),
 		config.slot_info,
 		config.drift_info,
+		config.batch_info,
 		m_radio)
 	, m_router(config.route_info)
 	, m_rolling_id(0)
 	, m_addr(config.route_info.get_self_addr())
+	, m_pool()
 	, m_buffer_send()
 	, m_buffer_recv()
-	, m_buffer_fingerprint()
+	, m_dedup()
+	, m_send_failures(0)
 	, m_last_error(Error::NET_OK)
-	, m_status(Status::NET_SEND_RDY) {}
-
-template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer>
-LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer>::Network(const Network& rhs)
-	: m_radio(rhs.m_radio)
-	, m_mac(rhs.m_router.get_self_addr(),
-		rhs.m_router.get_device_type(),
-		rhs.m_mac.get_slotter(),
-		rhs.m_mac.get_drift(),
-		m_radio)
+	, m_status(Status::NET_SEND_RDY)
+	, m_subscriptions{}
+	, m_subscribed(0) {
+	if (!Role::allows(config.route_info.get_device_type())) m_halt_error(Error::ROLE_MISMATCH);
+}
+
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::Network(const Network& rhs)
+	: Network(rhs, rhs.m_radio) {}
+
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::Network(const Network& rhs, const RadioImpl& radio)
+	: m_radio(radio)
+	, m_mac(rhs.m_mac, m_radio)
 	, m_router(rhs.m_router)
 	, m_rolling_id(rhs.m_rolling_id)
 	, m_addr(rhs.m_addr)
+	, m_pool(rhs.m_pool)
 	, m_buffer_send(rhs.m_buffer_send)
 	, m_buffer_recv(rhs.m_buffer_recv)
-	, m_buffer_fingerprint(rhs.m_buffer_fingerprint)
+	, m_dedup(rhs.m_dedup)
+	, m_send_failures(rhs.m_send_failures)
 	, m_last_error(rhs.m_last_error)
-	, m_status(rhs.m_status) {}
+	, m_status(rhs.m_status)
+	, m_subscriptions{}
+	, m_subscribed(rhs.m_subscribed) {
+	for (uint8_t i = 0; i < m_subscribed; i++) m_subscriptions[i] = rhs.m_subscriptions[i];
+}
 
-template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer>
-void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer>::net_sleep_wake_ack() {
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::net_sleep_wake_ack() {
 	// if there's an error in the machine, we have to wait for it to be cleared
 	if (m_last_error != Error::NET_OK) return;
 	// wake the MAC layer up, and get its state
@@ -142,8 +265,8 @@ void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer>::
 	m_update_state(mac_status);
 }
 
-template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer>
-uint8_t LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer>::net_update() {
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+uint8_t LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::net_update() {
 	// if there's an error in the machine, we have to wait for it to be cleared
 	if (m_last_error != Error::NET_OK) return m_status;
 	const MAC::State mac_status = m_mac.get_status();
@@ -158,20 +281,17 @@ uint8_t LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer
 	else if (mac_status == MAC::State::MAC_REFRESH_WAIT) m_mac.check_for_refresh();
 	// else we have to do something to update the layer
 	else if (mac_status == MAC::State::MAC_DATA_SEND_RDY) {
-		if (m_buffer_send.size() > 0) {
-			// send the first packet corresponding to the address indicated by the MAC layer
-			uint16_t addr = m_mac.get_cur_send_address();
-			auto iter = m_buffer_send.crange().begin();
-			const auto end = m_buffer_send.crange().end();
-			for (; iter != end; ++iter) {
-				if ((*iter).dst == addr) break;
-			}
+		if (!m_buffer_send.empty()) {
+			// send the packet the queue picks for the address indicated by the MAC layer
+			const size_t index = m_buffer_send.find(m_mac.get_cur_send_address());
 			// if there isn't any, send none and move on
-			if (!(iter != end)) m_mac.send_pass();
+			if (index == m_buffer_send.size()) m_mac.send_pass();
 			else {
 				// send, and if send succeded, destroy the item
-				if (m_mac.send_fragment((*iter).packet)) {
-					m_buffer_send.remove(iter);
+				if (m_mac.send_fragment(m_pool[m_buffer_send[index].handle])) {
+					m_send_failures = m_buffer_send[index].failures;
+					m_pool.release(m_buffer_send[index].handle);
+					m_buffer_send.remove(index);
 					// hey there's a new spot!
 					m_status |= Status::NET_SEND_RDY;
 				}
@@ -184,47 +304,61 @@ uint8_t LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer
 	}
 	// if the MAC layer failed to send, add the packet back to the buffer for later
 	else if (mac_status == MAC::State::MAC_DATA_SEND_FAIL) {
-		// we always keep an open spot for a failed packet to pop back into
+		// if the retry policy wants it back, we always keep an open spot for it to pop back into
 		// if the packet doesn't insert for some reason, the network has broken
-		m_send_add(m_mac.get_cur_send_address(), m_mac.get_staged_packet());
+		const uint8_t failures = m_send_failures < UINT8_MAX ? m_send_failures + 1 : UINT8_MAX;
+		if (Retry::retry(failures)) {
+			const Handle failed = m_take_staged();
+			if (failed != Pool::NONE) m_send_add(m_mac.get_cur_send_address(), failed, failures);
+			else if (Overflow::action == OverflowAction::HALT) return m_halt_error(Error::SEND_BUF_FULL);
+		}
+		else m_mac.drop_staged_packet();
 	}
 	// if the mac has data ready to be copied, do that
 	else if (mac_status == MAC::State::MAC_DATA_RECV_RDY) {
-		// create a lookahead copy of the fragment
-		Packet recv_frag = m_mac.get_staged_packet();
-		DataPacket& data_frag = recv_frag.as<DataPacket>();
-		// if the fingerprint of this packet is contained in our buffer, drop it as
-		// it's a repeat
-		bool found = false;
-		for (const auto& elem : m_buffer_fingerprint.crange()) {
-			if (elem.src_addr == data_frag.get_orig_src()
-				&& elem.rolling_id == data_frag.get_rolling_id()) {
-				found = true;
-				break;
+		// look at the fragment where the MAC has it, and only copy it into the pool to keep it
+		const DataPacket& data_frag = m_mac.peek_staged_packet().template as<DataPacket>();
+		// if this packet is a repeat, we're done with it
+		if (m_dedup.seen(data_frag)) m_mac.drop_staged_packet();
+		// if we have a fragment that is addressed to us, hand it to whoever subscribed to it
+		else if (data_frag.get_dst() == m_addr) {
+			if (m_dispatch(data_frag)) m_mac.drop_staged_packet();
+			// else add it to the recv buffer, where the newest is at the front, so the oldest is at the back
+			else {
+				if (Overflow::action == OverflowAction::DROP_OLDEST && m_buffer_recv.full()) {
+					m_pool.release(m_buffer_recv.back());
+					m_buffer_recv.destroy_back();
+				}
+				if (m_buffer_recv.full()) {
+					m_mac.drop_staged_packet();
+					if (Overflow::action == OverflowAction::HALT) return m_halt_error(Error::RECV_BUF_FULL);
+				}
+				// the fragment goes straight into the pool, and stays in that slot until it's read
+				else {
+					const Handle recv_frag = m_take_staged();
+					if (recv_frag != Pool::NONE) {
+						m_buffer_recv.add_front(recv_frag);
+						// flip the recv ready bit
+						m_status |= Status::NET_RECV_RDY;
+					}
+					else if (Overflow::action == OverflowAction::HALT) return m_halt_error(Error::RECV_BUF_FULL);
+				}
 			}
 		}
-		// if this packet isn't a repeat
-		if (!found) {
-			// add the framecheck to our fingerprinting buffer
-			if (m_buffer_fingerprint.full()) m_buffer_fingerprint.destroy_front();
-			m_buffer_fingerprint.emplace_back(data_frag);
-			// if we have a fragment that is addressed to us, add it to the recv buffer
-			if (data_frag.get_dst() == m_addr) {
-				if (!m_buffer_recv.emplace_front(data_frag))
-					return m_halt_error(Error::RECV_BUF_FULL);
-				// flip the recv ready bit
-				m_status |= Status::NET_RECV_RDY;
-
-			}
-			// else the packet needs to be routed
-			else {
-				const uint16_t nexthop = m_router.route(data_frag.get_dst());
-				if (nexthop == ADDR_ERROR || nexthop == ADDR_NONE)
-					return m_halt_error(Error::ROUTE_FAIL);
-				// push the packet to the send buffer, tagging it with the next hop address
-				m_send_add(nexthop, recv_frag);
+		// else the packet needs to be routed
+		else if (Role::forwards) {
+			const uint16_t nexthop = m_router.route(data_frag.get_dst());
+			if (nexthop == ADDR_ERROR || nexthop == ADDR_NONE) {
+				m_mac.drop_staged_packet();
+				return m_halt_error(Error::ROUTE_FAIL);
 			}
+			// push the packet to the send buffer, tagging it with the next hop address
+			const Handle recv_frag = m_take_staged();
+			if (recv_frag != Pool::NONE) m_send_add(nexthop, recv_frag);
+			else if (Overflow::action == OverflowAction::HALT) return m_halt_error(Error::SEND_BUF_FULL);
 		}
+		// an end device has no children, so it was never meant to hear this one
+		else m_mac.drop_staged_packet();
 	}
 	// throw an error if the MAC state is out of bounds
 	else if (mac_status != MAC::State::MAC_SLEEP_RDY)
@@ -234,8 +368,8 @@ uint8_t LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer
 	return m_status;
 }
 
-template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer>
-void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer>::app_send(const Packet& send) {
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::app_send(const Packet& send) {
 	// push the send fragment into the buffer
 	m_send_add(m_router.route(send.as<DataPacket>().get_dst()), send);
 	// move to the next rolling ID
@@ -243,8 +377,8 @@ void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer>::
 	else m_rolling_id++;
 }
 
-template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer>
-void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer>::app_send(const uint16_t dst_addr, const uint8_t seq, const uint8_t* raw_payload, const uint8_t length) {
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::app_send(const uint16_t dst_addr, const uint8_t seq, const uint8_t* raw_payload, const uint8_t length) {
 	// push the send fragment into the buffer
 	m_send_add(
 		m_router.route(dst_addr),
@@ -263,41 +397,149 @@ void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer>::
 	else m_rolling_id++;
 }
 
-template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer>
-LoomNet::Packet LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer>::app_recv() {
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+LoomNet::Packet LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::app_recv() {
 	// create a copy of the last recieved object
-	const Packet frag(m_buffer_recv.front());
+	const Packet frag(app_recv_peek());
 	// destroy the stored object
+	app_recv_done();
+	// return the copy
+	return frag;
+}
+
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::app_recv_done() {
+	m_pool.release(m_buffer_recv.front());
 	m_buffer_recv.destroy_front();
 	// if the buffer is emptey, tell the user that there's no more data
 	if (m_buffer_recv.empty()) m_status &= ~Status::NET_RECV_RDY;
-	// return the copy
-	return frag;
 }
 
-template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer>
-void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer>::reset() {
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+bool LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::subscribe(RecvHandler handler, void* context, const uint16_t src, const uint16_t port) {
+	if (m_subscribed == SUBSCRIBE_MAX) return false;
+	m_subscriptions[m_subscribed++] = { handler, context, src, port };
+	return true;
+}
+
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::unsubscribe(RecvHandler handler, void* context) {
+	// keep the rest in the order they subscribed
+	uint8_t kept = 0;
+	for (uint8_t i = 0; i < m_subscribed; i++) {
+		if (m_subscriptions[i].handler != handler || m_subscriptions[i].context != context)
+			m_subscriptions[kept++] = m_subscriptions[i];
+	}
+	m_subscribed = kept;
+}
+
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::reset() {
 	// reset MAC layer
 	m_mac.reset();
 	// set the rolling ID to zero
 	m_rolling_id = 0;
 	// clear buffers
+	m_pool.reset();
 	m_buffer_recv.reset();
 	m_buffer_send.reset();
-	m_buffer_fingerprint.reset();
+	m_dedup.reset();
+	m_send_failures = 0;
 	// reset state and error
 	m_last_error = Error::NET_OK;
 	m_status = Status::NET_SEND_RDY;
 }
 
-template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer>
-void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer>::m_send_add(const uint16_t dst, const Packet& packet) {
-	if (!m_buffer_send.emplace_back(dst, packet)) m_halt_error(Error::SEND_BUF_FULL);
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+bool LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::save_state(StateStore& store) const {
+	NetworkState state;
+	if (m_last_error != Error::NET_OK || !m_mac.save_state(state)) return false;
+	state.rolling_id = m_rolling_id;
+	return write_network_state(store, state);
+}
+
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+bool LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::restore_state(StateStore& store) {
+	NetworkState state;
+	if (m_last_error != Error::NET_OK
+		|| !read_network_state(store, state)
+		|| !m_mac.restore_state(state)) return false;
+	m_rolling_id = state.rolling_id;
+	// nothing to do until the refresh
+	m_update_state(m_mac.get_status());
+	return true;
+}
+
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+template<class Archive>
+void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::snapshot(Archive& archive) {
+	m_radio.snapshot(archive);
+	m_mac.snapshot(archive);
+	// the router only has configuration in it
+	archive(m_rolling_id);
+	m_pool.snapshot(archive);
+	m_buffer_send.snapshot(archive);
+	m_buffer_recv.snapshot(archive);
+	m_dedup.snapshot(archive);
+	archive(m_send_failures);
+	archive(m_last_error);
+	archive(m_status);
+}
+
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::m_send_add(const uint16_t dst, const Packet& packet) {
+	if (Overflow::action == OverflowAction::DROP_OLDEST && m_buffer_send.full()) m_drop_oldest_send();
+	// don't take a slot there's no room to queue
+	const Handle handle = m_buffer_send.full() ? Pool::NONE : m_pool.alloc(packet);
+	if (handle == Pool::NONE) {
+		if (Overflow::action == OverflowAction::HALT) m_halt_error(Error::SEND_BUF_FULL);
+		return;
+	}
+	m_send_add(dst, handle);
+}
+
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::m_send_add(const uint16_t dst, const Handle handle, const uint8_t failures) {
+	if (Overflow::action == OverflowAction::DROP_OLDEST && m_buffer_send.full()) m_drop_oldest_send();
+	if (!m_buffer_send.push(PacketWithDst(dst, handle, failures))) {
+		m_pool.release(handle);
+		if (Overflow::action == OverflowAction::HALT) m_halt_error(Error::SEND_BUF_FULL);
+	}
 	else if (m_buffer_send.size() < m_router.get_node_count()) m_status &= ~Status::NET_SEND_RDY;
 }
 
-template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer>
-uint8_t LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer>::m_halt_error(Error error) {
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+typename LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::Handle LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::m_take_staged() {
+	// the MAC moves on whether or not there was a slot for it
+	const Handle handle = m_pool.alloc(m_mac.peek_staged_packet());
+	m_mac.drop_staged_packet();
+	return handle;
+}
+
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::m_drop_oldest_send() {
+	// every queue keeps the oldest at the front
+	m_pool.release(m_buffer_send[0].handle);
+	m_buffer_send.drop_oldest();
+}
+
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+bool LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::m_dispatch(const DataPacket& packet) {
+	const PayloadView view = { packet.get_payload(), packet.get_payload_length(), packet.get_orig_src(), packet.get_seq() };
+	bool handled = false;
+	for (uint8_t i = 0; i < m_subscribed; i++) {
+		const Subscription& sub = m_subscriptions[i];
+		if ((sub.src == ADDR_NONE || sub.src == view.orig_src)
+			&& (sub.port == PORT_ANY || (view.length > 0 && sub.port == view.payload[0]))) {
+			sub.handler(view, sub.context);
+			handled = true;
+		}
+	}
+	return handled;
+}
+
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+uint8_t LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::m_halt_error(Error error) {
 	// Serial.print("Error: ");
 	// Serial.println(static_cast<uint8_t>(error));
 	m_last_error = error;
@@ -305,8 +547,8 @@ uint8_t LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer
 	return m_status = Status::NET_CLOSED;
 }
 
-template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer>
-void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer>::m_update_state(const MAC::State mac_status) {
+template<class RadioImpl, size_t send_buffer, size_t recv_buffer, size_t fingerprint_buffer, class Role, template<class, size_t> class SendQueue, template<size_t> class Dedup, class Retry, class Overflow>
+void LoomNet::Network<RadioImpl, send_buffer, recv_buffer, fingerprint_buffer, Role, SendQueue, Dedup, Retry, Overflow>::m_update_state(const MAC::State mac_status) {
 	// update the state and set the sleep and wake bit
 	if (mac_status == MAC::State::MAC_SLEEP_RDY)
 		m_status |= Status::NET_SLEEP_RDY;
@@ -0,0 +1,99 @@
+#include "LoomNetworkBlob.h"
+#include "FastCRC.h"
+
+using namespace LoomNet;
+
+static uint16_t m_read_u16(const uint8_t* buf) {
+	return static_cast<uint16_t>(buf[0]) | static_cast<uint16_t>(buf[1]) << 8;
+}
+
+static TimeInterval m_read_time(const uint8_t* buf) {
+	const uint32_t time = static_cast<uint32_t>(buf[1])
+		| static_cast<uint32_t>(buf[2]) << 8
+		| static_cast<uint32_t>(buf[3]) << 16
+		| static_cast<uint32_t>(buf[4]) << 24;
+	return { buf[0], time };
+}
+
+static bool m_check_crc(BlobReader& blob, const uint32_t length) {
+	// stream the blob through a small buffer, so it never has to fit in RAM
+	uint8_t buf[BlobReader::Header::HEADER_SIZE];
+	FastCRC16 crc;
+	uint16_t result = crc.xmodem(buf, 0);
+	for (uint32_t offset = 0; offset < length; offset += sizeof(buf)) {
+		const uint8_t chunk = length - offset < sizeof(buf) ? static_cast<uint8_t>(length - offset) : sizeof(buf);
+		if (!blob.read(offset, buf, chunk)) return false;
+		result = crc.xmodem_upd(buf, chunk);
+	}
+	if (!blob.read(length, buf, 2)) return false;
+	return result == m_read_u16(buf);
+}
+
+bool LoomNet::MemoryBlobReader::read(const uint32_t offset, uint8_t* dst, const uint8_t length) {
+	if (offset > m_size || m_size - offset < length) return false;
+	for (uint8_t i = 0; i < length; i++) dst[i] = m_blob[offset + i];
+	return true;
+}
+
+NetworkInfo LoomNet::read_network_blob(BlobReader& blob, const uint16_t self_addr) {
+	uint8_t header[BlobReader::Header::HEADER_SIZE];
+	if (!blob.read(0, header, sizeof(header))
+		|| header[BlobReader::Header::MAGIC] != BLOB_MAGIC[0]
+		|| header[BlobReader::Header::MAGIC + 1] != BLOB_MAGIC[1]
+		|| header[BlobReader::Header::VERSION] != BLOB_VERSION
+		|| header[BlobReader::Header::RECORD_SIZE] < BlobReader::Record::RECORD_MIN_SIZE) return NETWORK_ERROR;
+	const uint8_t record_size = header[BlobReader::Header::RECORD_SIZE];
+	const uint16_t device_count = m_read_u16(&header[BlobReader::Header::DEVICE_COUNT]);
+	if (!m_check_crc(blob, BlobReader::Header::HEADER_SIZE + static_cast<uint32_t>(device_count) * record_size)) return NETWORK_ERROR;
+	// the records are sorted by address, so binary search for ours
+	uint8_t record[BlobReader::Record::RECORD_MIN_SIZE];
+	uint16_t low = 0;
+	uint16_t high = device_count;
+	bool found = false;
+	while (low < high) {
+		const uint16_t mid = low + (high - low) / 2;
+		if (!blob.read(BlobReader::Header::HEADER_SIZE + static_cast<uint32_t>(mid) * record_size, record, sizeof(record))) return NETWORK_ERROR;
+		const uint16_t addr = m_read_u16(&record[BlobReader::Record::ADDRESS]);
+		if (addr == self_addr) {
+			found = true;
+			break;
+		}
+		if (addr < self_addr) low = mid + 1;
+		else high = mid;
+	}
+	if (!found) return NETWORK_ERROR;
+	// the device type and parent come from the address
+	const DeviceType type = get_type(self_addr);
+	const uint16_t parent = type == DeviceType::COORDINATOR ? ADDR_NONE : get_parent(self_addr, type);
+	if (type == DeviceType::ERROR || parent == ADDR_ERROR) return NETWORK_ERROR;
+	const uint8_t* adaptive = &header[BlobReader::Header::ADAPTIVE];
+	// only the coordinator tunes, everyone else follows the refresh packets
+	const BatchTuner tuner = adaptive[6] && type == DeviceType::COORDINATOR
+		? BatchTuner(adaptive[0], adaptive[1], adaptive[2], adaptive[3], adaptive[4], adaptive[5], adaptive[6])
+		: BATCH_FIXED;
+	return {
+		{
+			type,
+			self_addr,
+			parent,
+			record[BlobReader::Record::ROUTER_COUNT],
+			record[BlobReader::Record::NODE_COUNT],
+		},
+		{
+			record[BlobReader::Record::SEND_SLOT],
+			header[BlobReader::Header::TOTAL_SLOTS],
+			header[BlobReader::Header::CYCLES],
+			header[BlobReader::Header::CYCLE_GAP],
+			header[BlobReader::Header::BATCH_GAP],
+			record[BlobReader::Record::SEND_COUNT],
+			record[BlobReader::Record::RECV_SLOT],
+			record[BlobReader::Record::RECV_COUNT]
+		},
+		{
+			m_read_time(&header[BlobReader::Header::MIN_DRIFT]),
+			m_read_time(&header[BlobReader::Header::MAX_DRIFT]),
+			m_read_time(&header[BlobReader::Header::SLOT_LENGTH])
+		},
+		tuner
+	};
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+#include <stdint.h>
+#include "LoomNetworkInfo.h"
+#include "LoomNetworkUtility.h"
+#include "LoomNetworkTime.h"
+
+/**
+ * Precompiled network configuration, so devices can boot without the JSON library
+ * The blob is made on a computer with NetworkTopology::write_blob, and is read in place
+ * from flash or an SD card. All values are little endian:
+ *	header: see BlobReader::Header
+ *	records: one for every device, sorted by address, see BlobReader::Record
+ *	CRC-16/XMODEM of everything before it
+ */
+
+namespace LoomNet {
+	constexpr uint8_t BLOB_VERSION = 1;
+
+	constexpr uint8_t BLOB_MAGIC[2] = { 'L', 'N' };
+
+	/** Where a blob is read from, implement this for an SD card file or external flash */
+	class BlobReader {
+	public:
+		enum Header : uint8_t {
+			MAGIC = 0,
+			VERSION = 2,
+			RECORD_SIZE = 3,
+			DEVICE_COUNT = 4,
+			TOTAL_SLOTS = 6,
+			CYCLES = 7,
+			CYCLE_GAP = 8,
+			BATCH_GAP = 9,
+			// times are a unit byte and four bytes of time
+			MIN_DRIFT = 10,
+			MAX_DRIFT = 15,
+			SLOT_LENGTH = 20,
+			// min and max cycles, cycle gap and batch gap, then hold, which is zero if the batch is fixed
+			ADAPTIVE = 25,
+			HEADER_SIZE = 32
+		};
+
+		enum Record : uint8_t {
+			ADDRESS = 0,
+			ROUTER_COUNT = 2,
+			NODE_COUNT = 3,
+			SEND_SLOT = 4,
+			SEND_COUNT = 5,
+			RECV_SLOT = 6,
+			RECV_COUNT = 7,
+			// newer versions may add fields to the end of a record
+			RECORD_MIN_SIZE = 8
+		};
+
+		// copy length bytes starting at offset into dst, false if there aren't enough
+		virtual bool read(const uint32_t offset, uint8_t* dst, const uint8_t length) = 0;
+
+		// size of a blob with the current record format
+		static constexpr uint32_t get_size(const uint16_t device_count) {
+			return Header::HEADER_SIZE + static_cast<uint32_t>(device_count) * Record::RECORD_MIN_SIZE + 2;
+		}
+	};
+
+	/** A blob already in memory, such as a const array in flash */
+	class MemoryBlobReader : public BlobReader {
+	public:
+		MemoryBlobReader(const uint8_t* blob, const uint32_t size)
+			: m_blob(blob)
+			, m_size(size) {}
+
+		bool read(const uint32_t offset, uint8_t* dst, const uint8_t length) override;
+
+	private:
+		const uint8_t* m_blob;
+		const uint32_t m_size;
+	};
+
+	// check the blob and find this device's record, NETWORK_ERROR if either fails
+	NetworkInfo read_network_blob(BlobReader& blob, const uint16_t self_addr);
+}
\ No newline at end of file
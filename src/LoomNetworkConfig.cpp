@@ -1,155 +1,23 @@
 #include "LoomNetworkConfig.h"
+#include "LoomAirtime.h"
+#include "FastCRC.h"
+#if !ARDUINOJSON_ENABLE_ARDUINO_PRINT
+#include <ostream>
+#endif
 
 using namespace LoomNet;
 
-static uint16_t m_recurse_traverse(const JsonObjectConst& parent, const char* self_name, JsonObjectConst& self_obj, uint8_t& self_depth, const uint16_t router_count = 0, const uint8_t depth = 0) {
-	uint16_t node_count = 1;
-	uint16_t cur_router_count = 1;
-	const JsonArrayConst children = parent["children"];
-	for (JsonObjectConst device : children) {
-		if (device.isNull()) return LoomNet::ADDR_ERROR;
-		// get the device type
-		const uint8_t type = device["type"] | static_cast<uint8_t>(255);
-		if (type == 255) return LoomNet::ADDR_ERROR;
-
-		uint16_t node_address_part = 0;
-		bool found = false;
-		// compare the device name
-		const char* name = device["name"].as<const char*>();
-		if (!strncmp(name, self_name, LoomNet::STRING_MAX)) {
-			// we found it!
-			self_obj = device;
-			self_depth = depth;
-			// if it's a node, return the node count for processing later
-			if (type == 0) node_address_part = node_count;
-			// else if it's a router, return the router count
-			else if (type == 1)
-				node_address_part = (depth == 0) ? (cur_router_count << 12)
-				: (cur_router_count << 8);
-			// else leave it at zero, and add the routers
-			found = true;
-		}
-		else {
-			// if it's a node, incrememnt node counter
-			if (type == 0) node_count++;
-			// else recurse through the router children array
-			else {
-				// check all the children for our name
-				node_address_part = m_recurse_traverse(device, self_name, self_obj, self_depth, cur_router_count, depth + 1);
-				// increment the router counter
-				if (!node_address_part) cur_router_count++;
-				else found = true;
-			}
-		}
-
-		if (found) {
-			// recursed twice, add the second router count
-			if (depth == 2) return node_address_part | (router_count << 8);
-			// else recursed once, add the first router count
-			if (depth == 1) return node_address_part | (router_count << 12);
-			// else we're good to go
-			return node_address_part;
-		}
-	}
-	// guess we didn't find anything
-	return LoomNet::ADDR_NONE;
-}
-
-static uint8_t m_count_slots_self(const JsonObjectConst& parent, uint8_t& total) {
-	const JsonArrayConst children = parent["children"];
-	// if we found an end device, add one to self and total
-	if (children.isNull()) {
-		total++;
-		return 1;
-	}
-	// else traverse the children tree, adding up slots in a depth-first manner
-	uint8_t self_slots = 0;
-	for (JsonObjectConst device : children) {
-		// search the children recursivley
-		self_slots += m_count_slots_self(device, total);
-	}
-	// add a slot for sensing capabilities
-	if (parent["sensor"].as<bool>()) self_slots++;
-	// add to total and return!
-	total += self_slots;
-	return self_slots;
-}
-
-static uint8_t m_count_slots_children(const JsonObjectConst& parent, uint8_t& total) {
-	uint8_t pass = 0;
-	const JsonArrayConst children = parent["children"];
-	for (const JsonObjectConst device : children)
-		pass += m_count_slots_self(device, total);
-	return pass;
-}
-
-static uint8_t m_count_slots_layer(const JsonObjectConst& obj, const uint8_t layer, const char* self_name, const LoomNet::DeviceType self_type, bool& found_device) {
-	// create a breadth-first array of the nodes so we can traverse them in reverse order
-	const JsonArrayConst children = obj["children"];
-	uint8_t total = 0;
-	// if we're not on the right layer, recurse
-	if (layer != 0) {
-		for (const auto device : children) {
-			const uint8_t type = device["type"] | 255;
-			if (type == 255) return LoomNet::SLOT_ERROR;
-			if (type == 1) {
-				const auto out = m_count_slots_layer(device, layer - 1, self_name, self_type, found_device);
-				if (out == LoomNet::SLOT_ERROR)
-					return LoomNet::SLOT_ERROR;
-				total += out;
-			}
-		}
-	}
-	// else count the childrens slots on this layer, stopping when we find the device we're looking for
-	else {
-		// if we're on the right layer, count all the slots of the objects to the left of this one
-		// count only routers first
-		for (const auto device : children) {
-			const uint8_t type = device["type"] | static_cast<uint8_t>(255);
-			if (type == 255) return LoomNet::SLOT_ERROR;
-			if (type == 1) {
-				if (!found_device) {
-					if ((self_type == LoomNet::DeviceType::FIRST_ROUTER
-						|| self_type == LoomNet::DeviceType::SECOND_ROUTER)
-						&& !strncmp(device["name"].as<const char*>(), self_name, LoomNet::STRING_MAX)) {
-						// we found our device!
-						found_device = true;
-					}
-					// add a slot for sensing capabilities, but don't count ourself
-					if (!found_device && device["sensor"].as<bool>()) total++;
-				}
-				// count the childrens slots, then add a slot to transmit for each of them
-				uint8_t child_slot_total = 0;
-				const auto pass_slots = m_count_slots_children(device, child_slot_total);
-				total += child_slot_total;
-				if (!found_device) total += pass_slots;
-			}
-		}
-		// next count end devices, but only if we haven't found our device
-		if (!found_device) {
-			for (const auto device : children) {
-				const uint8_t type = device["type"] | static_cast<uint8_t>(255);
-				if (type == 255) return LoomNet::SLOT_ERROR;
-				if (type == 0) {
-					if (self_type == LoomNet::DeviceType::END_DEVICE
-						&& !strncmp(device["name"].as<const char*>(), self_name, LoomNet::STRING_MAX)) {
-						// we found our device! we can stop counting
-						found_device = true;
-						break;
-					}
-					// continue counting
-					total++;
-				}
-			}
-		}
-	}
-	// all done!
-	return total;
-}
-
-static uint8_t m_count_slots_layer_call(const JsonObjectConst& obj, const uint8_t layer, const char* self_name, const LoomNet::DeviceType self_type) {
-	bool found_device = false;
-	return m_count_slots_layer(obj, layer, self_name, self_type, found_device);
+static LoomNet::SlotOrder m_json_to_order(const JsonVariantConst& obj) {
+	// the standard's layered order is the default
+	if (obj.isNull()) return LoomNet::SlotOrder::LAYERED;
+	const char* order_str = obj.as<const char*>();
+	if (!order_str) return LoomNet::SlotOrder::ERROR;
+	constexpr auto ORDER_MAX_LEN = 15;
+	using Order = LoomNet::SlotOrder;
+	if (strncmp("LAYERED", order_str, ORDER_MAX_LEN) == 0) return Order::LAYERED;
+	if (strncmp("LATENCY", order_str, ORDER_MAX_LEN) == 0) return Order::LATENCY;
+	if (strncmp("WAKEUPS", order_str, ORDER_MAX_LEN) == 0) return Order::WAKEUPS;
+	return Order::ERROR;
 }
 
 static LoomNet::TimeInterval m_json_to_time(const JsonObjectConst& obj) {
@@ -172,125 +40,105 @@ static LoomNet::TimeInterval m_json_to_time(const JsonObjectConst& obj) {
 	return { unit, time };
 }
 
-uint16_t LoomNet::get_addr(const JsonObjectConst& topology, const char* name) {
-	JsonObjectConst obj;
-	uint8_t depth = 0;
-	return m_recurse_traverse(topology["root"], name, obj, depth);
+static bool m_json_to_range(const JsonVariantConst& obj, const uint8_t fixed, uint8_t& min, uint8_t& max) {
+	// a missing range keeps the parameter fixed at it's configured value
+	if (obj.isNull()) {
+		min = fixed;
+		max = fixed;
+		return true;
+	}
+	const JsonArrayConst range = obj.as<JsonArrayConst>();
+	if (range.size() != 2) return false;
+	min = range[0] | 0;
+	max = range[1] | 0;
+	return min <= fixed && fixed <= max;
 }
 
-NetworkInfo LoomNet::read_network_topology(const JsonObjectConst& topology, const char* self_name) {
-	// read the "root" structure
-	// device type
-	DeviceType type = DeviceType::ERROR;
-	// address
-	uint16_t address = ADDR_ERROR;
-	// parent
-	uint16_t parent = ADDR_ERROR;
-	// root array of node children
-	const JsonObjectConst root_obj = topology["root"];
-	// track a object with a json refrence to our object
-	JsonObjectConst self_obj;
-	uint8_t depth = 0;
-	// coordinator special case
-	const char* name = root_obj["name"].as<const char*>();
-	if (name != NULL && !strncmp(name, self_name, STRING_MAX)) {
-		type = DeviceType::COORDINATOR;
-		address = ADDR_COORD;
-		parent = ADDR_NONE;
-		self_obj = root_obj;
-	}
-	// else its a router or end device!
-	else {
-		// search the tree for our device name, keeping track of how many routers we've traversed
-		address = m_recurse_traverse(root_obj, self_name, self_obj, depth);
-		type = get_type(address);
-		parent = get_parent(address, type);
-		// error if not found
-		if (type == DeviceType::ERROR || parent == ADDR_ERROR) return NETWORK_ERROR;
-	}
-	// next, we need to find our devices children in the JSON
-	// find the array of children we would like to search
-	JsonArrayConst ray = self_obj["children"];
-	if (type == DeviceType::COORDINATOR) ray = root_obj["children"];
-	// next, measure how many end devices and routers are children are underneath our device
-	uint8_t router_count = 0;
-	uint8_t node_count = 0;
-	// iterate through the children array, counting nodes and routers
-	for (JsonObjectConst obj : ray) {
-		if (obj.isNull()) return NETWORK_ERROR;
-		// get the device type
-		const uint8_t type = obj["type"] | static_cast<uint8_t>(255);
-		// if it's a router, increment routers
-		if (type == 1) router_count++;
-		// else if it's a node, incremement nodes
-		else if (type == 0) node_count++;
-		// else uh oh
-		else return NETWORK_ERROR;
-	}
-	// next, we need to determine the device's layer and slot information
-	// collect the slot for the devices self and first child
-	// get self slot
-	uint8_t self_slot = SLOT_ERROR;
-	if (type != DeviceType::COORDINATOR) self_slot = m_count_slots_layer_call(root_obj, depth, self_obj["name"], type);
-	else if (type != DeviceType::ERROR) self_slot = SLOT_NONE;
-	// if the device is a router, get the first child and it's slot
-	uint8_t child_slot = SLOT_ERROR;
-	uint8_t child_slot_count = 0;
-	if (type != DeviceType::END_DEVICE) {
-		// find the highest priority child
-		JsonObjectConst highest_child;
-		for (const JsonObjectConst child : ray) {
-			const uint8_t type = child["type"] | static_cast<uint8_t>(255);
-			if (type == 1) {
-				highest_child = child;
-				break;
-			}
-			else if (type == 0 && highest_child.isNull()) highest_child = child;
-		}
-		// count it's slots
-		if (!highest_child.isNull()) {
-			const uint8_t type = highest_child["type"] | static_cast<uint8_t>(255);
-			const DeviceType detailed_type = type == 0
-				? DeviceType::END_DEVICE
-				: (depth == 1
-					? DeviceType::FIRST_ROUTER
-					: DeviceType::SECOND_ROUTER);
-			child_slot = m_count_slots_layer_call(root_obj, depth + 1, highest_child["name"], detailed_type);
-			uint8_t slot_total = 0;
-			child_slot_count = m_count_slots_children(self_obj, slot_total);
-		}
+static bool m_json_to_timing(const JsonObjectConst& radio, const LoomNet::TimeInterval& max_drift, LoomNet::TimeInterval& slot_length, LoomNet::TimeInterval& min_drift) {
+	// without a radio description the timings have to be set by hand
+	if (radio.isNull()) return true;
+	const JsonArrayConst modem = radio["modem"];
+	if (modem.size() != 3) return false;
+	const LoomNet::LoraAirtime airtime(modem[0] | 0, modem[1] | 0, modem[2] | 0, radio["preamble"] | 8);
+	if (!airtime.is_valid() || max_drift.is_none()) return false;
+	uint32_t turnaround_us = LoomNet::LoraAirtime::TURNAROUND_US;
+	if (!radio["turnaround"].isNull()) {
+		const LoomNet::TimeInterval turnaround = LoomNet::TimeInterval(LoomNet::TimeInterval::MICROSECOND, 0) + m_json_to_time(radio["turnaround"]);
+		if (turnaround.is_none()) return false;
+		turnaround_us = turnaround.get_time();
 	}
-	else if (type != DeviceType::ERROR) child_slot = SLOT_NONE;
-	// figure our how many slots to send based on than number
-	uint8_t send_slots = SLOT_ERROR;
-	if (type == DeviceType::END_DEVICE) send_slots = 1;
-	else if (type == DeviceType::COORDINATOR) send_slots = 0;
-	else if (self_obj["sensor"] | false) send_slots = child_slot_count + 1;
-	else send_slots = child_slot_count;
-	// finally count total slots in the entire network
-	uint8_t total_slots = 0;
-	m_count_slots_children(root_obj, total_slots);
-	// read the "config" object
-	const JsonObjectConst config = topology["config"];
-	if (config.isNull()) return NETWORK_ERROR;
+	// fill in whatever is missing, and make sure anything set by hand is long enough
+	const LoomNet::TimeInterval safe_min_drift = airtime.get_min_drift(max_drift, turnaround_us);
+	const LoomNet::TimeInterval safe_slot_length = airtime.get_slot_length(max_drift, turnaround_us);
+	if (safe_min_drift.is_none() || safe_slot_length.is_none()) return false;
+	if (min_drift.is_none()) min_drift = safe_min_drift;
+	else if (min_drift < safe_min_drift) return false;
+	if (slot_length.is_none()) slot_length = safe_slot_length;
+	else if (slot_length < safe_slot_length) return false;
+	return true;
+}
+
+static bool m_read_config(const JsonObjectConst& config, LoomNet::NetworkConfig& out) {
+	// the slot assignment order, which defaults to layered even without a config
+	out.order = m_json_to_order(config["slot_order"]);
+	if (config.isNull() || out.order == LoomNet::SlotOrder::ERROR) return false;
 	// read the slot length
-	const TimeInterval slot_length = m_json_to_time(config["slot_length"]);
+	out.slot_length = m_json_to_time(config["slot_length"]);
 	// the cycles per batch
-	const uint8_t cycles_per_batch = config["cycles_per_batch"] | 0;
+	out.cycles_per_batch = config["cycles_per_batch"] | 0;
 	// the slots per gap per every cycle
-	const uint8_t cycle_gap = config["cycle_gap"] | 0;
+	out.cycle_gap = config["cycle_gap"] | 0;
 	// the slots per gap per every batch
-	const uint8_t batch_gap = config["batch_gap"] | 0;
+	out.batch_gap = config["batch_gap"] | 0;
 	// and the clock drift per refresh cycle
-	const TimeInterval max_drift = m_json_to_time(config["max_drift"]);
-	const TimeInterval min_drift = m_json_to_time(config["min_drift"]);
+	out.max_drift = m_json_to_time(config["max_drift"]);
+	out.min_drift = m_json_to_time(config["min_drift"]);
+	// the slot length and recieve timeout can also come from the radio's time on air
+	if (!m_json_to_timing(config["radio"], out.max_drift, out.slot_length, out.min_drift)) return false;
 	// check them all for errors
-	if (slot_length.is_none()
-		|| cycles_per_batch < 2
-		|| !cycle_gap
-		|| min_drift.is_none()
-		|| max_drift.is_none()) return NETWORK_ERROR;
-	// return it all! jesus christ
+	if (out.slot_length.is_none()
+		|| out.cycles_per_batch < 2
+		|| !out.cycle_gap
+		|| out.min_drift.is_none()
+		|| out.max_drift.is_none()) return false;
+	// optionally, the limits the coordinator can move the batch parameters between
+	const JsonObjectConst adaptive = config["adaptive"];
+	if (adaptive.isNull()) return true;
+	out.adaptive = true;
+	out.hold = adaptive["hold"] | 2;
+	return m_json_to_range(adaptive["cycles_per_batch"], out.cycles_per_batch, out.min_cycles, out.max_cycles)
+		&& m_json_to_range(adaptive["cycle_gap"], out.cycle_gap, out.min_cycle_gap, out.max_cycle_gap)
+		&& m_json_to_range(adaptive["batch_gap"], out.batch_gap, out.min_batch_gap, out.max_batch_gap)
+		&& out.min_cycles >= 2
+		&& out.min_cycle_gap
+		&& out.hold;
+}
+
+static bool m_latency_before(const uint16_t lhs_send, const uint16_t lhs_span, const uint16_t rhs_send, const uint16_t rhs_span) {
+	// order router blocks by (span + send) / send, which minimizes the total time packets
+	// spend waiting for a forwarding slot (weighted shortest processing time first)
+	// routers with nothing to forward go last
+	if (!rhs_send) return lhs_send != 0;
+	if (!lhs_send) return false;
+	return static_cast<uint32_t>(lhs_span + lhs_send) * rhs_send < static_cast<uint32_t>(rhs_span + rhs_send) * lhs_send;
+}
+
+static LoomNet::NetworkInfo m_make_info(const LoomNet::NetworkConfig& config,
+	const uint8_t total_slots,
+	const LoomNet::DeviceType type,
+	const uint16_t address,
+	const uint16_t parent,
+	const uint8_t router_count,
+	const uint8_t node_count,
+	const uint8_t self_slot,
+	const uint8_t send_slots,
+	const uint8_t child_slot,
+	const uint8_t child_slot_count) {
+	using namespace LoomNet;
+	// only the coordinator tunes, everyone else follows the refresh packets
+	const BatchTuner tuner = config.adaptive && type == DeviceType::COORDINATOR
+		? BatchTuner(config.min_cycles, config.max_cycles, config.min_cycle_gap, config.max_cycle_gap, config.min_batch_gap, config.max_batch_gap, config.hold)
+		: BATCH_FIXED;
 	return {
 		{
 			type,
@@ -302,17 +150,1082 @@ NetworkInfo LoomNet::read_network_topology(const JsonObjectConst& topology, cons
 		{
 			self_slot,
 			total_slots,
-			cycles_per_batch,
-			cycle_gap,
-			batch_gap,
+			config.cycles_per_batch,
+			config.cycle_gap,
+			config.batch_gap,
 			send_slots,
 			child_slot,
 			child_slot_count
 		},
 		{
-			min_drift,
-			max_drift,
-			slot_length
-		}
+			config.min_drift,
+			config.max_drift,
+			config.slot_length
+		},
+		tuner
+	};
+}
+
+LoomNet::NetworkTopology::NetworkTopology(const JsonObjectConst& topology, DeviceInfo* devices, const uint16_t capacity)
+	: m_devices(devices)
+	, m_capacity(capacity)
+	, m_count(0)
+	, m_has_groups(false)
+	, m_total_slots(SLOT_ERROR)
+	, m_config{ SlotOrder::ERROR, 0, 0, 0, TIME_NONE, TIME_NONE, TIME_NONE, false, 0, 0, 0, 0, 0, 0, 0 }
+	, m_valid(false) {
+	// the coordinator is the root of the tree, and the first device
+	const JsonObjectConst root_obj = topology["root"];
+	const char* name = root_obj["name"].as<const char*>();
+	if (name == NULL || !capacity) return;
+	m_devices[0] = {
+		name,
+		DeviceType::COORDINATOR,
+		ADDR_COORD,
+		DEVICE_NONE,
+		DEVICE_NONE,
+		DEVICE_NONE,
+		0,
+		0,
+		false,
+		0,
+		0,
+		0,
+		SLOT_NONE,
+		0,
+		SLOT_ERROR,
+		0,
+		0
+	};
+	m_count = 1;
+	// the JSON is only walked once, everything after this works on the device table
+	if (!m_read_children(root_obj, 0)) {
+		m_count = 0;
+		return;
+	}
+	// read the settings every device must agree on, including the slot assignment order
+	const bool config_valid = m_read_config(topology["config"], m_config);
+	if (m_config.order == SlotOrder::ERROR) return;
+	// interference groups can only share slots when each subtree's slots are consecutive
+	if (m_config.order == SlotOrder::LAYERED && m_has_groups) return;
+	if (!m_count_slots()) return;
+	// the other orders nest each router's block directly in front of its parent's block,
+	// so they are placed all at once from the end of the cycle
+	if (m_config.order == SlotOrder::LAYERED) m_place_layered();
+	else m_place_nested(0, m_total_slots);
+	m_valid = config_valid;
+}
+
+LoomNet::NetworkTopology::NetworkTopology(const NetworkTopology& rhs, DeviceInfo* devices, const uint16_t capacity)
+	: m_devices(devices)
+	, m_capacity(capacity)
+	, m_count(rhs.m_count <= capacity ? rhs.m_count : 0)
+	, m_has_groups(rhs.m_has_groups)
+	, m_total_slots(rhs.m_total_slots)
+	, m_config(rhs.m_config)
+	, m_valid(rhs.m_valid && rhs.m_count <= capacity) {
+	// the names still point into the original JSON
+	for (uint16_t i = 0; i < m_count; i++) m_devices[i] = rhs.m_devices[i];
+}
+
+const LoomNet::DeviceInfo* LoomNet::NetworkTopology::find(const char* name) const {
+	if (name == NULL) return nullptr;
+	for (uint16_t i = 0; i < m_count; i++)
+		if (!strncmp(m_devices[i].name, name, STRING_MAX)) return &m_devices[i];
+	return nullptr;
+}
+
+const LoomNet::DeviceInfo* LoomNet::NetworkTopology::find(const uint16_t address) const {
+	if (!m_count) return nullptr;
+	if (address == ADDR_COORD) return &m_devices[0];
+	const DeviceType type = get_type(address);
+	if (type == DeviceType::ERROR) return nullptr;
+	// the address is the path to the device, so follow it down the tree
+	const uint8_t path[] = {
+		static_cast<uint8_t>(address >> 12),
+		static_cast<uint8_t>((address >> 8) & 0x0F),
+		static_cast<uint8_t>(address & 0xFF),
+	};
+	uint16_t cur = 0;
+	for (uint8_t i = 0; i < 3; i++) {
+		if (!path[i]) continue;
+		// the last part of the address counts end devices, the rest count routers
+		const DeviceType want = i == 2 ? DeviceType::END_DEVICE : (i == 0 ? DeviceType::FIRST_ROUTER : DeviceType::SECOND_ROUTER);
+		uint8_t count = 0;
+		uint16_t child = m_devices[cur].first_child;
+		for (; child != DEVICE_NONE; child = m_devices[child].next_sibling)
+			if (m_devices[child].type == want && ++count == path[i]) break;
+		if (child == DEVICE_NONE) return nullptr;
+		cur = child;
+	}
+	return &m_devices[cur];
+}
+
+LoomNet::NetworkInfo LoomNet::NetworkTopology::get_info(const DeviceInfo& device) const {
+	if (!m_valid) return NETWORK_ERROR;
+	return m_make_info(m_config,
+		m_total_slots,
+		device.type,
+		device.address,
+		device.parent == DEVICE_NONE ? ADDR_NONE : m_devices[device.parent].address,
+		device.router_count,
+		device.node_count,
+		device.self_slot,
+		device.send_slots,
+		device.child_slot,
+		device.child_slot_count);
+}
+
+uint8_t LoomNet::NetworkTopology::compare(const DeviceInfo& device, const NetworkTopology& before) const {
+	const DeviceInfo* old = before.find(device.name);
+	if (!old) return CHANGE_ADDED;
+	const NetworkInfo lhs = get_info(device);
+	const NetworkInfo rhs = before.get_info(*old);
+	uint8_t change = CHANGE_NONE;
+	if (!(lhs.route_info == rhs.route_info)) change |= CHANGE_ROUTE;
+	if (!(lhs.slot_info == rhs.slot_info)) change |= CHANGE_SLOT;
+	if (!(lhs.drift_info == rhs.drift_info)) change |= CHANGE_DRIFT;
+	if (!(lhs.batch_info == rhs.batch_info)) change |= CHANGE_BATCH;
+	return change;
+}
+
+static void m_write_u16(uint8_t* buf, const uint16_t value) {
+	buf[0] = static_cast<uint8_t>(value & 0xFF);
+	buf[1] = static_cast<uint8_t>(value >> 8);
+}
+
+static void m_write_time(uint8_t* buf, const LoomNet::TimeInterval& time) {
+	buf[0] = time.get_unit();
+	for (uint8_t i = 0; i < 4; i++) buf[i + 1] = static_cast<uint8_t>(time.get_time() >> (i * 8));
+}
+
+uint32_t LoomNet::NetworkTopology::write_blob(uint8_t* blob, const uint32_t capacity) const {
+	using Header = BlobReader::Header;
+	using Record = BlobReader::Record;
+	const uint32_t size = BlobReader::get_size(m_count);
+	// the CRC is calculated in one go
+	if (!m_valid || capacity < size || size > UINT16_MAX) return 0;
+	blob[Header::MAGIC] = BLOB_MAGIC[0];
+	blob[Header::MAGIC + 1] = BLOB_MAGIC[1];
+	blob[Header::VERSION] = BLOB_VERSION;
+	blob[Header::RECORD_SIZE] = Record::RECORD_MIN_SIZE;
+	m_write_u16(&blob[Header::DEVICE_COUNT], m_count);
+	blob[Header::TOTAL_SLOTS] = m_total_slots;
+	blob[Header::CYCLES] = m_config.cycles_per_batch;
+	blob[Header::CYCLE_GAP] = m_config.cycle_gap;
+	blob[Header::BATCH_GAP] = m_config.batch_gap;
+	m_write_time(&blob[Header::MIN_DRIFT], m_config.min_drift);
+	m_write_time(&blob[Header::MAX_DRIFT], m_config.max_drift);
+	m_write_time(&blob[Header::SLOT_LENGTH], m_config.slot_length);
+	const uint8_t adaptive[] = {
+		m_config.min_cycles,
+		m_config.max_cycles,
+		m_config.min_cycle_gap,
+		m_config.max_cycle_gap,
+		m_config.min_batch_gap,
+		m_config.max_batch_gap,
+		m_config.adaptive ? m_config.hold : static_cast<uint8_t>(0)
 	};
+	for (uint8_t i = 0; i < sizeof(adaptive); i++) blob[Header::ADAPTIVE + i] = adaptive[i];
+	for (uint8_t i = Header::ADAPTIVE + sizeof(adaptive); i < Header::HEADER_SIZE; i++) blob[i] = 0;
+	// write the records sorted by address, picking the next smallest address each time
+	uint8_t* record = &blob[Header::HEADER_SIZE];
+	uint16_t last = 0;
+	for (uint16_t r = 0; r < m_count; r++, record += Record::RECORD_MIN_SIZE) {
+		const DeviceInfo* next = nullptr;
+		for (uint16_t i = 0; i < m_count; i++) {
+			const DeviceInfo& device = m_devices[i];
+			if ((r == 0 || device.address > last) && (!next || device.address < next->address)) next = &device;
+		}
+		last = next->address;
+		m_write_u16(&record[Record::ADDRESS], next->address);
+		record[Record::ROUTER_COUNT] = next->router_count;
+		record[Record::NODE_COUNT] = next->node_count;
+		record[Record::SEND_SLOT] = next->self_slot;
+		record[Record::SEND_COUNT] = next->send_slots;
+		record[Record::RECV_SLOT] = next->child_slot;
+		record[Record::RECV_COUNT] = next->child_slot_count;
+	}
+	m_write_u16(record, FastCRC16().xmodem(blob, static_cast<uint16_t>(size - 2)));
+	return size;
+}
+
+bool LoomNet::NetworkTopology::m_read_children(const JsonObjectConst& parent_obj, const uint16_t parent) {
+	const JsonArrayConst children = parent_obj["children"];
+	uint16_t last = DEVICE_NONE;
+	for (const JsonObjectConst obj : children) {
+		if (obj.isNull() || m_count == m_capacity) return false;
+		const uint8_t type = obj["type"] | static_cast<uint8_t>(255);
+		const char* name = obj["name"].as<const char*>();
+		if (name == NULL || type > 1) return false;
+		DeviceInfo& up = m_devices[parent];
+		const uint16_t index = m_count++;
+		DeviceInfo& device = m_devices[index];
+		device = {
+			name,
+			DeviceType::END_DEVICE,
+			ADDR_ERROR,
+			parent,
+			DEVICE_NONE,
+			DEVICE_NONE,
+			static_cast<uint8_t>(up.depth + 1),
+			obj["group"] | static_cast<uint8_t>(0),
+			obj["sensor"] | false,
+			0,
+			0,
+			0,
+			SLOT_ERROR,
+			SLOT_ERROR,
+			SLOT_NONE,
+			0,
+			0
+		};
+		if (device.group) m_has_groups = true;
+		// the address is the count of routers or end devices before this one, under each parent
+		const uint16_t base = parent == 0 ? 0 : up.address;
+		if (type == 1) {
+			if (up.depth >= ROUTER_DEPTH_MAX || up.router_count == ROUTER_MAX) return false;
+			up.router_count++;
+			device.type = up.depth == 0 ? DeviceType::FIRST_ROUTER : DeviceType::SECOND_ROUTER;
+			device.address = base | (up.router_count << (up.depth == 0 ? 12 : 8));
+			device.child_slot = SLOT_ERROR;
+		}
+		else {
+			if (up.node_count == UINT8_MAX) return false;
+			up.node_count++;
+			device.address = base | up.node_count;
+		}
+		// link it into the tree
+		if (last == DEVICE_NONE) up.first_child = index;
+		else m_devices[last].next_sibling = index;
+		last = index;
+		const JsonArrayConst grandchildren = obj["children"];
+		if (type == 0 && (grandchildren.size() || (obj["spare"] | static_cast<uint8_t>(0)))) return false;
+		if (type == 1 && !m_read_children(obj, index)) return false;
+	}
+	// end devices reserved after the real ones, so more can be added later without moving anyone else
+	DeviceInfo& up = m_devices[parent];
+	up.spare = parent_obj["spare"] | static_cast<uint8_t>(0);
+	if (up.node_count + up.spare > UINT8_MAX) return false;
+	up.node_count += up.spare;
+	return true;
+}
+
+bool LoomNet::NetworkTopology::m_count_slots() {
+	// children always come after their parent, so going backwards counts every subtree before it's used
+	uint16_t total = 0;
+	for (uint16_t i = m_count; i-- > 0; ) {
+		DeviceInfo& device = m_devices[i];
+		if (device.type == DeviceType::END_DEVICE) {
+			device.send_slots = 1;
+			total++;
+			continue;
+		}
+		// every child's slots are forwarded through this device
+		uint16_t block = 0;
+		// router subtrees without an interference group are placed one after another,
+		// while subtrees in different groups share the same slots
+		uint8_t lane_group[ROUTER_MAX];
+		uint16_t lane_span[ROUTER_MAX];
+		uint8_t lane_count = 0;
+		uint16_t serial = 0;
+		for (uint16_t c = device.first_child; c != DEVICE_NONE; c = m_devices[c].next_sibling) {
+			const DeviceInfo& child = m_devices[c];
+			block += child.send_slots;
+			if (child.type == DeviceType::END_DEVICE) continue;
+			if (!child.group) {
+				serial += child.span;
+				continue;
+			}
+			uint8_t lane = 0;
+			for (; lane < lane_count && lane_group[lane] != child.group; lane++);
+			if (lane == lane_count) {
+				lane_group[lane_count] = child.group;
+				lane_span[lane_count++] = 0;
+			}
+			lane_span[lane] += child.span;
+		}
+		// spare end devices each have a slot, like the real ones
+		block += device.spare;
+		total += device.spare;
+		uint16_t widest = 0;
+		for (uint8_t l = 0; l < lane_count; l++)
+			if (lane_span[l] > widest) widest = lane_span[l];
+		const uint16_t span = block + serial + widest;
+		// add a slot for sensing capabilities
+		const uint16_t send = block + (device.sensor ? 1 : 0);
+		if (span >= SLOT_NONE || send >= SLOT_NONE) return false;
+		device.child_slot_count = static_cast<uint8_t>(block);
+		device.span = static_cast<uint8_t>(span);
+		if (device.type != DeviceType::COORDINATOR) {
+			device.send_slots = static_cast<uint8_t>(send);
+			total += send;
+		}
+	}
+	if (m_config.order != SlotOrder::LAYERED) total = m_devices[0].span;
+	if (total >= SLOT_NONE) return false;
+	m_total_slots = static_cast<uint8_t>(total);
+	return true;
+}
+
+void LoomNet::NetworkTopology::m_place_layered() {
+	// reverse breadth-first: each layer comes after every layer below it,
+	// and inside a layer each parent's routers go before it's end devices
+	uint16_t layer_slots[ROUTER_DEPTH_MAX + 2] = {};
+	for (uint16_t i = 0; i < m_count; i++) {
+		const DeviceInfo& device = m_devices[i];
+		if (i) layer_slots[device.depth] += device.send_slots;
+		// spare end devices are in the layer below their parent
+		if (device.type != DeviceType::END_DEVICE) layer_slots[device.depth + 1] += device.spare;
+	}
+	uint16_t below = 0;
+	for (uint8_t layer = ROUTER_DEPTH_MAX + 1; layer > 0; layer--) {
+		uint16_t cursor = below;
+		for (uint16_t p = 0; p < m_count; p++) {
+			if (m_devices[p].depth != layer - 1) continue;
+			for (uint8_t pass = 0; pass < 2; pass++) {
+				for (uint16_t c = m_devices[p].first_child; c != DEVICE_NONE; c = m_devices[c].next_sibling) {
+					DeviceInfo& child = m_devices[c];
+					if ((child.type == DeviceType::END_DEVICE) != (pass == 1)) continue;
+					child.self_slot = static_cast<uint8_t>(cursor);
+					cursor += child.send_slots;
+				}
+			}
+			// then the spare end devices, which are the only children some routers have
+			if (m_devices[p].first_child == DEVICE_NONE && m_devices[p].spare) m_devices[p].child_slot = static_cast<uint8_t>(cursor);
+			cursor += m_devices[p].spare;
+		}
+		below += layer_slots[layer];
+	}
+	// each parent's first child is it's highest priority, routers before end devices
+	for (uint16_t p = 0; p < m_count; p++) {
+		DeviceInfo& device = m_devices[p];
+		if (device.type == DeviceType::END_DEVICE || device.first_child == DEVICE_NONE) continue;
+		uint16_t highest = DEVICE_NONE;
+		for (uint16_t c = device.first_child; c != DEVICE_NONE; c = m_devices[c].next_sibling) {
+			if (m_devices[c].type != DeviceType::END_DEVICE) {
+				highest = c;
+				break;
+			}
+			if (highest == DEVICE_NONE) highest = c;
+		}
+		device.child_slot = m_devices[highest].self_slot;
+	}
+}
+
+void LoomNet::NetworkTopology::m_place_nested(const uint16_t parent, const uint8_t block_end) {
+	// place the send slots of the children of this device immediately before block_end,
+	// then place each router child's own block immediately before this one
+	DeviceInfo& device = m_devices[parent];
+	const uint8_t block_start = block_end - device.child_slot_count;
+	device.child_slot = device.child_slot_count ? block_start : SLOT_ERROR;
+	// gather the routers first, so they can be sorted if needed
+	uint16_t routers[ROUTER_MAX];
+	uint8_t router_count = 0;
+	for (uint16_t c = device.first_child; c != DEVICE_NONE; c = m_devices[c].next_sibling) {
+		if (m_devices[c].type == DeviceType::END_DEVICE) continue;
+		// insertion sort, keeping configuration order for ties
+		uint8_t i = router_count++;
+		if (m_config.order == SlotOrder::LATENCY)
+			for (; i > 0 && m_latency_before(m_devices[c].send_slots, m_devices[c].span, m_devices[routers[i - 1]].send_slots, m_devices[routers[i - 1]].span); i--)
+				routers[i] = routers[i - 1];
+		routers[i] = c;
+	}
+	// routers transmit first in the block
+	uint8_t cursor = block_start;
+	for (uint8_t i = 0; i < router_count; i++) {
+		m_devices[routers[i]].self_slot = cursor;
+		cursor += m_devices[routers[i]].send_slots;
+	}
+	// their subtrees are nested in reverse order, so the first router's children finish right
+	// before it is allowed to forward. Routers without an interference group go closest to the block
+	uint8_t region_end = block_start;
+	for (uint8_t i = 0; i < router_count; i++) {
+		if (m_devices[routers[i]].group) continue;
+		m_place_nested(routers[i], region_end);
+		region_end -= m_devices[routers[i]].span;
+	}
+	// then each interference group gets its own lane, all of them ending at the same slot
+	uint8_t lane_group[ROUTER_MAX];
+	uint8_t lane_end[ROUTER_MAX];
+	uint8_t lane_count = 0;
+	for (uint8_t i = 0; i < router_count; i++) {
+		const uint8_t group = m_devices[routers[i]].group;
+		if (!group) continue;
+		uint8_t lane = 0;
+		for (; lane < lane_count && lane_group[lane] != group; lane++);
+		if (lane == lane_count) {
+			lane_group[lane_count] = group;
+			lane_end[lane_count++] = region_end;
+		}
+		m_place_nested(routers[i], lane_end[lane]);
+		lane_end[lane] -= m_devices[routers[i]].span;
+	}
+	// then the end devices, in configuration order
+	for (uint16_t c = device.first_child; c != DEVICE_NONE; c = m_devices[c].next_sibling)
+		if (m_devices[c].type == DeviceType::END_DEVICE) m_devices[c].self_slot = cursor++;
+}
+
+LoomNet::TimeInterval LoomNet::read_time_interval(const JsonObjectConst& obj) {
+	return m_json_to_time(obj);
+}
+
+uint16_t LoomNet::get_addr(const JsonObjectConst& topology, const char* name, DeviceInfo* devices, const uint16_t capacity) {
+	const NetworkTopology compiled(topology, devices, capacity);
+	if (!compiled.get_device_count()) return ADDR_ERROR;
+	const DeviceInfo* device = compiled.find(name);
+	return device ? device->address : ADDR_NONE;
+}
+
+NetworkInfo LoomNet::read_network_topology(const JsonObjectConst& topology, const char* self_name, DeviceInfo* devices, const uint16_t capacity) {
+	const NetworkTopology compiled(topology, devices, capacity);
+	const DeviceInfo* device = compiled.find(self_name);
+	if (!device) return NETWORK_ERROR;
+	return compiled.get_info(*device);
+}
+
+#if ARDUINOJSON_ENABLE_ARDUINO_PRINT
+// lets ArduinoJson's serializer write straight into a TopologyStream, without the text ever being kept
+class TopologyPrint : public Print {
+public:
+	explicit TopologyPrint(TopologyStream& stream)
+		: m_stream(stream) {}
+
+	size_t write(const uint8_t c) override { return m_stream.write(static_cast<char>(c)) ? 1 : 0; }
+	size_t write(const uint8_t* data, const size_t length) override { return m_stream.write(reinterpret_cast<const char*>(data), length) ? length : 0; }
+
+private:
+	TopologyStream& m_stream;
+};
+
+static void m_write_document(const JsonObjectConst& topology, TopologyStream& stream) {
+	TopologyPrint print(stream);
+	serializeJson(topology, print);
+}
+#else
+// off the board ArduinoJson has no Print, but serializes to a std::ostream
+class TopologyBuf : public std::streambuf {
+public:
+	explicit TopologyBuf(TopologyStream& stream)
+		: m_stream(stream) {}
+
+protected:
+	int_type overflow(const int_type c) override {
+		if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+		return m_stream.write(traits_type::to_char_type(c)) ? c : traits_type::eof();
+	}
+	std::streamsize xsputn(const char* data, const std::streamsize length) override { return m_stream.write(data, static_cast<size_t>(length)) ? length : 0; }
+
+private:
+	TopologyStream& m_stream;
+};
+
+static void m_write_document(const JsonObjectConst& topology, TopologyStream& stream) {
+	TopologyBuf buf(stream);
+	std::ostream out(&buf);
+	serializeJson(topology, out);
+}
+#endif
+
+uint16_t LoomNet::get_addr(const JsonObjectConst& topology, const char* name) {
+	TopologyStream stream(name, false);
+	m_write_document(topology, stream);
+	return stream.get_address();
+}
+
+NetworkInfo LoomNet::read_network_topology(const JsonObjectConst& topology, const char* self_name) {
+	// the config is already in the document, so the stream doesn't need its own copy
+	TopologyStream stream(self_name, false);
+	m_write_document(topology, stream);
+	return stream.get_info(topology["config"]);
+}
+
+static bool m_is_space(const char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// characters ArduinoJson allows in numbers, true, false, null and unquoted keys
+static bool m_is_bare(const char c) {
+	return (c >= '0' && c <= '9')
+		|| (c >= 'a' && c <= 'z')
+		|| (c >= 'A' && c <= 'Z')
+		|| c == '_' || c == '.' || c == '+' || c == '-';
+}
+
+static char m_unescape(const char c) {
+	// ArduinoJson is built without unicode escapes, so \u is an error there too
+	switch (c) {
+	case '"': return '"';
+	case '\'': return '\'';
+	case '\\': return '\\';
+	case '/': return '/';
+	case 'b': return '\b';
+	case 'f': return '\f';
+	case 'n': return '\n';
+	case 'r': return '\r';
+	case 't': return '\t';
+	default: return '\0';
+	}
+}
+
+static bool m_token_is(const char* token, const uint8_t length, const char* key) {
+	return strlen(key) == length && !strncmp(key, token, length);
+}
+
+static bool m_is_number(const char* str) {
+	// sign, digits, then an optional fraction and exponent
+	if (*str == '-' || *str == '+') str++;
+	if (*str < '0' || *str > '9') return false;
+	while (*str >= '0' && *str <= '9') str++;
+	if (*str == '.') for (str++; *str >= '0' && *str <= '9'; str++);
+	if (*str == 'e' || *str == 'E') {
+		str++;
+		if (*str == '-' || *str == '+') str++;
+		if (*str < '0' || *str > '9') return false;
+		while (*str >= '0' && *str <= '9') str++;
+	}
+	return *str == '\0';
+}
+
+static uint8_t m_number_to_u8(const char* str) {
+	// the same conversion as ArduinoJson's "value | 0" for uint8_t, anything out of range is zero
+	bool integer = true;
+	for (const char* c = str; *c; c++)
+		if (*c == '.' || *c == 'e' || *c == 'E') integer = false;
+	if (!integer) {
+		const double value = atof(str);
+		return value >= 0 && value <= UINT8_MAX ? static_cast<uint8_t>(value) : 0;
+	}
+	if (*str == '-') return 0;
+	if (*str == '+') str++;
+	uint16_t value = 0;
+	for (; *str; str++) {
+		value = value * 10 + (*str - '0');
+		if (value > UINT8_MAX) return 0;
+	}
+	return static_cast<uint8_t>(value);
+}
+
+LoomNet::TopologyStream::TopologyStream(const char* self_name, const bool keep_config)
+	: m_self_name(self_name)
+	, m_lex(self_name ? Lex::VALUE : Lex::ERROR)
+	, m_quote('"')
+	, m_target(Target::SKIP)
+	, m_key(Key::OTHER)
+	, m_top_keys(0)
+	, m_token{}
+	, m_token_len(0)
+	, m_name_len(0)
+	, m_name_differs(false)
+	, m_context{}
+	, m_depth(0)
+	, m_frames{}
+	, m_frames_open(0)
+	, m_path{}
+	, m_count(0)
+	, m_self_index(DEVICE_NONE)
+	, m_self_depth(0)
+	, m_layer{}
+	, m_has_groups(false)
+	, m_keep_config(keep_config)
+	, m_capturing(false)
+	, m_capture_depth(0)
+	, m_config{}
+	, m_config_len(0) {}
+
+bool LoomNet::TopologyStream::write(const char c) {
+	if (m_lex == Lex::ERROR) return false;
+	// anything after the topology is ignored, like ArduinoJson does
+	if (m_lex == Lex::DONE) return true;
+	// a config too big to keep can't be read later
+	if (!m_step(c) || m_config_len > CONFIG_MAX) m_lex = Lex::ERROR;
+	return m_lex != Lex::ERROR;
+}
+
+bool LoomNet::TopologyStream::write(const char* data, const size_t length) {
+	for (size_t i = 0; i < length; i++)
+		if (!write(data[i])) return false;
+	return true;
+}
+
+bool LoomNet::TopologyStream::m_step(const char c) {
+	// inside of strings and literals every character counts
+	switch (m_lex) {
+	case Lex::STRING:
+		m_capture(c);
+		if (c == m_quote) return m_end_string();
+		if (c == '\\') m_lex = Lex::ESCAPE;
+		else m_string_char(c);
+		return true;
+	case Lex::ESCAPE: {
+		m_capture(c);
+		const char unescaped = m_unescape(c);
+		if (!unescaped) return false;
+		m_lex = Lex::STRING;
+		m_string_char(unescaped);
+		return true;
+	}
+	case Lex::UNQUOTED_KEY:
+		if (m_is_bare(c)) {
+			m_capture(c);
+			m_string_char(c);
+			return true;
+		}
+		return m_end_string() && m_step(c);
+	case Lex::LITERAL:
+		if (m_is_bare(c)) {
+			m_capture(c);
+			if (m_token_len == TOKEN_MAX) return false;
+			m_token[m_token_len++] = c;
+			return true;
+		}
+		return m_end_literal() && m_step(c);
+	default:
+		break;
+	}
+	if (m_is_space(c)) return true;
+	switch (m_lex) {
+	case Lex::ARRAY_START:
+		if (c == ']') {
+			m_capture(c);
+			return m_close();
+		}
+		return m_begin_value(c);
+	case Lex::VALUE:
+		return m_begin_value(c);
+	case Lex::KEY:
+	case Lex::KEY_NEXT:
+		m_capture(c);
+		if (c == '}' && m_lex == Lex::KEY) return m_close();
+		m_target = Target::KEY;
+		m_token_len = 0;
+		if (c == '"' || c == '\'') {
+			m_quote = c;
+			m_lex = Lex::STRING;
+			return true;
+		}
+		if (!m_is_bare(c)) return false;
+		m_lex = Lex::UNQUOTED_KEY;
+		m_string_char(c);
+		return true;
+	case Lex::COLON:
+		m_capture(c);
+		if (c != ':') return false;
+		m_lex = Lex::VALUE;
+		return true;
+	case Lex::AFTER:
+		m_capture(c);
+		if (c == ',') {
+			m_lex = m_is_object() ? Lex::KEY_NEXT : Lex::VALUE;
+			return true;
+		}
+		if (c == (m_is_object() ? '}' : ']')) return m_close();
+		return false;
+	default:
+		return false;
+	}
+}
+
+bool LoomNet::TopologyStream::m_is_object() const {
+	const Context context = m_context[m_depth - 1];
+	return context != Context::CHILDREN && context != Context::ARRAY;
+}
+
+LoomNet::TopologyStream::Target LoomNet::TopologyStream::m_value_target() {
+	if (!m_depth) return Target::TOP;
+	const uint16_t bit = 1 << static_cast<uint8_t>(m_key);
+	switch (m_context[m_depth - 1]) {
+	case Context::TOP:
+		// like ArduinoJson, only the first of each key is used
+		if (m_key == Key::OTHER || (m_top_keys & bit)) return Target::SKIP;
+		m_top_keys |= bit;
+		return m_key == Key::ROOT ? Target::ROOT : Target::CONFIG;
+	case Context::DEVICE: {
+		Frame& device = m_frames[m_frames_open - 1];
+		if (m_key == Key::OTHER || (device.keys & bit)) return Target::SKIP;
+		device.keys |= bit;
+		if (m_key == Key::NAME) return Target::NAME;
+		if (m_key == Key::CHILDREN) return Target::CHILDREN;
+		if (m_key == Key::SPARE) return Target::SPARE;
+		// the coordinator has no type, group or sensor
+		if (m_frames_open == 1) return Target::SKIP;
+		if (m_key == Key::TYPE) return Target::TYPE;
+		if (m_key == Key::GROUP) return Target::GROUP;
+		return Target::SENSOR;
+	}
+	case Context::CHILDREN:
+		return Target::CHILD;
+	default:
+		return Target::SKIP;
+	}
+}
+
+bool LoomNet::TopologyStream::m_begin_value(const char c) {
+	m_target = m_value_target();
+	if (m_target == Target::CONFIG && m_keep_config) {
+		m_capturing = true;
+		m_capture_depth = m_depth;
+	}
+	m_capture(c);
+	if (c == '{' || c == '[') return m_open(c == '{');
+	// the topology, the root and every child must be objects
+	if (m_target == Target::TOP || m_target == Target::ROOT || m_target == Target::CHILD) return false;
+	if (c == '"' || c == '\'') {
+		m_quote = c;
+		m_lex = Lex::STRING;
+		m_name_len = 0;
+		m_name_differs = false;
+		return true;
+	}
+	if (!m_is_bare(c)) return false;
+	m_lex = Lex::LITERAL;
+	m_token[0] = c;
+	m_token_len = 1;
+	return true;
+}
+
+bool LoomNet::TopologyStream::m_open(const bool is_object) {
+	if (m_depth == ARDUINOJSON_DEFAULT_NESTING_LIMIT) return false;
+	Context context = is_object ? Context::OBJECT : Context::ARRAY;
+	switch (m_target) {
+	case Target::TOP:
+		if (!is_object) return false;
+		context = Context::TOP;
+		break;
+	case Target::ROOT:
+	case Target::CHILD:
+		if (!is_object || !m_open_device()) return false;
+		context = Context::DEVICE;
+		break;
+	case Target::CHILDREN:
+		// children that aren't an array are the same as no children
+		if (!is_object) context = Context::CHILDREN;
+		break;
+	// the name has to be a string, and the type a number
+	case Target::NAME:
+	case Target::TYPE:
+		return false;
+	default:
+		break;
+	}
+	m_context[m_depth++] = context;
+	m_lex = is_object ? Lex::KEY : Lex::ARRAY_START;
+	return true;
+}
+
+bool LoomNet::TopologyStream::m_close() {
+	if (m_context[--m_depth] == Context::DEVICE && !m_close_device()) return false;
+	return m_end_value();
+}
+
+bool LoomNet::TopologyStream::m_end_value() {
+	if (m_capturing && m_depth == m_capture_depth) m_capturing = false;
+	m_lex = m_depth ? Lex::AFTER : Lex::DONE;
+	return true;
+}
+
+void LoomNet::TopologyStream::m_string_char(const char c) {
+	if (m_target == Target::KEY) {
+		// keys longer than any we look for are ignored
+		if (m_token_len <= TOKEN_MAX) m_token[m_token_len++] = c;
+	}
+	else if (m_target == Target::NAME) {
+		// compare as we go, the same as strncmp up to STRING_MAX
+		if (m_name_len < STRING_MAX) {
+			if (m_self_name[m_name_len] != c) m_name_differs = true;
+			if (!m_name_differs) m_name_len++;
+		}
+	}
+}
+
+bool LoomNet::TopologyStream::m_end_string() {
+	if (m_target == Target::KEY) {
+		m_key = m_read_key();
+		m_lex = Lex::COLON;
+		return true;
+	}
+	if (m_target == Target::TYPE) return false;
+	if (m_target == Target::NAME && !m_name_differs && (m_name_len == STRING_MAX || m_self_name[m_name_len] == '\0')) {
+		// names should be unique, but if not the first device wins, which may be a parent of an earlier match
+		const Frame& device = m_frames[m_frames_open - 1];
+		if (m_self_index == DEVICE_NONE || device.index < m_self_index) {
+			m_self_index = device.index;
+			m_self_depth = m_frames_open - 1;
+		}
+	}
+	return m_end_value();
+}
+
+bool LoomNet::TopologyStream::m_end_literal() {
+	m_token[m_token_len] = '\0';
+	// ArduinoJson only checks the first letter and the length of true, false and null
+	const char first = m_token[0];
+	const bool is_bool = (first == 't' && m_token_len == 4) || (first == 'f' && m_token_len == 5);
+	const bool is_null = first == 'n' && m_token_len == 4;
+	const bool is_number = !is_bool && !is_null && m_is_number(m_token);
+	if (!is_bool && !is_null && !is_number) return false;
+	switch (m_target) {
+	case Target::NAME:
+		return false;
+	case Target::TYPE: {
+		Frame& device = m_frames[m_frames_open - 1];
+		const uint8_t type = is_number ? m_number_to_u8(m_token) : TYPE_UNKNOWN;
+		// a device with children has to be a router
+		if (type > 1 || (device.type == 1 && type == 0)) return false;
+		device.type = type;
+		break;
+	}
+	case Target::GROUP:
+		if (is_number) m_frames[m_frames_open - 1].group = m_number_to_u8(m_token);
+		break;
+	case Target::SPARE:
+		if (is_number) m_frames[m_frames_open - 1].spare = m_number_to_u8(m_token);
+		break;
+	case Target::SENSOR:
+		m_frames[m_frames_open - 1].sensor = is_bool && first == 't';
+		break;
+	default:
+		break;
+	}
+	return m_end_value();
+}
+
+LoomNet::TopologyStream::Key LoomNet::TopologyStream::m_read_key() const {
+	if (m_token_len > TOKEN_MAX) return Key::OTHER;
+	const Context context = m_context[m_depth - 1];
+	if (context == Context::TOP) {
+		if (m_token_is(m_token, m_token_len, "root")) return Key::ROOT;
+		if (m_token_is(m_token, m_token_len, "config")) return Key::CONFIG;
+	}
+	else if (context == Context::DEVICE) {
+		if (m_token_is(m_token, m_token_len, "name")) return Key::NAME;
+		if (m_token_is(m_token, m_token_len, "type")) return Key::TYPE;
+		if (m_token_is(m_token, m_token_len, "sensor")) return Key::SENSOR;
+		if (m_token_is(m_token, m_token_len, "group")) return Key::GROUP;
+		if (m_token_is(m_token, m_token_len, "spare")) return Key::SPARE;
+		if (m_token_is(m_token, m_token_len, "children")) return Key::CHILDREN;
+	}
+	return Key::OTHER;
+}
+
+void LoomNet::TopologyStream::m_capture(const char c) {
+	if (!m_capturing) return;
+	if (m_config_len < CONFIG_MAX) m_config[m_config_len] = c;
+	m_config_len++;
+}
+
+bool LoomNet::TopologyStream::m_open_device() {
+	if (m_count == MAX_DEVICES) return false;
+	const uint8_t depth = m_frames_open;
+	if (depth == DEPTH_MAX || (depth && !m_make_router(depth - 1))) return false;
+	Frame& device = m_frames[m_frames_open++];
+	device = Frame{};
+	device.index = m_count++;
+	device.address = depth ? ADDR_ERROR : ADDR_COORD;
+	device.type = TYPE_UNKNOWN;
+	device.layer_before = m_layer[depth + 1];
+	return true;
+}
+
+bool LoomNet::TopologyStream::m_make_router(const uint8_t depth) {
+	// a device with children must be a router, and it's address can be set now
+	// since every sibling before it has already been read
+	if (!depth) return true;
+	Frame& device = m_frames[depth];
+	if (device.type == 0) return false;
+	device.type = 1;
+	return device.address != ADDR_ERROR || m_assign(depth);
+}
+
+bool LoomNet::TopologyStream::m_assign(const uint8_t depth) {
+	// the same addressing as NetworkTopology::m_read_children
+	Frame& device = m_frames[depth];
+	Frame& up = m_frames[depth - 1];
+	const uint16_t base = depth == 1 ? 0 : up.address;
+	if (device.type == 1) {
+		if (depth - 1 >= ROUTER_DEPTH_MAX || up.router_count == ROUTER_MAX) return false;
+		device.position = up.router_count++;
+		device.address = base | (up.router_count << (depth == 1 ? 12 : 8));
+	}
+	else {
+		if (up.node_count == UINT8_MAX) return false;
+		device.position = up.node_count++;
+		device.address = base | up.node_count;
+	}
+	return true;
+}
+
+bool LoomNet::TopologyStream::m_close_device() {
+	const uint8_t depth = m_frames_open - 1;
+	Frame& device = m_frames[depth];
+	if (!(device.keys & (1 << static_cast<uint8_t>(Key::NAME)))) return false;
+	if (depth) {
+		if (device.type == TYPE_UNKNOWN) return false;
+		if (device.address == ADDR_ERROR && !m_assign(depth)) return false;
+	}
+	if (depth && device.type == 0) {
+		if (device.spare) return false;
+		device.send = 1;
+	}
+	else {
+		// spare end devices come after the real ones, in the layer below
+		if (device.node_count + device.spare > UINT8_MAX) return false;
+		device.node_count += device.spare;
+		device.block += device.spare;
+		m_layer[depth + 1] += device.spare;
+		// the same as NetworkTopology::m_count_slots, from the router children we kept
+		uint8_t lane_group[ROUTER_MAX];
+		uint16_t lane_span[ROUTER_MAX];
+		uint8_t lane_count = 0;
+		uint16_t serial = 0;
+		for (uint8_t r = 0; r < device.router_count; r++) {
+			if (!device.router_group[r]) {
+				serial += device.router_span[r];
+				continue;
+			}
+			uint8_t lane = 0;
+			for (; lane < lane_count && lane_group[lane] != device.router_group[r]; lane++);
+			if (lane == lane_count) {
+				lane_group[lane_count] = device.router_group[r];
+				lane_span[lane_count++] = 0;
+			}
+			lane_span[lane] += device.router_span[r];
+		}
+		uint16_t widest = 0;
+		for (uint8_t l = 0; l < lane_count; l++)
+			if (lane_span[l] > widest) widest = lane_span[l];
+		const uint16_t span = device.block + serial + widest;
+		const uint16_t send = device.block + (device.sensor ? 1 : 0);
+		if (span >= SLOT_NONE || send >= SLOT_NONE) return false;
+		device.span = static_cast<uint8_t>(span);
+		device.send = depth ? static_cast<uint8_t>(send) : 0;
+	}
+	if (device.group) m_has_groups = true;
+	// keep everything on the path down to our device
+	if (device.index == m_self_index) device.on_path = true;
+	if (device.on_path) m_path[depth] = device;
+	m_frames_open--;
+	if (!depth) return true;
+	Frame& up = m_frames[depth - 1];
+	m_layer[depth] += device.send;
+	up.block += device.send;
+	if (device.type == 1) {
+		up.router_send[device.position] = device.send;
+		up.router_span[device.position] = device.span;
+		up.router_group[device.position] = device.group;
+	}
+	if (device.on_path) {
+		up.on_path = true;
+		up.path_child = device.position;
+	}
+	return true;
+}
+
+void LoomNet::TopologyStream::m_place_router(const Frame& parent, const SlotOrder order, const uint8_t block_start, uint8_t& slot, uint8_t& block_end) const {
+	// the same as NetworkTopology::m_place_nested, but only for the router on the path
+	uint8_t routers[ROUTER_MAX];
+	for (uint8_t r = 0; r < parent.router_count; r++) {
+		uint8_t i = r;
+		if (order == SlotOrder::LATENCY)
+			for (; i > 0 && m_latency_before(parent.router_send[r], parent.router_span[r], parent.router_send[routers[i - 1]], parent.router_span[routers[i - 1]]); i--)
+				routers[i] = routers[i - 1];
+		routers[i] = r;
+	}
+	uint8_t cursor = block_start;
+	for (uint8_t i = 0; i < parent.router_count; i++) {
+		if (routers[i] == parent.path_child) slot = cursor;
+		cursor += parent.router_send[routers[i]];
+	}
+	uint8_t region_end = block_start;
+	for (uint8_t i = 0; i < parent.router_count; i++) {
+		if (parent.router_group[routers[i]]) continue;
+		if (routers[i] == parent.path_child) block_end = region_end;
+		region_end -= parent.router_span[routers[i]];
+	}
+	uint8_t lane_group[ROUTER_MAX];
+	uint8_t lane_end[ROUTER_MAX];
+	uint8_t lane_count = 0;
+	for (uint8_t i = 0; i < parent.router_count; i++) {
+		const uint8_t group = parent.router_group[routers[i]];
+		if (!group) continue;
+		uint8_t lane = 0;
+		for (; lane < lane_count && lane_group[lane] != group; lane++);
+		if (lane == lane_count) {
+			lane_group[lane_count] = group;
+			lane_end[lane_count++] = region_end;
+		}
+		if (routers[i] == parent.path_child) block_end = lane_end[lane];
+		lane_end[lane] -= parent.router_span[routers[i]];
+	}
+}
+
+NetworkInfo LoomNet::TopologyStream::get_info() const {
+	if (m_lex != Lex::DONE || m_self_index == DEVICE_NONE || !m_config_len) return NETWORK_ERROR;
+	StaticJsonDocument<CONFIG_MAX * 2> doc;
+	if (deserializeJson(doc, static_cast<const char*>(m_config), m_config_len)) return NETWORK_ERROR;
+	return get_info(doc.as<JsonObjectConst>());
+}
+
+uint16_t LoomNet::TopologyStream::get_address() const {
+	if (m_lex != Lex::DONE) return ADDR_ERROR;
+	return m_self_index == DEVICE_NONE ? ADDR_NONE : m_path[m_self_depth].address;
+}
+
+NetworkInfo LoomNet::TopologyStream::get_info(const JsonObjectConst& config_obj) const {
+	if (m_lex != Lex::DONE || m_self_index == DEVICE_NONE) return NETWORK_ERROR;
+	NetworkConfig config{ SlotOrder::ERROR, 0, 0, 0, TIME_NONE, TIME_NONE, TIME_NONE, false, 0, 0, 0, 0, 0, 0, 0 };
+	if (!m_read_config(config_obj, config)) return NETWORK_ERROR;
+	if (config.order == SlotOrder::LAYERED && m_has_groups) return NETWORK_ERROR;
+	const uint8_t depth = m_self_depth;
+	const Frame& self = m_path[depth];
+	const bool is_end_device = depth && self.type == 0;
+	// the layered order counts every layer, the others nest everything inside the coordinator's span
+	uint16_t below[DEPTH_MAX + 1] = {};
+	for (uint8_t d = DEPTH_MAX - 1; d-- > 0; ) below[d] = below[d + 1] + m_layer[d + 1];
+	const uint16_t total = config.order == SlotOrder::LAYERED ? below[0] : m_path[0].span;
+	if (total >= SLOT_NONE) return NETWORK_ERROR;
+	uint8_t self_slot = SLOT_NONE;
+	uint8_t child_slot = is_end_device ? SLOT_NONE : SLOT_ERROR;
+	if (config.order == SlotOrder::LAYERED) {
+		// each parent's routers go before it's end devices, after every device in the layer with an earlier parent
+		if (depth) {
+			const Frame& up = m_path[depth - 1];
+			uint16_t slot = below[depth] + up.layer_before;
+			const uint8_t routers_before = is_end_device ? up.router_count : self.position;
+			for (uint8_t r = 0; r < routers_before; r++) slot += up.router_send[r];
+			if (is_end_device) slot += self.position;
+			self_slot = static_cast<uint8_t>(slot);
+		}
+		if (!is_end_device && (self.router_count || self.node_count))
+			child_slot = static_cast<uint8_t>(below[depth + 1] + self.layer_before);
+	}
+	else {
+		// walk down the path, placing each block in front of it's parent's
+		uint8_t block_end = static_cast<uint8_t>(total);
+		for (uint8_t d = 0; d < depth; d++) {
+			const Frame& up = m_path[d];
+			const uint8_t block_start = block_end - up.block;
+			if (d + 1 == depth && is_end_device) {
+				uint16_t slot = block_start + self.position;
+				for (uint8_t r = 0; r < up.router_count; r++) slot += up.router_send[r];
+				self_slot = static_cast<uint8_t>(slot);
+			}
+			else m_place_router(up, config.order, block_start, self_slot, block_end);
+		}
+		if (!is_end_device && self.block) child_slot = block_end - self.block;
+	}
+	const DeviceType type = !depth ? DeviceType::COORDINATOR
+		: is_end_device ? DeviceType::END_DEVICE
+		: depth == 1 ? DeviceType::FIRST_ROUTER : DeviceType::SECOND_ROUTER;
+	return m_make_info(config,
+		static_cast<uint8_t>(total),
+		type,
+		self.address,
+		depth ? m_path[depth - 1].address : ADDR_NONE,
+		self.router_count,
+		self.node_count,
+		self_slot,
+		is_end_device ? 1 : self.send,
+		child_slot,
+		is_end_device ? 0 : static_cast<uint8_t>(self.block));
 }
\ No newline at end of file
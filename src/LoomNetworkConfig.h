@@ -2,6 +2,7 @@
 #include "LoomNetworkInfo.h"
 #include "LoomNetworkUtility.h"
 #include "LoomNetworkTime.h"
+#include "LoomNetworkBlob.h"
 #include <ArduinoJson.h>
 #include <stdint.h>
 /** 
@@ -10,6 +11,313 @@
  */
 
 namespace LoomNet {
+	/**
+	 * Slot assignment orders selectable with the "slot_order" configuration key
+	 * LAYERED: reverse breadth-first, as described in the standard (default)
+	 * LATENCY: every router's children are placed directly in front of its send slots, and sibling
+	 *	routers are ordered to minimize the time packets wait to be forwarded
+	 * WAKEUPS: same nesting as LATENCY, but unsorted: sibling routers keep configuration order.
+	 *	It saves no wakeups over LATENCY, but lets the configuration pick each parent's first router,
+	 *	the only one that stays awake from its recieve slots straight into its send slots
+	 */
+	enum class SlotOrder : uint8_t {
+		LAYERED,
+		LATENCY,
+		WAKEUPS,
+		ERROR
+	};
+
+	constexpr uint16_t DEVICE_NONE = 0xFFFF;
+	// most routers a single device can have, per the address scheme
+	constexpr uint8_t ROUTER_MAX = 15;
+	// routers can be two layers deep, under the coordinator
+	constexpr uint8_t ROUTER_DEPTH_MAX = 2;
+
+	/**
+	 * The network wide settings from the "config" object, the same for every device
+	 * the adaptive ranges are only used if adaptive is set
+	 */
+	struct NetworkConfig {
+		SlotOrder order;
+		uint8_t cycles_per_batch;
+		uint8_t cycle_gap;
+		uint8_t batch_gap;
+		TimeInterval min_drift;
+		TimeInterval max_drift;
+		TimeInterval slot_length;
+		bool adaptive;
+		uint8_t min_cycles;
+		uint8_t max_cycles;
+		uint8_t min_cycle_gap;
+		uint8_t max_cycle_gap;
+		uint8_t min_batch_gap;
+		uint8_t max_batch_gap;
+		uint8_t hold;
+	};
+
+	/**
+	 * A single device in a compiled topology
+	 * parent, first_child and next_sibling are indexes into the same device table
+	 */
+	struct DeviceInfo {
+		const char* name;
+		DeviceType type;
+		uint16_t address;
+		uint16_t parent;
+		uint16_t first_child;
+		uint16_t next_sibling;
+		uint8_t depth;
+		uint8_t group;
+		bool sensor;
+		uint8_t router_count;
+		// end devices reserved with the "spare" key are counted here, after the real ones
+		uint8_t node_count;
+		uint8_t spare;
+		uint8_t self_slot;
+		uint8_t send_slots;
+		uint8_t child_slot;
+		uint8_t child_slot_count;
+		// every slot used by the subtree, excluding the device's own send slots
+		uint8_t span;
+	};
+
+	/**
+	 * What differs in a device's NetworkInfo between two compiles of a topology, as bits
+	 * ADDED is set alone, when the device is not in the other topology
+	 */
+	enum InfoChange : uint8_t {
+		CHANGE_NONE = 0,
+		CHANGE_ROUTE = 1 << 0,
+		CHANGE_SLOT = 1 << 1,
+		CHANGE_DRIFT = 1 << 2,
+		CHANGE_BATCH = 1 << 3,
+		CHANGE_ADDED = 1 << 4
+	};
+
+	/**
+	 * Every device's NetworkInfo, from a single walk of the topology JSON
+	 * The device table is owned by the caller and must fit the whole network,
+	 * devices are stored depth-first in configuration order, starting with the coordinator
+	 */
+	class NetworkTopology {
+	public:
+		NetworkTopology(const JsonObjectConst& topology, DeviceInfo* devices, const uint16_t capacity);
+		// the same network, copied into another table, invalid if it doesn't fit
+		NetworkTopology(const NetworkTopology& rhs, DeviceInfo* devices, const uint16_t capacity);
+
+		// false if the tree or the config could not be read
+		bool is_valid() const { return m_valid; }
+		uint16_t get_device_count() const { return m_count; }
+		const DeviceInfo& get_device(const uint16_t index) const { return m_devices[index]; }
+
+		// nullptr if not found
+		const DeviceInfo* find(const char* name) const;
+		const DeviceInfo* find(const uint16_t address) const;
+
+		NetworkInfo get_info(const DeviceInfo& device) const;
+
+		// which parts of this device's NetworkInfo are different in before, matching devices by name
+		uint8_t compare(const DeviceInfo& device, const NetworkTopology& before) const;
+
+		// write the network as a blob for read_network_blob, returns the size written or zero if it doesn't fit
+		uint32_t write_blob(uint8_t* blob, const uint32_t capacity) const;
+
+	private:
+		bool m_read_children(const JsonObjectConst& parent_obj, const uint16_t parent);
+		bool m_count_slots();
+		void m_place_layered();
+		void m_place_nested(const uint16_t parent, const uint8_t block_end);
+
+		DeviceInfo* m_devices;
+		const uint16_t m_capacity;
+		uint16_t m_count;
+		bool m_has_groups;
+		uint8_t m_total_slots;
+		NetworkConfig m_config;
+		bool m_valid;
+	};
+
+	/**
+	 * Reads a single device's NetworkInfo from the topology JSON one character at a time,
+	 * for networks too large to fit in a JsonDocument, straight from an SD card or serial port.
+	 * Only running counts and the devices on the path down to this one are kept, so memory use
+	 * does not grow with the network. The config object is copied aside and read with ArduinoJson
+	 * once the topology ends, so it must fit in CONFIG_MAX. Gives the same result as read_network_topology.
+	 */
+	class TopologyStream {
+	public:
+		static constexpr uint16_t CONFIG_MAX = 512;
+
+		// without keep_config the config isn't copied, so it may be any size, but only
+		// get_info(config) and get_address can be used
+		explicit TopologyStream(const char* self_name, const bool keep_config = true);
+
+		// returns false once the topology can no longer be valid
+		bool write(const char c);
+		bool write(const char* data, const size_t length);
+
+		// true once the whole topology has been written
+		bool is_done() const { return m_lex == Lex::DONE; }
+		uint16_t get_device_count() const { return m_count; }
+
+		// NETWORK_ERROR unless the whole topology has been written and is valid
+		NetworkInfo get_info() const;
+		// the same, reading the config from a document the caller already has instead of the copy
+		NetworkInfo get_info(const JsonObjectConst& config) const;
+		// ADDR_ERROR unless the whole topology has been written, ADDR_NONE if the device isn't in it
+		uint16_t get_address() const;
+
+	private:
+		// coordinator, first router, second router, end device
+		static constexpr uint8_t DEPTH_MAX = ROUTER_DEPTH_MAX + 2;
+		static constexpr uint8_t TYPE_UNKNOWN = 255;
+		// long enough for any key we look for, and any number ArduinoJson reads
+		static constexpr uint8_t TOKEN_MAX = STRING_MAX;
+
+		enum class Lex : uint8_t {
+			VALUE,
+			ARRAY_START,
+			KEY,
+			KEY_NEXT,
+			UNQUOTED_KEY,
+			COLON,
+			AFTER,
+			STRING,
+			ESCAPE,
+			LITERAL,
+			DONE,
+			ERROR
+		};
+
+		// what each open object or array is
+		enum class Context : uint8_t {
+			TOP,
+			DEVICE,
+			CHILDREN,
+			OBJECT,
+			ARRAY
+		};
+
+		enum class Key : uint8_t {
+			OTHER,
+			ROOT,
+			CONFIG,
+			NAME,
+			TYPE,
+			SENSOR,
+			GROUP,
+			SPARE,
+			CHILDREN
+		};
+
+		// what the value being read is used for
+		enum class Target : uint8_t {
+			SKIP,
+			KEY,
+			TOP,
+			ROOT,
+			CONFIG,
+			NAME,
+			TYPE,
+			SENSOR,
+			GROUP,
+			SPARE,
+			CHILDREN,
+			CHILD
+		};
+
+		// running counts for a device that is open in the stream
+		struct Frame {
+			uint16_t index;
+			uint16_t address;
+			// 0 or 1 as in the JSON, a device with children is implied to be a router
+			uint8_t type;
+			// bit for each Key already read, only the first of each counts
+			uint16_t keys;
+			uint8_t group;
+			uint8_t spare;
+			bool sensor;
+			// this device, or one of it's children, is the device we're looking for
+			bool on_path;
+			uint8_t router_count;
+			uint8_t node_count;
+			// which router or end device this is under it's parent, from zero
+			uint8_t position;
+			// which router child is on the path
+			uint8_t path_child;
+			// slots the next layer down had used when this device started, for the layered order
+			uint16_t layer_before;
+			// send slots of every child
+			uint16_t block;
+			uint8_t send;
+			uint8_t span;
+			uint8_t router_send[ROUTER_MAX];
+			uint8_t router_span[ROUTER_MAX];
+			uint8_t router_group[ROUTER_MAX];
+		};
+
+		bool m_step(const char c);
+		bool m_is_object() const;
+		Target m_value_target();
+		bool m_begin_value(const char c);
+		bool m_open(const bool is_object);
+		bool m_close();
+		bool m_end_value();
+		void m_string_char(const char c);
+		bool m_end_string();
+		bool m_end_literal();
+		Key m_read_key() const;
+		void m_capture(const char c);
+		bool m_open_device();
+		bool m_make_router(const uint8_t depth);
+		bool m_assign(const uint8_t depth);
+		bool m_close_device();
+		void m_place_router(const Frame& parent, const SlotOrder order, const uint8_t block_start, uint8_t& slot, uint8_t& block_end) const;
+
+		const char* const m_self_name;
+		Lex m_lex;
+		char m_quote;
+		Target m_target;
+		Key m_key;
+		uint8_t m_top_keys;
+		char m_token[TOKEN_MAX + 1];
+		uint8_t m_token_len;
+		uint8_t m_name_len;
+		bool m_name_differs;
+		Context m_context[ARDUINOJSON_DEFAULT_NESTING_LIMIT];
+		uint8_t m_depth;
+		Frame m_frames[DEPTH_MAX];
+		uint8_t m_frames_open;
+		Frame m_path[DEPTH_MAX];
+		uint16_t m_count;
+		uint16_t m_self_index;
+		uint8_t m_self_depth;
+		// send slots used by each layer, for the layered order
+		uint16_t m_layer[DEPTH_MAX + 1];
+		bool m_has_groups;
+		bool m_keep_config;
+		bool m_capturing;
+		uint8_t m_capture_depth;
+		char m_config[CONFIG_MAX];
+		uint16_t m_config_len;
+	};
+
+	// read a whole topology from anything with available() and read(), like an SD card File
+	template<class T>
+	NetworkInfo read_network_stream(T& stream, const char* self_name) {
+		TopologyStream reader(self_name);
+		while (stream.available() && reader.write(static_cast<char>(stream.read())));
+		return reader.get_info();
+	}
+
+	// a { "unit": "SECOND", "time": 10 } object, the same as the timing in a topology, or TIME_NONE
+	TimeInterval read_time_interval(const JsonObjectConst& obj);
+
+	// thin lookups on top of NetworkTopology, the device table is owned by the caller and must fit the whole network
+	uint16_t get_addr(const JsonObjectConst& topology, const char* name, DeviceInfo* devices, const uint16_t capacity);
+	NetworkInfo read_network_topology(const JsonObjectConst& topology, const char* self_name, DeviceInfo* devices, const uint16_t capacity);
+	// the same without a table, the document is written through a TopologyStream so only the path to the device is kept
+	// this is what a device should use on boot, it takes about a kilobyte of stack where a table of MAX_DEVICES takes seven
 	uint16_t get_addr(const JsonObjectConst& topology, const char* name);
 	NetworkInfo read_network_topology(const JsonObjectConst& topology, const char* self_name);
-}
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "LoomRouter.h"
 #include "LoomSlotter.h"
+#include "LoomBatchTuner.h"
 #include "LoomNetworkUtility.h"
 #include "LoomNetworkTime.h"
 /** Simple container class for information extracted from a network configuration */
@@ -9,7 +10,7 @@
 namespace LoomNet {
 	class Drift {
 	public:
-		Drift(const TimeInterval& min_drift_prop,
+		constexpr Drift(const TimeInterval& min_drift_prop,
 			const TimeInterval& max_drift_prop,
 			const TimeInterval& slot_length_prop)
 			: min_drift(min_drift_prop)
@@ -27,13 +28,14 @@ namespace LoomNet {
 		const TimeInterval slot_length;
 	};
 
-	const Drift DRIFT_ERROR = { TIME_NONE, TIME_NONE, TIME_NONE };
+	constexpr Drift DRIFT_ERROR = { TIME_NONE, TIME_NONE, TIME_NONE };
 
 	struct NetworkInfo {
 		const Router route_info;
 		const Slotter slot_info;
 		const Drift	drift_info;
+		const BatchTuner batch_info;
 	};
 
-	const NetworkInfo NETWORK_ERROR = { ROUTER_ERROR, SLOTTER_ERROR, DRIFT_ERROR };
+	constexpr NetworkInfo NETWORK_ERROR = { ROUTER_ERROR, SLOTTER_ERROR, DRIFT_ERROR, BATCH_FIXED };
 }
@@ -96,6 +96,29 @@ Packet RefreshPacket::Factory(const uint16_t src_addr,
 	return ret;
 }
 
+Packet RefreshPacket::Factory(const uint16_t src_addr,
+	TimeInterval data_interval, // must be 8bits long
+	TimeInterval refresh_interval, // must be 16bits long
+	const uint8_t count,
+	const uint8_t cycles_per_batch,
+	const uint8_t cycle_gap,
+	const uint8_t batch_gap) {
+
+	Packet ret = Factory(src_addr, data_interval, refresh_interval, count);
+	uint8_t* pkt = &(ret.get_raw()[Packet::PAYLOAD]);
+	auto pkt_count = ret.get_write_count();
+	// overflow check
+	if (ret.get_control() == PacketCtrl::ERROR || 9 > pkt_count) ret.set_error();
+	else {
+		// flag and append the batch parameters
+		pkt[Structure::INTERVAL_CTRL] |= BATCH_FLAG;
+		pkt[Structure::CYCLES] = cycles_per_batch;
+		pkt[Structure::CYCLE_GAP] = cycle_gap;
+		pkt[Structure::BATCH_GAP] = batch_gap;
+	}
+	return ret;
+}
+
 uint8_t Packet::m_get_fragment_end() const {
 	const PacketCtrl ctrl = get_control();
 
@@ -112,9 +112,15 @@ namespace LoomNet {
 			INTERVAL_CTRL = 0,
 			DATA_OFF = 1,
 			REFRESH_OFF = 2,
-			COUNT = 5
+			COUNT = 5,
+			// only present if BATCH_FLAG is set in INTERVAL_CTRL
+			CYCLES = 6,
+			CYCLE_GAP = 7,
+			BATCH_GAP = 8
 		};
 
+		static constexpr uint8_t BATCH_FLAG = 1 << 6;
+
 		TimeInterval get_data_interval() const { return TimeInterval(payload()[Structure::INTERVAL_CTRL] & static_cast<uint8_t>(0x07), payload()[Structure::DATA_OFF]); }
 		TimeInterval get_refresh_interval() const {
 			return TimeInterval(
@@ -123,13 +129,26 @@ namespace LoomNet {
 			);
 		}
 		uint8_t get_count() const { return payload()[Structure::COUNT]; }
-		uint8_t get_fragment_length() const { return Structure::COUNT + 1; }
+		// batch parameters the coordinator wants applied for the batch starting with this refresh
+		bool has_batch_params() const { return (payload()[Structure::INTERVAL_CTRL] & BATCH_FLAG) != 0; }
+		uint8_t get_cycles_per_batch() const { return payload()[Structure::CYCLES]; }
+		uint8_t get_cycle_gap() const { return payload()[Structure::CYCLE_GAP]; }
+		uint8_t get_batch_gap() const { return payload()[Structure::BATCH_GAP]; }
+		uint8_t get_fragment_length() const { return (has_batch_params() ? Structure::BATCH_GAP : Structure::COUNT) + 1; }
 		uint8_t get_packet_length() const { return get_fragment_length() + Packet::Structure::PAYLOAD + 2; }
 
 		static Packet Factory(const uint16_t src_addr,
 			TimeInterval data_interval, // must be 8bits long
 			TimeInterval refresh_interval, // must be 16bits long
 			const uint8_t count);
+
+		static Packet Factory(const uint16_t src_addr,
+			TimeInterval data_interval, // must be 8bits long
+			TimeInterval refresh_interval, // must be 16bits long
+			const uint8_t count,
+			const uint8_t cycles_per_batch,
+			const uint8_t cycle_gap,
+			const uint8_t batch_gap);
 	};
 
 	class ACKPacket : public DerivedPacket {
@@ -140,15 +159,19 @@ namespace LoomNet {
 		}
 	};
 
-	struct PacketFingerprint {
+	// kept as bytes so a buffer of them isn't padded out to four each
+	class PacketFingerprint {
+	public:
 		PacketFingerprint(const uint16_t addr, const uint8_t rolling_id)
-			: src_addr(addr)
-			, rolling_id(rolling_id) {}
+			: m_raw{ static_cast<uint8_t>(addr & 0xff), static_cast<uint8_t>(addr >> 8), rolling_id } {}
 
 		PacketFingerprint(const DataPacket& packet)
 			: PacketFingerprint(packet.get_orig_src(), packet.get_rolling_id()) {}
 
-		const uint16_t src_addr;
-		const uint8_t rolling_id;
+		uint16_t get_src() const { return static_cast<uint16_t>(m_raw[0]) | static_cast<uint16_t>(m_raw[1]) << 8; }
+		uint8_t get_rolling_id() const { return m_raw[2]; }
+
+	private:
+		uint8_t m_raw[3];
 	};
 }
@@ -0,0 +1,131 @@
+#pragma once
+#include <stdint.h>
+#include "CircularBuffer.h"
+#include "LoomNetworkPacket.h"
+
+/**
+ * What Network does with a packet that isn't up to the MAC, picked at compile time so the choice
+ * costs nothing while running. Each is a template parameter of Network, and the defaults are what
+ * Network has always done:
+ *  - the send queue picks which waiting packet goes out when the MAC can send to a neighbor
+ *  - dedup decides if a data packet is a repeat of one we've already handled
+ *  - retry decides if a packet the MAC couldn't send goes back in the queue
+ *  - overflow decides what gives when the send or recieve buffer is full
+ * The ones that keep state are sized by Network's buffer sizes, and have a snapshot like the rest of it.
+ */
+
+namespace LoomNet {
+	// oldest first for each neighbor, which keeps a sequence in order
+	// an Entry has a packet and get_dst(), the neighbor it's going to
+	template<class Entry, size_t max_size>
+	class FifoSendQueue {
+	public:
+		size_t size() const { return m_buffer.size(); }
+		bool full() const { return m_buffer.full(); }
+		bool empty() const { return m_buffer.empty(); }
+		const Entry& operator[](const size_t index) const { return m_buffer[index]; }
+
+		bool push(const Entry& entry) { return m_buffer.add_back(entry); }
+		// where the next packet for the neighbor is, or size() if there isn't one
+		size_t find(const uint16_t dst) const {
+			for (size_t i = 0; i < m_buffer.size(); i++)
+				if (m_buffer[i].get_dst() == dst) return i;
+			return m_buffer.size();
+		}
+		void remove(const size_t index) {
+			auto iter = m_buffer.crange().begin();
+			for (size_t i = 0; i < index; i++) ++iter;
+			m_buffer.remove(iter);
+		}
+		// the one that's been waiting longest, to make room
+		bool drop_oldest() { return m_buffer.destroy_front(); }
+		void reset() { m_buffer.reset(); }
+
+		template<class Archive>
+		void snapshot(Archive& archive) { m_buffer.snapshot(archive); }
+
+	private:
+		CircularBuffer<Entry, max_size> m_buffer;
+	};
+
+	// newest first for each neighbor, so the latest readings get through first when a link falls behind
+	template<class Entry, size_t max_size>
+	class NewestSendQueue : public FifoSendQueue<Entry, max_size> {
+	public:
+		size_t find(const uint16_t dst) const {
+			for (size_t i = this->size(); i > 0; i--)
+				if ((*this)[i - 1].get_dst() == dst) return i - 1;
+			return this->size();
+		}
+	};
+
+	// remembers the last few data packets by who sent them first and their rolling ID
+	template<size_t max_size>
+	class FingerprintDedup {
+	public:
+		// true if we've already handled this one, else it's remembered
+		bool seen(const DataPacket& packet) {
+			for (const PacketFingerprint& elem : m_buffer.crange()) {
+				if (elem.get_src() == packet.get_orig_src()
+					&& elem.get_rolling_id() == packet.get_rolling_id()) return true;
+			}
+			if (m_buffer.full()) m_buffer.destroy_front();
+			m_buffer.emplace_back(packet);
+			return false;
+		}
+		void reset() { m_buffer.reset(); }
+
+		template<class Archive>
+		void snapshot(Archive& archive) { m_buffer.snapshot(archive); }
+
+	private:
+		CircularBuffer<PacketFingerprint, max_size> m_buffer;
+	};
+
+	// keeps nothing, for applications that can handle the odd repeat themselves
+	template<size_t max_size>
+	class NoDedup {
+	public:
+		bool seen(const DataPacket&) { return false; }
+		void reset() {}
+
+		template<class Archive>
+		void snapshot(Archive&) {}
+	};
+
+	// failures is how many times the packet has failed to send, counting this one
+	struct AlwaysRetry {
+		static constexpr bool retry(const uint8_t) { return true; }
+	};
+
+	// for data that's stale by the next slot anyway
+	struct NoRetry {
+		static constexpr bool retry(const uint8_t) { return false; }
+	};
+
+	template<uint8_t attempts>
+	struct LimitedRetry {
+		static constexpr bool retry(const uint8_t failures) { return failures < attempts; }
+	};
+
+	enum class OverflowAction {
+		// close the network with SEND_BUF_FULL or RECV_BUF_FULL
+		HALT,
+		// drop the packet that didn't fit and keep going
+		DROP_NEWEST,
+		// drop the oldest packet in the buffer to make room
+		DROP_OLDEST,
+	};
+
+	struct HaltOnOverflow {
+		static constexpr OverflowAction action = OverflowAction::HALT;
+	};
+
+	struct DropNewestOnOverflow {
+		static constexpr OverflowAction action = OverflowAction::DROP_NEWEST;
+	};
+
+	struct DropOldestOnOverflow {
+		static constexpr OverflowAction action = OverflowAction::DROP_OLDEST;
+	};
+}
\ No newline at end of file
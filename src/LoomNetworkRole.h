@@ -0,0 +1,44 @@
+#pragma once
+#include "LoomNetworkUtility.h"
+
+/**
+ * Which kinds of device a Network build can run as.
+ * Network and BasicMAC take one of these as a template parameter, and the code a role never
+ * runs is left out: end devices and routers never send refreshes, coordinators never listen
+ * for them, and end devices never forward a packet. AnyRole builds everything, and runs as
+ * whatever the configuration says, like before.
+ * The configuration is usually read at runtime, so a Network checks it against its role when
+ * it's built and closes with Error::ROLE_MISMATCH if they don't match. A configuration known at
+ * compile time can be checked with static_assert and allows.
+ */
+
+namespace LoomNet {
+	struct AnyRole {
+		static constexpr bool sends_refresh = true;
+		static constexpr bool follows_refresh = true;
+		static constexpr bool forwards = true;
+		static constexpr bool allows(const DeviceType) { return true; }
+	};
+
+	struct EndDeviceRole {
+		static constexpr bool sends_refresh = false;
+		static constexpr bool follows_refresh = true;
+		// an end device only hears its parent, and everything it sends goes back up
+		static constexpr bool forwards = false;
+		static constexpr bool allows(const DeviceType type) { return type == DeviceType::END_DEVICE; }
+	};
+
+	struct RouterRole {
+		static constexpr bool sends_refresh = false;
+		static constexpr bool follows_refresh = true;
+		static constexpr bool forwards = true;
+		static constexpr bool allows(const DeviceType type) { return type == DeviceType::FIRST_ROUTER || type == DeviceType::SECOND_ROUTER; }
+	};
+
+	struct CoordinatorRole {
+		static constexpr bool sends_refresh = true;
+		static constexpr bool follows_refresh = false;
+		static constexpr bool forwards = true;
+		static constexpr bool allows(const DeviceType type) { return type == DeviceType::COORDINATOR; }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "LoomNetworkState.h"
+#include "FastCRC.h"
+
+using namespace LoomNet;
+
+static void m_write_u64(uint8_t* buf, const uint64_t value) {
+	for (uint8_t i = 0; i < 8; i++) buf[i] = static_cast<uint8_t>(value >> (i * 8));
+}
+
+static uint64_t m_read_u64(const uint8_t* buf) {
+	uint64_t value = 0;
+	for (uint8_t i = 0; i < 8; i++) value |= static_cast<uint64_t>(buf[i]) << (i * 8);
+	return value;
+}
+
+bool LoomNet::MemoryStateStore::write(const uint8_t* src, const uint8_t length) {
+	if (length > sizeof(m_state)) return false;
+	for (uint8_t i = 0; i < length; i++) m_state[i] = src[i];
+	m_length = length;
+	return true;
+}
+
+bool LoomNet::MemoryStateStore::read(uint8_t* dst, const uint8_t length) {
+	if (length > m_length) return false;
+	for (uint8_t i = 0; i < length; i++) dst[i] = m_state[i];
+	return true;
+}
+
+bool LoomNet::write_network_state(StateStore& store, const NetworkState& state) {
+	using Field = StateStore::Field;
+	uint8_t buf[Field::STATE_SIZE];
+	buf[Field::MAGIC] = STATE_MAGIC[0];
+	buf[Field::MAGIC + 1] = STATE_MAGIC[1];
+	buf[Field::VERSION] = STATE_VERSION;
+	buf[Field::ADDRESS] = static_cast<uint8_t>(state.address & 0xFF);
+	buf[Field::ADDRESS + 1] = static_cast<uint8_t>(state.address >> 8);
+	buf[Field::TOTAL_SLOTS] = state.total_slots;
+	buf[Field::CYCLES] = state.cycles_per_batch;
+	buf[Field::CYCLE_GAP] = state.cycle_gap;
+	buf[Field::BATCH_GAP] = state.batch_gap;
+	buf[Field::ROLLING_ID] = state.rolling_id;
+	m_write_u64(&buf[Field::NEXT_REFRESH], state.next_refresh.get_ticks());
+	m_write_u64(&buf[Field::REFRESH_PERIOD], state.refresh_period.get_ticks());
+	const uint16_t crc = FastCRC16().xmodem(buf, Field::CRC);
+	buf[Field::CRC] = static_cast<uint8_t>(crc & 0xFF);
+	buf[Field::CRC + 1] = static_cast<uint8_t>(crc >> 8);
+	return store.write(buf, sizeof(buf));
+}
+
+bool LoomNet::read_network_state(StateStore& store, NetworkState& state) {
+	using Field = StateStore::Field;
+	uint8_t buf[Field::STATE_SIZE];
+	if (!store.read(buf, sizeof(buf))
+		|| buf[Field::MAGIC] != STATE_MAGIC[0]
+		|| buf[Field::MAGIC + 1] != STATE_MAGIC[1]
+		|| buf[Field::VERSION] != STATE_VERSION) return false;
+	// a write cut short by the power going out won't match
+	const uint16_t crc = FastCRC16().xmodem(buf, Field::CRC);
+	if (buf[Field::CRC] != (crc & 0xFF) || buf[Field::CRC + 1] != (crc >> 8)) return false;
+	state = {
+		static_cast<uint16_t>(buf[Field::ADDRESS] | buf[Field::ADDRESS + 1] << 8),
+		buf[Field::TOTAL_SLOTS],
+		buf[Field::CYCLES],
+		buf[Field::CYCLE_GAP],
+		buf[Field::BATCH_GAP],
+		buf[Field::ROLLING_ID],
+		TimeTicks(m_read_u64(&buf[Field::NEXT_REFRESH])),
+		TimeTicks(m_read_u64(&buf[Field::REFRESH_PERIOD]))
+	};
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+#include <stdint.h>
+#include "LoomNetworkTime.h"
+
+/**
+ * Timing kept across a hard power down, so a device can sleep straight until the next refresh
+ * instead of listening for a whole batch. Saved with Network::save_state after a refresh, and
+ * given to Network::restore_state on boot, before the first net_update.
+ * The saved times are on the radio's clock, so they only help if it keeps counting while the power
+ * is off, like an RTC. Neither LoraRadio nor WireRadio does, and a state saved before their clock
+ * started over is refused, so the device listens for the network as on first power on.
+ * All values are little endian, see StateStore::Field, followed by a CRC-16/XMODEM of everything before it
+ */
+
+namespace LoomNet {
+	constexpr uint8_t STATE_VERSION = 1;
+
+	constexpr uint8_t STATE_MAGIC[2] = { 'L', 'S' };
+
+	/** What a device needs to rejoin without listening */
+	struct NetworkState {
+		// checked against the configuration, in case it changed while the device was off
+		uint16_t address;
+		uint8_t total_slots;
+		// the batch the coordinator last announced, which may have been tuned
+		uint8_t cycles_per_batch;
+		uint8_t cycle_gap;
+		uint8_t batch_gap;
+		// so our parent doesn't drop our next packets as repeats
+		uint8_t rolling_id;
+		TimeTicks next_refresh;
+		TimeTicks refresh_period;
+	};
+
+	/** Where the state is kept, implement this for flash, FRAM or a file */
+	class StateStore {
+	public:
+		enum Field : uint8_t {
+			MAGIC = 0,
+			VERSION = 2,
+			ADDRESS = 3,
+			TOTAL_SLOTS = 5,
+			CYCLES = 6,
+			CYCLE_GAP = 7,
+			BATCH_GAP = 8,
+			ROLLING_ID = 9,
+			// ticks are eight bytes
+			NEXT_REFRESH = 10,
+			REFRESH_PERIOD = 18,
+			CRC = 26,
+			STATE_SIZE = 28
+		};
+
+		// replace the stored state with length bytes of src, false if it couldn't be written
+		virtual bool write(const uint8_t* src, const uint8_t length) = 0;
+		// copy length bytes of the stored state into dst, false if there is nothing stored
+		virtual bool read(uint8_t* dst, const uint8_t length) = 0;
+		virtual ~StateStore() = default;
+	};
+
+	/** State kept in RAM, for testing or memory that survives a reset */
+	class MemoryStateStore : public StateStore {
+	public:
+		MemoryStateStore()
+			: m_state{}
+			, m_length(0) {}
+
+		bool write(const uint8_t* src, const uint8_t length) override;
+		bool read(uint8_t* dst, const uint8_t length) override;
+
+	private:
+		uint8_t m_state[Field::STATE_SIZE];
+		uint8_t m_length;
+	};
+
+	bool write_network_state(StateStore& store, const NetworkState& state);
+	// false if nothing valid is stored
+	bool read_network_state(StateStore& store, NetworkState& state);
+}
\ No newline at end of file
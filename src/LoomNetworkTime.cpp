@@ -2,6 +2,9 @@
 
 using namespace LoomNet;
 
+constexpr uint64_t TimeTicks::MAX;
+constexpr uint64_t TimeTicks::NONE;
+
 const TimeInterval TimeInterval::operator+(const TimeInterval& rhs) const {
 	const TwoTimes& times = m_match_time(rhs);
 	if (times[0].get_unit() == Unit::NONE || times[1].get_unit() == Unit::NONE) return TimeInterval{ Unit::NONE, 0 };
@@ -93,4 +96,16 @@ TimeInterval TimeInterval::m_match_unit(const TimeInterval& smaller_unit, const
 		if (time_index > UINT32_MAX) return { Unit::NONE, 0 };
 	}
 	return { unit_index, static_cast<uint32_t>(time_index) };
+}
+
+TimeInterval TimeTicks::to_interval() const {
+	if (is_none()) return TIME_NONE;
+	uint8_t unit = TimeInterval::MICROSECOND;
+	uint64_t time = m_ticks;
+	while (time > UINT32_MAX) {
+		if (unit == TimeInterval::DAY) return TIME_NONE;
+		unit++;
+		time = m_ticks / per_unit(static_cast<TimeInterval::Unit>(unit));
+	}
+	return { unit, static_cast<uint32_t>(time) };
 }
\ No newline at end of file
@@ -30,11 +30,11 @@ namespace LoomNet {
 
 		using TwoTimes = TwoThings<TimeInterval>;
 
-		TimeInterval(const Unit unit, const uint32_t time)
+		constexpr TimeInterval(const Unit unit, const uint32_t time)
 			: m_unit(unit)
 			, m_time(time) {}
 
-		TimeInterval(const uint8_t unit, const uint32_t time)
+		constexpr TimeInterval(const uint8_t unit, const uint32_t time)
 			: TimeInterval(static_cast<Unit>(unit), time) {}
 
 		TimeInterval(const TimeInterval&) = default;
@@ -78,9 +78,9 @@ namespace LoomNet {
 			return times[0].get_time() >= times[1].get_time();
 		}
 
-		Unit get_unit() const { return m_unit; }
-		uint32_t get_time() const { return m_time; }
-		bool is_none() const { return m_unit == Unit::NONE; }
+		constexpr Unit get_unit() const { return m_unit; }
+		constexpr uint32_t get_time() const { return m_time; }
+		constexpr bool is_none() const { return m_unit == Unit::NONE; }
 
 		void downcast(const uint32_t type_max);
 
@@ -93,5 +93,102 @@ namespace LoomNet {
 		uint32_t m_time;
 	};
 
-	const TimeInterval TIME_NONE(TimeInterval::NONE, 0);
+	constexpr TimeInterval TIME_NONE(TimeInterval::NONE, 0);
+
+	/**
+	 * A monotonic count of microsecond ticks, for the timing math in the MAC
+	 * adding and multiplying saturate at MAX, and subtracting saturates at zero,
+	 * instead of failing. NONE is carried through every operation, like TIME_NONE
+	 * 64 bits of microseconds never roll over, use TickCounter to extend a smaller clock
+	 */
+	class TimeTicks {
+	public:
+		static constexpr uint64_t MAX = UINT64_MAX - 1;
+		static constexpr uint64_t NONE = UINT64_MAX;
+
+		// microseconds per unit, zero for TimeInterval::NONE
+		static constexpr uint64_t per_unit(const TimeInterval::Unit unit) {
+			return unit == TimeInterval::MICROSECOND ? 1ULL
+				: unit == TimeInterval::MILLISECOND ? 1000ULL
+				: unit == TimeInterval::SECOND ? 1000000ULL
+				: unit == TimeInterval::MINUTE ? 60000000ULL
+				: unit == TimeInterval::HOUR ? 3600000000ULL
+				: unit == TimeInterval::DAY ? 86400000000ULL
+				: 0ULL;
+		}
+
+		constexpr TimeTicks()
+			: m_ticks(NONE) {}
+
+		constexpr explicit TimeTicks(const uint64_t ticks)
+			: m_ticks(ticks) {}
+
+		constexpr TimeTicks(const TimeInterval::Unit unit, const uint32_t time)
+			: m_ticks(per_unit(unit) == 0 ? NONE : m_sat_mul(per_unit(unit), time)) {}
+
+		constexpr TimeTicks(const TimeInterval& interval)
+			: TimeTicks(interval.get_unit(), interval.get_time()) {}
+
+		constexpr TimeTicks operator+(const TimeTicks& rhs) const {
+			return is_none() || rhs.is_none() ? TimeTicks()
+				: TimeTicks(rhs.m_ticks > MAX - m_ticks ? MAX : m_ticks + rhs.m_ticks);
+		}
+
+		// zero if rhs is later than us
+		constexpr TimeTicks operator-(const TimeTicks& rhs) const {
+			return is_none() || rhs.is_none() ? TimeTicks()
+				: TimeTicks(m_ticks > rhs.m_ticks ? m_ticks - rhs.m_ticks : 0);
+		}
+
+		constexpr TimeTicks operator*(const uint32_t num) const {
+			return is_none() ? TimeTicks() : TimeTicks(m_sat_mul(m_ticks, num));
+		}
+
+		constexpr bool operator==(const TimeTicks& rhs) const { return m_ticks == rhs.m_ticks; }
+		constexpr bool operator!=(const TimeTicks& rhs) const { return m_ticks != rhs.m_ticks; }
+		// comparing with NONE is always false, like TimeInterval
+		constexpr bool operator<(const TimeTicks& rhs) const { return !is_none() && !rhs.is_none() && m_ticks < rhs.m_ticks; }
+		constexpr bool operator>(const TimeTicks& rhs) const { return !is_none() && !rhs.is_none() && m_ticks > rhs.m_ticks; }
+		constexpr bool operator<=(const TimeTicks& rhs) const { return !is_none() && !rhs.is_none() && m_ticks <= rhs.m_ticks; }
+		constexpr bool operator>=(const TimeTicks& rhs) const { return !is_none() && !rhs.is_none() && m_ticks >= rhs.m_ticks; }
+
+		constexpr uint64_t get_ticks() const { return m_ticks; }
+		constexpr bool is_none() const { return m_ticks == NONE; }
+
+		// the smallest unit that fits in 32 bits, rounded down
+		TimeInterval to_interval() const;
+
+	private:
+		static constexpr uint64_t m_sat_mul(const uint64_t ticks, const uint64_t num) {
+			return num != 0 && ticks > MAX / num ? MAX : ticks * num;
+		}
+
+		uint64_t m_ticks;
+	};
+
+	constexpr TimeTicks TICKS_NONE{};
+
+	/**
+	 * Extends a free running 32 bit counter (like millis()) into TimeTicks,
+	 * so time keeps going forward when the counter rolls over
+	 * must be read at least once per rollover
+	 */
+	class TickCounter {
+	public:
+		explicit TickCounter(const TimeInterval::Unit unit)
+			: m_per_count(TimeTicks::per_unit(unit))
+			, m_last(0)
+			, m_rollovers(0) {}
+
+		TimeTicks update(const uint32_t count) {
+			if (count < m_last) m_rollovers++;
+			m_last = count;
+			return TimeTicks(((static_cast<uint64_t>(m_rollovers) << 32) | count) * m_per_count);
+		}
+
+	private:
+		uint64_t m_per_count;
+		uint32_t m_last;
+		uint32_t m_rollovers;
+	};
 }
\ No newline at end of file
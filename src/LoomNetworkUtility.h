@@ -28,7 +28,7 @@ namespace LoomNet {
 		NONE = 0
 	};
 
-	enum class DeviceType {
+	enum class DeviceType : uint8_t {
 		END_DEVICE,
 		COORDINATOR,
 		FIRST_ROUTER,
@@ -0,0 +1,102 @@
+#pragma once
+#include "CircularBuffer.h"
+#include "LoomNetworkPacket.h"
+
+/**
+ * A fixed set of packets that Network hands around by index instead of by value
+ * A packet is copied into a slot once, when it comes off the MAC or the application sends it,
+ * and after that only its handle moves: from the recieve buffer to the application, or into the
+ * send queue when it's forwarded. Handles are a byte for pools of fewer than 255 packets.
+ */
+
+namespace LoomNet {
+	template<size_t max_size>
+	class PacketPool {
+	public:
+		using Handle = typename buffer_index<max_size + 1>::type;
+		// what alloc gives when every slot is taken
+		static constexpr Handle NONE = max_size;
+
+		PacketPool()
+			: m_slots{} { m_free_all(); }
+
+		// the slots in use hold a packet to copy, the free ones only bytes, so a copy snapshots the same
+		PacketPool(const PacketPool& rhs)
+			: m_slots{}
+			, m_free(rhs.m_free)
+			, m_available(rhs.m_available) {
+			for (size_t i = 0; i < max_size; i++) m_next[i] = rhs.m_next[i];
+			bool used[max_size];
+			rhs.m_mark_used(used);
+			for (size_t i = 0; i < max_size; i++) {
+				if (used[i]) new(&m_slots[i]) Packet(rhs[static_cast<Handle>(i)]);
+				else m_slots[i] = rhs.m_slots[i];
+			}
+		}
+
+		PacketPool& operator=(const PacketPool&) = delete;
+
+		~PacketPool() { m_destroy_used(); }
+
+		// a free slot with a copy of packet in it
+		Handle alloc(const Packet& packet) {
+			if (m_free == NONE) return NONE;
+			const Handle handle = m_free;
+			m_free = m_next[handle];
+			m_available--;
+			new(&m_slots[handle]) Packet(packet);
+			return handle;
+		}
+		void release(const Handle handle) {
+			(*this)[handle].~Packet();
+			m_next[handle] = m_free;
+			m_free = handle;
+			m_available++;
+		}
+		size_t available() const { return m_available; }
+		void reset() {
+			m_destroy_used();
+			m_free_all();
+		}
+
+		Packet& operator[](const Handle handle) { return *reinterpret_cast<Packet*>(&m_slots[handle]); }
+		const Packet& operator[](const Handle handle) const { return *reinterpret_cast<const Packet*>(&m_slots[handle]); }
+
+		template<class Archive>
+		void snapshot(Archive& archive) {
+			archive(m_slots);
+			archive(m_next);
+			archive(m_free);
+			archive(m_available);
+		}
+
+	private:
+		// the slots in use are the ones not on the free list
+		void m_mark_used(bool* used) const {
+			for (size_t i = 0; i < max_size; i++) used[i] = true;
+			for (Handle h = m_free; h != NONE; h = m_next[h]) used[h] = false;
+		}
+		void m_free_all() {
+			for (size_t i = 0; i < max_size; i++) m_next[i] = static_cast<Handle>(i + 1);
+			m_free = 0;
+			m_available = max_size;
+		}
+		void m_destroy_used() {
+			bool used[max_size];
+			m_mark_used(used);
+			for (size_t i = 0; i < max_size; i++)
+				if (used[i]) (*this)[static_cast<Handle>(i)].~Packet();
+		}
+
+		using slot_t = typename aligned_storage<sizeof(Packet), alignof(Packet)>::type;
+
+		slot_t m_slots[max_size];
+		// the free slots, each giving the next one
+		Handle m_next[max_size];
+		Handle m_free;
+		Handle m_available;
+	};
+
+	template<size_t max_size>
+	constexpr typename PacketPool<max_size>::Handle PacketPool<max_size>::NONE;
+}
\ No newline at end of file
@@ -3,13 +3,18 @@
 #include "LoomNetworkPacket.h"
 #include "LoomNetworkUtility.h"
 
-/** 
+/**
  * An interface specifying a generic radio driver for Loom network
+ *
+ * A driver derives from RadioBase and has every function in Radio below, but not virtual:
+ * Network and BasicMAC are templated on the driver, so every call goes straight to it and
+ * can be inlined. Radio is the same interface with everything virtual, for code that has
+ * to pick its radio at runtime, and RadioAdapter puts any driver behind it.
  */
 
 namespace LoomNet {
 
-	class Radio {
+	class RadioBase {
 	public:
 		enum class State {
 			DISABLED,
@@ -18,8 +23,15 @@ namespace LoomNet {
 			ERROR,
 		};
 
+		// drivers that can check for channel activity hide this with their own, see Radio
+		TimeTicks get_sample_interval() const { return TICKS_NONE; }
+	};
+
+	class Radio : public RadioBase {
+	public:
 		// the radio needs to keep time, as does the rest of the network
-		virtual TimeInterval get_time() const = 0;
+		// this time must only go forward, use TickCounter to extend a counter that rolls over
+		virtual TimeTicks get_time() const = 0;
 		// get the radio state
 		virtual State get_state() const = 0;
 		// initialize and configure the radio
@@ -38,8 +50,34 @@ namespace LoomNet {
 
 		// once the radio is woke, any of the below functions can be called
 		// all operations are atomic and simply delay until they are complete
-		virtual Packet recv(TimeInterval& recv_stamp) = 0;
+		virtual Packet recv(TimeTicks& recv_stamp) = 0;
 		virtual void send(const Packet& send) = 0;
+
+		// the longest the radio can sleep between calls to recv without missing a packet, used to save power
+		// while looking for the network. Radios that check for channel activity can use the preamble time,
+		// the rest must listen the whole time
+		virtual TimeTicks get_sample_interval() const { return TICKS_NONE; }
+	};
+
+	// a driver behind the virtual interface, for a MAC that has to pick its radio at runtime
+	template<class RadioImpl>
+	class RadioAdapter final : public Radio {
+	public:
+		explicit RadioAdapter(RadioImpl& radio)
+			: m_radio(radio) {}
+
+		TimeTicks get_time() const override { return m_radio.get_time(); }
+		State get_state() const override { return m_radio.get_state(); }
+		void enable() override { m_radio.enable(); }
+		void disable() override { m_radio.disable(); }
+		void sleep() override { m_radio.sleep(); }
+		void wake() override { m_radio.wake(); }
+		Packet recv(TimeTicks& recv_stamp) override { return m_radio.recv(recv_stamp); }
+		void send(const Packet& send) override { m_radio.send(send); }
+		TimeTicks get_sample_interval() const override { return m_radio.get_sample_interval(); }
+
+	private:
+		RadioImpl& m_radio;
 	};
 
 };
\ No newline at end of file
@@ -1,12 +1,5 @@
 #include "LoomRouter.h"
 
-LoomNet::Router::Router(const DeviceType dev_type, const uint16_t self_addr, const uint16_t addr_parent, const uint8_t router_count, const uint8_t node_count)
-	: m_dev_type(dev_type)
-	, m_self_addr(self_addr)
-	, m_addr_parent(addr_parent)
-	, m_node_child_count(node_count)
-	, m_router_child_count(router_count) {}
-
 // NOTE: it is presumed this function will never route to itself, and does not check if the address returned
 // it actually present in the network
 
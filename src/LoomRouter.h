@@ -10,13 +10,18 @@
 namespace LoomNet {
 	class Router {
 	public:
-		Router(const DeviceType dev_type, const uint16_t self_addr, const uint16_t addr_parent, const uint8_t router_count, const uint8_t node_count);
-
-		DeviceType get_device_type() const { return m_dev_type; }
-		uint16_t get_self_addr() const { return m_self_addr; }
-		uint16_t get_addr_parent() const { return m_addr_parent; }
-		uint8_t get_router_count() const { return m_router_child_count; }
-		uint8_t get_node_count() const { return m_node_child_count; }
+		constexpr Router(const DeviceType dev_type, const uint16_t self_addr, const uint16_t addr_parent, const uint8_t router_count, const uint8_t node_count)
+			: m_dev_type(dev_type)
+			, m_self_addr(self_addr)
+			, m_addr_parent(addr_parent)
+			, m_node_child_count(node_count)
+			, m_router_child_count(router_count) {}
+
+		constexpr DeviceType get_device_type() const { return m_dev_type; }
+		constexpr uint16_t get_self_addr() const { return m_self_addr; }
+		constexpr uint16_t get_addr_parent() const { return m_addr_parent; }
+		constexpr uint8_t get_router_count() const { return m_router_child_count; }
+		constexpr uint8_t get_node_count() const { return m_node_child_count; }
 
 		bool operator==(const Router& rhs) const {
 			return (rhs.get_addr_parent() == get_addr_parent())
@@ -54,5 +59,5 @@ namespace LoomNet {
 		const uint8_t m_router_child_count;
 	};
 
-	const Router ROUTER_ERROR = Router(DeviceType::ERROR, ADDR_ERROR, ADDR_ERROR, 0, 0);
+	constexpr Router ROUTER_ERROR = Router(DeviceType::ERROR, ADDR_ERROR, ADDR_ERROR, 0, 0);
 }
@@ -2,19 +2,6 @@
 
 using namespace LoomNet;
 
-Slotter::Slotter(const uint8_t send_slot, const uint8_t total_slots, const uint8_t cycles_per_refresh, const uint8_t cycle_gap, const uint8_t batch_gap, const uint8_t send_count, const uint8_t recv_slot, const uint8_t recv_count)
-	: m_send_slot(send_slot)
-	, m_send_count(send_count)
-	, m_recv_slot(recv_slot)
-	, m_recv_count(recv_count)
-	, m_total_slots(total_slots)
-	, m_cycles_per_refresh(cycles_per_refresh)
-	, m_cycle_gap(cycle_gap)
-	, m_batch_gap(batch_gap)
-	, m_state(send_slot != SLOT_ERROR && recv_slot != SLOT_ERROR ? State::SLOT_WAIT_REFRESH : State::SLOT_ERROR)
-	, m_cur_cycle(0)
-	, m_cur_device(0) {}
-
 Slotter::State Slotter::next_state() {
 	// if we were waiting for a refresh, we wait for children next
 	// if we don't have any children then parent
@@ -112,3 +99,16 @@ void LoomNet::Slotter::reset() {
 	m_cur_cycle = 0;
 	m_cur_device = 0;
 }
+
+bool LoomNet::Slotter::set_batch_params(const uint8_t cycles_per_refresh, const uint8_t cycle_gap, const uint8_t batch_gap) {
+	// the sync states only happen right after a refresh, so no data cycle has used the old values yet
+	if (m_state != State::SLOT_WAIT_REFRESH
+		&& m_state != State::SLOT_RECV_W_SYNC
+		&& m_state != State::SLOT_SEND_W_SYNC) return false;
+	// same limits as the configuration
+	if (cycles_per_refresh < 2 || !cycle_gap) return false;
+	m_cycles_per_refresh = cycles_per_refresh;
+	m_cycle_gap = cycle_gap;
+	m_batch_gap = batch_gap;
+	return true;
+}
\ No newline at end of file
@@ -11,7 +11,7 @@ namespace LoomNet {
 	
 	class Slotter {
 	public:
-		enum class State {
+		enum class State : uint8_t {
 			SLOT_SEND,
 			SLOT_SEND_W_SYNC,
 			SLOT_RECV,
@@ -20,16 +20,27 @@ namespace LoomNet {
 			SLOT_ERROR
 		};
 
-		Slotter(	const uint8_t		send_slot, 
-					const uint8_t		total_slots,
-					const uint8_t		cycles_per_refresh,
-					const uint8_t		cycle_gap,
-					const uint8_t		batch_gap,
-					const uint8_t		send_count,
-					const uint8_t		recv_slot, 
-					const uint8_t		recv_count);
+		constexpr Slotter(	const uint8_t		send_slot, 
+							const uint8_t		total_slots,
+							const uint8_t		cycles_per_refresh,
+							const uint8_t		cycle_gap,
+							const uint8_t		batch_gap,
+							const uint8_t		send_count,
+							const uint8_t		recv_slot, 
+							const uint8_t		recv_count)
+			: m_send_slot(send_slot)
+			, m_send_count(send_count)
+			, m_recv_slot(recv_slot)
+			, m_recv_count(recv_count)
+			, m_total_slots(total_slots)
+			, m_cycles_per_refresh(cycles_per_refresh)
+			, m_cycle_gap(cycle_gap)
+			, m_batch_gap(batch_gap)
+			, m_state(send_slot != SLOT_ERROR && recv_slot != SLOT_ERROR ? State::SLOT_WAIT_REFRESH : State::SLOT_ERROR)
+			, m_cur_cycle(0)
+			, m_cur_device(0) {}
 		
-		Slotter(const uint8_t send_slot, const uint8_t total_slots, const uint8_t cycles_per_refresh, const uint8_t cycle_gap, const uint8_t batch_gap)
+		constexpr Slotter(const uint8_t send_slot, const uint8_t total_slots, const uint8_t cycles_per_refresh, const uint8_t cycle_gap, const uint8_t batch_gap)
 			: Slotter(send_slot, total_slots, cycles_per_refresh, cycle_gap, batch_gap, 1, SLOT_NONE, 0) {}
 
 		bool operator==(const Slotter& rhs) const {
@@ -48,13 +59,28 @@ namespace LoomNet {
 		uint8_t get_slot_wait() const;
 		uint16_t get_slots_per_refresh() const;
 		void reset();
+		// change the batch schedule, only allowed before the first data cycle of a batch
+		bool set_batch_params(const uint8_t cycles_per_refresh, const uint8_t cycle_gap, const uint8_t batch_gap);
+		// everything that changes while running, see Network::snapshot
+		template<class Archive>
+		void snapshot(Archive& archive) {
+			archive(m_cycles_per_refresh);
+			archive(m_cycle_gap);
+			archive(m_batch_gap);
+			archive(m_state);
+			archive(m_cur_cycle);
+			archive(m_cur_device);
+		}
 
-		uint8_t get_send_slot() const { return m_send_slot; }
-		uint8_t get_recv_slot() const { return m_recv_slot; }
-		uint8_t get_recv_count() const { return m_recv_count; }
-		uint8_t get_cur_data_cycle() const { return m_cur_cycle; }
-		uint8_t get_total_slots() const { return m_state == State::SLOT_ERROR ? SLOT_ERROR : m_total_slots; }
-		uint8_t get_cycles_per_refresh() const { return m_cycles_per_refresh; }
+		constexpr uint8_t get_send_slot() const { return m_send_slot; }
+		constexpr uint8_t get_send_count() const { return m_send_count; }
+		constexpr uint8_t get_recv_slot() const { return m_recv_slot; }
+		constexpr uint8_t get_recv_count() const { return m_recv_count; }
+		constexpr uint8_t get_cur_data_cycle() const { return m_cur_cycle; }
+		constexpr uint8_t get_total_slots() const { return m_state == State::SLOT_ERROR ? SLOT_ERROR : m_total_slots; }
+		constexpr uint8_t get_cycles_per_refresh() const { return m_cycles_per_refresh; }
+		constexpr uint8_t get_cycle_gap() const { return m_cycle_gap; }
+		constexpr uint8_t get_batch_gap() const { return m_batch_gap; }
 
 	private:
 
@@ -63,13 +89,13 @@ namespace LoomNet {
 		const uint8_t m_recv_slot;
 		const uint8_t m_recv_count;
 		const uint8_t m_total_slots;
-		const uint8_t m_cycles_per_refresh;
-		const uint8_t m_cycle_gap;
-		const uint8_t m_batch_gap;
+		uint8_t m_cycles_per_refresh;
+		uint8_t m_cycle_gap;
+		uint8_t m_batch_gap;
 		State m_state;
 		uint8_t m_cur_cycle;
 		uint8_t m_cur_device;
 	};
 
-	const Slotter SLOTTER_ERROR = Slotter(SLOT_ERROR, 0, 0, 0, 0, 0, SLOT_ERROR, 0);
+	constexpr Slotter SLOTTER_ERROR = Slotter(SLOT_ERROR, 0, 0, 0, 0, 0, SLOT_ERROR, 0);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "Arduino.h"
 #include "../LoomRadio.h"
+#include "../LoomAirtime.h"
 #include <SPI.h>
 #include "RF95.h"
 
@@ -15,8 +16,17 @@ constexpr auto LED = 13;
 
 constexpr auto SMALL_RECV_TIMEOUT = 200;
 
+// modem setup, also used to work out the time on air for the network configuration
+constexpr RF95::ModemConfig LORA_MODEM_CONFIG = { 
+    0b10010010, // explicit header on, 4/5 coding rate, 500kHz
+    0b10100000, // 1024 chirps/symbol, tx continous off, CRC off, 0 symbol timeout MSBs
+    0x04, // AGC on
+};
+// a little longer than the default of 8
+constexpr uint16_t LORA_PREAMBLE = 12;
+
 namespace LoomNet {
-    class LoraRadio : public Radio {
+    class LoraRadio : public RadioBase {
     public:
 
         LoraRadio(const uint8_t send_indicator_pin, 
@@ -26,14 +36,23 @@ namespace LoomNet {
             , m_recv_ind(recv_indicator_pin)
             , m_pwr_ind(pwr_indicator_pin) 
             , m_state(State::DISABLED)
-            , m_rfm(RFM95_CS, RFM95_INT) {}
+            , m_rfm(RFM95_CS, RFM95_INT)
+            , m_clock(TimeInterval::Unit::MILLISECOND) {}
 
-        TimeInterval get_time() const override { 
+        TimeTicks get_time() const { 
             // get time using the internal RTC counter!
-            return TimeInterval(TimeInterval::Unit::MILLISECOND, millis());
+            return m_clock.update(millis());
+        }
+        State get_state() const { return m_state; }
+        // recv starts with a CAD check, so it only has to land in the preamble
+        TimeTicks get_sample_interval() const {
+            const uint32_t interval = get_airtime().get_sample_interval();
+            return interval ? TimeTicks(TimeInterval::MICROSECOND, interval) : TICKS_NONE;
+        }
+        static LoraAirtime get_airtime() {
+            return LoraAirtime(LORA_MODEM_CONFIG.reg_1d, LORA_MODEM_CONFIG.reg_1e, LORA_MODEM_CONFIG.reg_26, LORA_PREAMBLE);
         }
-        State get_state() const override { return m_state; }
-        void enable() override {
+        void enable() {
             if (m_state != State::DISABLED) 
                 Serial.println("Invalid radio state movement in enable()");
             m_state = State::SLEEP;
@@ -51,14 +70,8 @@ namespace LoomNet {
                 while(1);
             }
             m_rfm.setTxPower(13);
-            constexpr RF95::ModemConfig config = { 
-                0b10010010, // explicit header on, 4/5 coding rate, 500kHz
-                0b10100000, // 1024 chirps/symbol, tx continous off, CRC off, 0 symbol timeout MSBs
-                0x04, // AGC on
-            };
-            m_rfm.setModemRegisters(config);
-            // tweak the preamble so it's a little longer (default is 8)
-            m_rfm.setPreambleLength(12);
+            m_rfm.setModemRegisters(LORA_MODEM_CONFIG);
+            m_rfm.setPreambleLength(LORA_PREAMBLE);
             // put the modem into sleep mode until we need it later
             m_rfm.setMode(RF95::RF_MODE::SLEEP);
             /*
@@ -84,12 +97,12 @@ namespace LoomNet {
             while (RTC->MODE0.STATUS.bit.SYNCBUSY);
             */
         }
-        void disable() override {
+        void disable() {
             if (m_state != State::SLEEP) 
                 Serial.println("Invalid radio state movement in disable()");
             m_state = State::DISABLED;
         }
-        void sleep() override {
+        void sleep() {
             if (m_state != State::IDLE) 
                 Serial.println("Invalid radio state movement in sleep()");
             m_state = State::SLEEP;
@@ -98,7 +111,7 @@ namespace LoomNet {
             // turn power indicator off
             digitalWrite(m_pwr_ind, LOW);
         }
-        void wake() override {
+        void wake() {
             if (m_state != State::SLEEP) 
                 Serial.println("Invalid radio state movement in wake()");
             m_state = State::IDLE;
@@ -108,8 +121,9 @@ namespace LoomNet {
             // turn power indicator on
             digitalWrite(m_pwr_ind, HIGH);
         }
-        LoomNet::Packet recv(TimeInterval& recv_stamp) override {
-            uint8_t buf[PACKET_MAX] = {};
+        LoomNet::Packet recv(TimeTicks& recv_stamp) {
+            // the frame is read straight into the packet we return, which starts out empty
+            LoomNet::Packet packet(PacketCtrl::NONE, ADDR_NONE);
             if (m_state != State::IDLE) 
                 Serial.println("Invalid radio state to recv");
             // turn recv indicator on
@@ -119,15 +133,15 @@ namespace LoomNet {
             if(m_rfm.checkRadio()) {
                 // const auto time = millis();
                 // we found a packet! recieve it
-                m_rfm.recvSingle(buf, PACKET_MAX);
+                m_rfm.recvSingle(packet.get_raw(), PACKET_MAX);
                 recv_stamp = cur_time;
             }
             // reset the indicator
             digitalWrite(m_recv_ind, LOW);
             // return data!
-            return LoomNet::Packet{ buf, static_cast<uint8_t>(sizeof(buf)) };
+            return packet;
         }
-        void send(const LoomNet::Packet& send) override {
+        void send(const LoomNet::Packet& send) {
             if (m_state != State::IDLE) 
                 Serial.println("Invalid radio state to recv");
             // turn on the indicator!
@@ -144,5 +158,6 @@ namespace LoomNet {
         const uint8_t m_pwr_ind;
         State m_state;
         RF95 m_rfm;
+        mutable TickCounter m_clock;
     };
 }
\ No newline at end of file
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "../LoomRadio.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * A radio for Linux hosts, so each device can run as its own process or thread.
+ * Every radio binds a unix datagram socket in a shared directory, and a send goes
+ * to every other socket in it. If LoomNetworkMedium is running in the directory,
+ * sends go through it instead, so it can add loss, latency and collisions.
+ */
+
+// how long recv waits for a frame before giving up, in real time, so polling doesn't spin
+constexpr auto SOCKET_RECV_WAIT_MICROS = 200;
+
+namespace LoomNet {
+    class SocketRadio : public RadioBase {
+    public:
+        static constexpr const char* MEDIUM_NAME = "medium";
+        static constexpr const char* NODE_SUFFIX = ".node";
+
+        // time_scale runs the network clock that many times faster than the wall clock
+        SocketRadio(const char* dir, const uint16_t id, const uint32_t time_scale = 1)
+            : m_id(id)
+            , m_time_scale(time_scale ? time_scale : 1)
+            , m_state(State::DISABLED)
+            , m_fd(-1)
+            , m_dir{}
+            , m_path{} {
+            snprintf(m_dir, sizeof(m_dir), "%s", dir);
+            snprintf(m_path, sizeof(m_path), "%s/%04X%s", dir, id, NODE_SUFFIX);
+        }
+
+        // the socket can only belong to one radio, so copies start disabled
+        SocketRadio(const SocketRadio& rhs)
+            : SocketRadio(rhs.m_dir, rhs.m_id, rhs.m_time_scale) {}
+
+        SocketRadio& operator=(const SocketRadio&) = delete;
+
+        ~SocketRadio() { m_close(); }
+
+        TimeTicks get_time() const {
+            // the monotonic clock is shared by every process on the host, so all devices agree
+            timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            return TimeTicks((static_cast<uint64_t>(now.tv_sec) * 1000000 + static_cast<uint64_t>(now.tv_nsec) / 1000) * m_time_scale);
+        }
+        State get_state() const { return m_state; }
+        void enable() {
+            if (m_state != State::DISABLED)
+                fprintf(stderr, "Invalid radio state movement in enable()\n");
+            m_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+            sockaddr_un addr;
+            if (m_fd < 0 || !m_make_addr(m_path, addr)) {
+                fprintf(stderr, "Could not create a socket for %s\n", m_path);
+                m_close();
+            }
+            else {
+                // a crashed process can leave its socket behind
+                unlink(m_path);
+                if (bind(m_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+                    fprintf(stderr, "Could not bind %s\n", m_path);
+                    m_close();
+                }
+            }
+            m_state = State::SLEEP;
+        }
+        void disable() {
+            if (m_state != State::SLEEP)
+                fprintf(stderr, "Invalid radio state movement in disable()\n");
+            m_close();
+            m_state = State::DISABLED;
+        }
+        void sleep() {
+            if (m_state != State::IDLE)
+                fprintf(stderr, "Invalid radio state movement in sleep()\n");
+            m_state = State::SLEEP;
+        }
+        void wake() {
+            if (m_state != State::SLEEP)
+                fprintf(stderr, "Invalid radio state movement in wake()\n");
+            // anything sent while we were asleep was never heard
+            if (m_fd >= 0) {
+                uint8_t buf[PACKET_MAX];
+                while (::recv(m_fd, buf, sizeof(buf), MSG_DONTWAIT) >= 0);
+            }
+            m_state = State::IDLE;
+        }
+        Packet recv(TimeTicks& recv_stamp) {
+            if (m_state != State::IDLE)
+                fprintf(stderr, "Invalid radio state to recv\n");
+            // the frame is read straight into the packet we return, which stays empty if nothing came
+            Packet packet(PacketCtrl::NONE, ADDR_NONE);
+            if (m_fd >= 0) m_wait_recv(packet.get_raw());
+            recv_stamp = get_time();
+            return packet;
+        }
+        void send(const Packet& send) {
+            if (m_state != State::IDLE)
+                fprintf(stderr, "Invalid radio state to send\n");
+            if (m_fd < 0) return;
+            // let the medium decide who hears it, if there is one
+            char path[sizeof(sockaddr_un::sun_path)];
+            const bool fits = snprintf(path, sizeof(path), "%s/%s", m_dir, MEDIUM_NAME) < static_cast<int>(sizeof(path));
+            struct stat medium;
+            if (fits && stat(path, &medium) == 0 && S_ISSOCK(medium.st_mode)) {
+                m_send_to(path, send);
+                return;
+            }
+            // else everyone else in the directory hears it
+            DIR* dir = opendir(m_dir);
+            if (!dir) return;
+            const size_t suffix = strlen(NODE_SUFFIX);
+            for (const dirent* entry = readdir(dir); entry; entry = readdir(dir)) {
+                const size_t length = strlen(entry->d_name);
+                if (length <= suffix || strcmp(entry->d_name + length - suffix, NODE_SUFFIX) != 0) continue;
+                if (snprintf(path, sizeof(path), "%s/%s", m_dir, entry->d_name) < static_cast<int>(sizeof(path))
+                    && strcmp(path, m_path) != 0) m_send_to(path, send);
+            }
+            closedir(dir);
+        }
+
+        const char* get_path() const { return m_path; }
+
+    private:
+        static bool m_make_addr(const char* path, sockaddr_un& addr) {
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            if (strlen(path) >= sizeof(addr.sun_path)) return false;
+            strcpy(addr.sun_path, path);
+            return true;
+        }
+
+        ssize_t m_wait_recv(uint8_t* buf) {
+            // give a frame a moment to show up before reporting an empty channel
+            pollfd wait = { m_fd, POLLIN, 0 };
+            const timespec timeout = { 0, SOCKET_RECV_WAIT_MICROS * 1000 };
+            if (ppoll(&wait, 1, &timeout, nullptr) <= 0) return -1;
+            return ::recv(m_fd, buf, PACKET_MAX, MSG_DONTWAIT);
+        }
+
+        void m_send_to(const char* path, const Packet& send) {
+            sockaddr_un addr;
+            // a device that just went away is the same as one out of range
+            if (m_make_addr(path, addr))
+                sendto(m_fd, send.get_raw(), send.get_packet_length(), MSG_DONTWAIT, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+        }
+
+        void m_close() {
+            if (m_fd < 0) return;
+            close(m_fd);
+            unlink(m_path);
+            m_fd = -1;
+        }
+
+        const uint16_t m_id;
+        const uint32_t m_time_scale;
+        State m_state;
+        int m_fd;
+        char m_dir[sizeof(sockaddr_un::sun_path)];
+        char m_path[sizeof(sockaddr_un::sun_path)];
+    };
+}
\ No newline at end of file
@@ -11,7 +11,7 @@ constexpr auto WIRE_RECV_TIMEOUT_MILLIS = 500 + SEND_DELAY_MILLIS;
 constexpr auto BIT_LENGTH = 400; // MUST BE DIVISIBLE BY 4
 
 namespace LoomNet {
-    class WireRadio : public Radio {
+    class WireRadio : public RadioBase {
     public:
 
         WireRadio(const uint8_t data_pin,
@@ -25,16 +25,17 @@ namespace LoomNet {
             , m_recv_ind(recv_indicator_pin)
             , m_pwr_ind(pwr_indicator_pin) 
             , m_state(State::DISABLED)
-            , m_buffer{} {}
+            , m_buffer{}
+            , m_clock(TimeInterval::Unit::MILLISECOND) {}
 
-        TimeInterval get_time() const override { 
+        TimeTicks get_time() const { 
             // get time using the internal RTC counter!
             RTC->MODE0.READREQ.reg = RTC_READREQ_RREQ;
             while (RTC->MODE0.STATUS.bit.SYNCBUSY);
-            return TimeInterval(TimeInterval::Unit::MILLISECOND, RTC->MODE0.COUNT.bit.COUNT);
+            return m_clock.update(RTC->MODE0.COUNT.bit.COUNT);
         }
-        State get_state() const override { return m_state; }
-        void enable() override {
+        State get_state() const { return m_state; }
+        void enable() {
             if (m_state != State::DISABLED) 
                 Serial.println("Invalid radio state movement in enable()");
             m_state = State::SLEEP;
@@ -68,26 +69,26 @@ namespace LoomNet {
             RTC->MODE0.CTRL.reg &= ~RTC_MODE0_CTRL_SWRST; // software reset remove
             while (RTC->MODE0.STATUS.bit.SYNCBUSY);
         }
-        void disable() override {
+        void disable() {
             if (m_state != State::SLEEP) 
                 Serial.println("Invalid radio state movement in disable()");
             m_state = State::DISABLED;
         }
-        void sleep() override {
+        void sleep() {
             if (m_state != State::IDLE) 
                 Serial.println("Invalid radio state movement in sleep()");
             m_state = State::SLEEP;
             // turn power indicator off
             digitalWrite(m_pwr_ind, LOW);
         }
-        void wake() override {
+        void wake() {
             if (m_state != State::SLEEP) 
                 Serial.println("Invalid radio state movement in wake()");
             m_state = State::IDLE;
             // turn power indicator on
             digitalWrite(m_pwr_ind, HIGH);
         }
-        LoomNet::Packet recv(TimeInterval& recv_stamp) override {
+        LoomNet::Packet recv(TimeTicks& recv_stamp) {
             if (m_state != State::IDLE) 
                 Serial.println("Invalid radio state to recv");
             // check start for synchronization measurement
@@ -105,7 +106,7 @@ namespace LoomNet {
             // if we found something, start recieving it
             if (found) {
                 // set the recv_stamp to when we first heard the signal
-                recv_stamp = get_time() - TimeInterval(TimeInterval::MILLISECOND, SEND_DELAY_MILLIS);
+                recv_stamp = get_time() - TimeTicks(TimeInterval::MILLISECOND, SEND_DELAY_MILLIS);
                 // read the "airwaves" 254 times!
                 bool timed_out = false;
                 bool last_state;
@@ -128,7 +129,7 @@ namespace LoomNet {
                     }
                 }
                 Serial.print("Off by: ");
-                Serial.println(sync_off.get_time());
+                Serial.println(static_cast<uint32_t>(sync_off.get_ticks() / 1000));
                 /*Serial.print("Got: ");
                 for (uint8_t i = 0; i < sizeof(m_buffer); i++) {
                     Serial.print("0x");
@@ -143,7 +144,7 @@ namespace LoomNet {
             // return data!
             return LoomNet::Packet{ m_buffer, static_cast<uint8_t>(sizeof(m_buffer)) };
         }
-        void send(const LoomNet::Packet& send) override {
+        void send(const LoomNet::Packet& send) {
             if (m_state != State::IDLE) 
                 Serial.println("Invalid radio state to recv");
             /*Serial.println("Transmitting: ");
@@ -195,6 +196,7 @@ namespace LoomNet {
         const uint8_t m_pwr_ind;
         State m_state;
         uint8_t m_buffer[LoomNet::PACKET_MAX];
+        mutable TickCounter m_clock;
         uint32_t m_cur_time;
     };
 }
\ No newline at end of file